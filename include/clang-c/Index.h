@@ -32,7 +32,7 @@
  * compatible, thus CINDEX_VERSION_MAJOR is expected to remain stable.
  */
 #define CINDEX_VERSION_MAJOR 0
-#define CINDEX_VERSION_MINOR 50
+#define CINDEX_VERSION_MINOR 53
 
 #define CINDEX_VERSION_ENCODE(major, minor) ( \
       ((major) * 10000)                       \
@@ -305,7 +305,16 @@ typedef enum {
    */
   CXGlobalOpt_ThreadBackgroundPriorityForAll =
       CXGlobalOpt_ThreadBackgroundPriorityForIndexing |
-      CXGlobalOpt_ThreadBackgroundPriorityForEditing
+      CXGlobalOpt_ThreadBackgroundPriorityForEditing,
+
+  /**
+   * Used to indicate that translation units of this index that parse the
+   * same main file with the same options should share their precompiled
+   * preamble instead of building one each.
+   *
+   * Affects #clang_parseTranslationUnit.
+   */
+  CXGlobalOpt_SharePreambles = 0x4
 
 } CXGlobalOptFlags;
 
@@ -1631,8 +1640,12 @@ enum CXTUResourceUsageKind {
   CXTUResourceUsage_MEMORY_IN_BYTES_END =
     CXTUResourceUsage_Preprocessor_HeaderSearch,
 
+  /* The number of translation units using the precompiled preamble of this
+     one, including this one. This is a count, not a number of bytes. */
+  CXTUResourceUsage_PreambleShareCount = 15,
+
   CXTUResourceUsage_First = CXTUResourceUsage_AST,
-  CXTUResourceUsage_Last = CXTUResourceUsage_Preprocessor_HeaderSearch
+  CXTUResourceUsage_Last = CXTUResourceUsage_PreambleShareCount
 };
 
 /**
@@ -5496,7 +5509,15 @@ enum CXCodeComplete_Flags {
    * Whether to include completions with small
    * fix-its, e.g. change '.' to '->' on member access, etc.
    */
-  CXCodeComplete_IncludeCompletionsWithFixIts = 0x10
+  CXCodeComplete_IncludeCompletionsWithFixIts = 0x10,
+
+  /**
+   * Whether to omit the cached global completions (declarations and macros
+   * from the preamble) whose typed text does not start with the identifier
+   * being completed. The cached completions are indexed by their typed text,
+   * so this avoids visiting all of them on every request.
+   */
+  CXCodeComplete_FilterByTypedPrefix = 0x20
 };
 
 /**
@@ -6573,7 +6594,15 @@ typedef enum {
    * indexing session associated with a \c CXIndexAction object.
    * Bodies in system headers are always skipped.
    */
-  CXIndexOpt_SkipParsedBodiesInSession = 0x10
+  CXIndexOpt_SkipParsedBodiesInSession = 0x10,
+
+  /**
+   * Skip the declarations of a header that was already indexed, with the
+   * same contents and the same macros defined at its inclusion, by another
+   * translation unit of the indexing session associated with a
+   * \c CXIndexAction object that was indexed without errors.
+   */
+  CXIndexOpt_SkipIndexedHeadersInSession = 0x20
 
 } CXIndexOptFlags;
 
@@ -16,9 +16,16 @@
 #define LLVM_CLANG_AST_CLONEDETECTION_H
 
 #include "clang/AST/StmtVisitor.h"
+#include "llvm/Support/Error.h"
 #include "llvm/Support/Regex.h"
+#include <cstdint>
+#include <string>
 #include <vector>
 
+namespace llvm {
+class MD5;
+} // end namespace llvm
+
 namespace clang {
 
 class Stmt;
@@ -151,6 +158,8 @@ public:
   bool contains(const StmtSequence &Other) const;
 };
 
+struct CloneFingerprint;
+
 /// Searches for similar subtrees in the AST.
 ///
 /// First, this class needs several declarations with statement bodies which
@@ -220,6 +229,25 @@ public:
     constrainClones(Result, ConstraintList...);
   }
 
+  /// Computes the fingerprints of all statements in the previously passed
+  /// statements that have at least the given complexity.
+  ///
+  /// In contrast to findClones, this does not search for clones, and the
+  /// proper sub-sequences of compound statements are not fingerprinted, as
+  /// their number grows quadratically with the size of the compound
+  /// statement. The
+  /// fingerprints are meant to be written to disk and merged with the
+  /// fingerprints of other translation units by findClonesInFingerprints.
+  /// \param Result Output parameter to which the fingerprints are added.
+  /// \param MinComplexity The minimum complexity of a fingerprinted sequence,
+  ///                      as computed by MinComplexityConstraint.
+  /// \param IgnoredFilesPattern Code bodies in files whose name matches this
+  ///                            pattern are skipped, as with the
+  ///                            FilenamePatternConstraint.
+  void collectFingerprints(std::vector<CloneFingerprint> &Result,
+                           unsigned MinComplexity,
+                           StringRef IgnoredFilesPattern = "") const;
+
 private:
   CloneGroup Sequences;
 };
@@ -435,6 +463,10 @@ public:
   unsigned countPatternDifferences(
       const VariablePattern &Other,
       VariablePattern::SuspiciousClonePair *FirstMismatch = nullptr);
+
+  /// Adds the pattern to the given hash. The patterns of two clones have no
+  /// differences if and only if they add the same data to the hash.
+  void addToHash(llvm::MD5 &Hash) const;
 };
 
 /// Ensures that all clones reference variables in the same pattern.
@@ -442,6 +474,60 @@ struct MatchingVariablePatternConstraint {
   void constrain(std::vector<CloneDetector::CloneGroup> &CloneGroups);
 };
 
+/// A compact description of a statement sequence that doesn't depend on the
+/// AST it was computed from.
+///
+/// The fingerprints of many translation units can be merged with
+/// findClonesInFingerprints to find the clones in a whole code base. Two
+/// sequences with the same hash are type II clones of each other that
+/// reference their variables in the same pattern. Instead of comparing the
+/// sequences, the merge relies on a 128-bit hash to rule out collisions.
+struct CloneFingerprint {
+  /// The hash of the type II data of the statements and of the pattern of
+  /// their variable references.
+  uint64_t HashHigh = 0;
+  uint64_t HashLow = 0;
+
+  /// The lower half of the hash of the parent statement, or zero if the
+  /// parent statement wasn't fingerprinted.
+  uint64_t ParentHash = 0;
+
+  /// The location of the sequence, from the beginning of its first statement
+  /// to the beginning of the last token of its last statement. The filename
+  /// is the real path of the file and the location is not affected by #line
+  /// directives, so that the same code is identified by the same location in
+  /// every translation unit.
+  std::string Filename;
+  unsigned BeginLine = 0;
+  unsigned BeginColumn = 0;
+  unsigned EndLine = 0;
+  unsigned EndColumn = 0;
+};
+
+/// Writes the given fingerprints in a line-based text format. Consecutive
+/// fingerprints from the same file share the line naming the file.
+void writeCloneFingerprints(ArrayRef<CloneFingerprint> Fingerprints,
+                            raw_ostream &OS);
+
+/// Reads the fingerprints written by writeCloneFingerprints from \p Buffer
+/// and adds them to \p Result.
+llvm::Error readCloneFingerprints(StringRef Buffer,
+                                  std::vector<CloneFingerprint> &Result);
+
+/// Finds the clones among the given fingerprints, which may come from many
+/// translation units.
+///
+/// The fingerprints are sorted by their hash, so that every run of equal
+/// hashes forms a clone group; there is no pairwise comparison. Fingerprints
+/// of the same code in a header that was included by several translation
+/// units are only counted once. Like the OnlyLargestCloneConstraint, a group
+/// is dropped if the sequences containing its clones form a clone group
+/// themselves.
+///
+/// \returns the clone groups with at least two clones, ordered by location.
+std::vector<std::vector<CloneFingerprint>>
+findClonesInFingerprints(std::vector<CloneFingerprint> Fingerprints);
+
 } // end namespace clang
 
 #endif // LLVM_CLANG_AST_CLONEDETECTION_H
@@ -188,6 +188,11 @@ public:
   /// in the backend for setting the name in the skeleton cu.
   std::string SplitDwarfFile;
 
+  /// Output files for code generation partitions other than the first, which
+  /// is written to the main output. When non-empty, the optimized module is
+  /// split into one partition per output and each is compiled separately.
+  std::vector<std::string> ParallelCodeGenOutputs;
+
   /// The name of the relocation model to use.
   llvm::Reloc::Model RelocationModel;
 
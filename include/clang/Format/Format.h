@@ -1240,6 +1240,17 @@ struct FormatStyle {
   /// Language, this format style is targeted at.
   LanguageKind Language;
 
+  /// The maximum number of ways to reach a token that are explored when
+  /// searching for the best line breaks of a line. ``0`` means unlimited.
+  ///
+  /// The search considers the states with the lowest penalty first, so a
+  /// small beam width only drops alternatives that are already more expensive
+  /// than the ones kept. This bounds the time and memory spent on lines with
+  /// many break opportunities (e.g. long initializer lists) at the cost of
+  /// possibly missing the optimal formatting. If no solution is found within
+  /// the beam, the line is left as is.
+  unsigned LineBreakSearchBeamWidth;
+
   /// A regular expression matching macros that start a block.
   /// \code
   ///    # With:
@@ -1769,6 +1780,7 @@ struct FormatStyle {
            JavaScriptWrapImports == R.JavaScriptWrapImports &&
            KeepEmptyLinesAtTheStartOfBlocks ==
                R.KeepEmptyLinesAtTheStartOfBlocks &&
+           LineBreakSearchBeamWidth == R.LineBreakSearchBeamWidth &&
            MacroBlockBegin == R.MacroBlockBegin &&
            MacroBlockEnd == R.MacroBlockEnd &&
            MaxEmptyLinesToKeep == R.MaxEmptyLinesToKeep &&
@@ -1941,6 +1953,10 @@ struct FormattingAttemptStatus {
   /// original line number at which a syntax error might have occurred. This is
   /// based on a best-effort analysis and could be imprecise.
   unsigned Line = 0;
+
+  /// The number of times the line breaks of a line were reused from an
+  /// identical line formatted before, instead of being searched for again.
+  unsigned NumReusedLineSolutions = 0;
 };
 
 /// Reformats the given \p Ranges in \p Code.
@@ -31,6 +31,7 @@
 #include "clang/Frontend/PrecompiledPreamble.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/Optional.h"
@@ -39,6 +40,7 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator_range.h"
+#include "llvm/Support/Mutex.h"
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -78,6 +80,7 @@ class PCHContainerReader;
 class Preprocessor;
 class PreprocessorOptions;
 class Sema;
+class SharedPreambleCache;
 class TargetInfo;
 
 /// \brief Enumerates the available scopes for skipping function bodies.
@@ -216,8 +219,13 @@ private:
   /// of that loading. It must be cleared when preamble is recreated.
   llvm::StringMap<SourceLocation> PreambleSrcLocCache;
 
-  /// The contents of the preamble.
-  llvm::Optional<PrecompiledPreamble> Preamble;
+  /// The contents of the preamble. It may be shared with other ASTUnits
+  /// through \c PreambleCache.
+  std::shared_ptr<PrecompiledPreamble> Preamble;
+
+  /// Preambles shared with other ASTUnits, or null if preambles are not
+  /// shared.
+  std::shared_ptr<SharedPreambleCache> PreambleCache;
 
   /// When non-NULL, this is the buffer used to store the contents of
   /// the main file when it has been padded for use with the precompiled
@@ -324,8 +332,34 @@ private:
   /// The set of cached code-completion results.
   std::vector<CachedCodeCompletionResult> CachedCompletionResults;
 
+  /// Indices into \c CachedCompletionResults, sorted by typed text.
+  std::vector<unsigned> CachedCompletionsByTypedText;
+
+  /// The cached code-completion results for the declarations and macros of
+  /// one header.
+  ///
+  /// When the global code-completion cache is rebuilt, the chunk of a header
+  /// is reused as long as neither that header, nor any header included before
+  /// it, nor the main file text before its inclusion has changed, and it
+  /// still provides the same set of results. The completion strings of a
+  /// reused chunk are copied into the new allocator.
+  struct CachedCompletionChunk {
+    /// A hash of the contents of the header, of all headers included before
+    /// it and of the text of the main file before its inclusion.
+    llvm::hash_code Key;
+
+    /// A hash of the names and kinds of the results of the header.
+    llvm::hash_code Signature;
+
+    std::vector<CachedCodeCompletionResult> Results;
+  };
+
+  /// The chunks of the global code-completion cache, by header name.
+  llvm::StringMap<CachedCompletionChunk> CachedCompletionChunks;
+
   /// A mapping from the formatted type name to a unique number for that
-  /// type, which is used for type equality comparisons.
+  /// type, which is used for type equality comparisons. It is kept when the
+  /// completion cache is rebuilt, so that reused chunks stay valid.
   llvm::StringMap<unsigned> CachedCompletionTypes;
 
   /// A string hash of the top-level declaration and macro definition
@@ -373,6 +407,9 @@ private:
       unsigned MaxLines = 0);
   void RealizeTopLevelDeclsFromPreamble();
 
+  /// Drops the precompiled preamble and tells \c PreambleCache about it.
+  void releasePreamble();
+
   /// Transfers ownership of the objects (like SourceManager) from
   /// \param CI to this ASTUnit.
   void transferASTDataFromCompilerInstance(CompilerInstance &CI);
@@ -492,6 +529,10 @@ public:
   /// If this ASTUnit came from an AST file, returns the filename for it.
   StringRef getASTFileName() const;
 
+  /// Returns the number of ASTUnits using the precompiled preamble of this
+  /// one, including this one, or 0 if there is no preamble.
+  unsigned getPreambleShareCount() const;
+
   using top_level_iterator = std::vector<Decl *>::iterator;
 
   top_level_iterator top_level_begin() {
@@ -618,6 +659,10 @@ public:
     return CachedCompletionResults.size();
   }
 
+  /// Returns the indices of the cached completion results whose typed text
+  /// starts with \p Prefix, in order of their typed text.
+  ArrayRef<unsigned> getCachedCompletionsWithPrefix(StringRef Prefix) const;
+
   /// Returns an iterator range for the local preprocessing entities
   /// of the local Preprocessor, if this is a parsed source file, or the loaded
   /// preprocessing entities of the primary module if this is an AST file.
@@ -803,6 +848,9 @@ public:
   /// it(i.e., be an overlay over RealFileSystem). RealFileSystem will be used
   /// if \p VFS is nullptr.
   ///
+  /// \param PreambleCache - If non-null, precompiled preambles are shared with
+  /// the other ASTUnits using this cache.
+  ///
   // FIXME: Move OnlyLocalDecls, UseBumpAllocator to setters on the ASTUnit, we
   // shouldn't need to specify them at construction time.
   static ASTUnit *LoadFromCommandLine(
@@ -823,7 +871,8 @@ public:
       bool ForSerialization = false,
       llvm::Optional<StringRef> ModuleFormat = llvm::None,
       std::unique_ptr<ASTUnit> *ErrAST = nullptr,
-      IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS = nullptr);
+      IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS = nullptr,
+      std::shared_ptr<SharedPreambleCache> PreambleCache = nullptr);
 
   /// Reparse the source files using the same command-line options that
   /// were originally used to produce this translation unit.
@@ -887,6 +936,68 @@ public:
   bool serialize(raw_ostream &OS);
 };
 
+/// Precompiled preambles shared between ASTUnits, e.g. all translation units
+/// of a libclang index.
+///
+/// Preambles are identified by a hash of the main file name, the preamble
+/// text, the options that affect how it is parsed and the state of the file
+/// system. The preprocessing record and the diagnostics of a preamble refer to
+/// its main file, so only translation units of the same main file share it.
+/// Before building a preamble, an ASTUnit looks for a live one with the same
+/// key that is still valid for its inputs. Preambles are stored on disk, so
+/// all ASTUnits using a shared preamble map the same PCH file instead of
+/// holding a copy each.
+class SharedPreambleCache {
+public:
+  /// A preamble and the results of building it.
+  struct Entry {
+    std::shared_ptr<PrecompiledPreamble> Preamble;
+    std::vector<serialization::DeclID> TopLevelDeclIDs;
+    SmallVector<ASTUnit::StandaloneDiagnostic, 4> Diagnostics;
+    unsigned NumWarnings = 0;
+    unsigned TopLevelHashValue = 0;
+  };
+
+  /// Computes the key of the preamble of \p MainFileBuffer with the given
+  /// \p Bounds when parsed with \p Invocation on the file system \p VFS.
+  static std::string getKey(const CompilerInvocation &Invocation,
+                            const llvm::MemoryBuffer *MainFileBuffer,
+                            PreambleBounds Bounds, bool SkipFunctionBodies,
+                            llvm::vfs::FileSystem &VFS);
+
+  /// Returns the preamble stored under \p Key if it is still in use by some
+  /// ASTUnit.
+  llvm::Optional<Entry> lookup(StringRef Key);
+
+  /// Stores \p E under \p Key. The cache does not keep the preamble alive;
+  /// it is released once the last ASTUnit using it drops it.
+  void insert(StringRef Key, const Entry &E);
+
+  /// Records that an ASTUnit uses \p Preamble, which it built or got from
+  /// \c lookup. Each call must be balanced by a call to \c release.
+  void retain(const PrecompiledPreamble &Preamble);
+
+  /// Records that an ASTUnit no longer uses \p Preamble.
+  void release(const PrecompiledPreamble &Preamble);
+
+  /// Returns the number of ASTUnits using \p Preamble.
+  unsigned getShareCount(const PrecompiledPreamble &Preamble);
+
+private:
+  /// Removes the entries whose preamble is no longer used. Requires \c Lock.
+  void removeUnusedEntries();
+
+  struct StoredEntry {
+    std::weak_ptr<PrecompiledPreamble> Preamble;
+    /// The results of building the preamble, with a null \c Preamble.
+    Entry Results;
+  };
+
+  llvm::sys::Mutex Lock;
+  llvm::StringMap<StoredEntry> Entries;
+  llvm::DenseMap<const PrecompiledPreamble *, unsigned> ShareCounts;
+};
+
 } // namespace clang
 
 #endif // LLVM_CLANG_FRONTEND_ASTUNIT_H
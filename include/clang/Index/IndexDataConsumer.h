@@ -58,6 +58,11 @@ public:
                                      const Module *Mod,
                                      SymbolRoleSet Roles, SourceLocation Loc);
 
+  /// Called once for each included file whose declarations are not indexed
+  /// because another translation unit sharing the header registry already
+  /// indexed it. The translation unit still depends on the file.
+  virtual void handleSkippedFile(FileID FID) {}
+
   virtual void finish() {}
 };
 
@@ -0,0 +1,80 @@
+//===--- IndexStore.h - Persistent on-disk index store ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// An index store is a directory holding the symbol occurrences of indexed
+// translation units, so that they do not have to be indexed again by every
+// client session.
+//
+// The occurrences of each file are written to a record file in the 'records'
+// subdirectory. The name of a record is derived from the file name and the
+// hash of the file contents, so a header that is included with the same
+// contents by many translation units is only recorded once. Each translation
+// unit writes a unit file to the 'units' subdirectory, which lists the
+// records of its main file and of all the files it includes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_INDEX_INDEXSTORE_H
+#define LLVM_CLANG_INDEX_INDEXSTORE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace clang {
+namespace index {
+  class IndexDataConsumer;
+
+/// Statistics about the records written to an index store. They may be shared
+/// by the data consumers of translation units indexed concurrently.
+struct IndexStoreStats {
+  /// The number of record files that were written.
+  std::atomic<unsigned> NumRecordsWritten{0};
+
+  /// The number of records that already existed in the store and were not
+  /// written again.
+  std::atomic<unsigned> NumRecordsReused{0};
+
+  /// The number of unit files that were written.
+  std::atomic<unsigned> NumUnitsWritten{0};
+};
+
+/// Creates a data consumer that writes the symbol occurrences of the indexed
+/// translation unit to the index store in the directory \p StorePath.
+///
+/// Occurrences in files whose record already exists in the store are not
+/// collected. A record is identified by the path and contents of its file and
+/// by the macros defined at the point where the file was included. Record and
+/// unit files are written to a temporary file first and then renamed, so the
+/// store can be written by several processes or threads at once.
+///
+/// \param Stats if non-null, is updated with the records and units written.
+std::shared_ptr<IndexDataConsumer>
+createIndexStoreDataConsumer(StringRef StorePath,
+                             IndexStoreStats *Stats = nullptr);
+
+/// Returns the name of the record of the file \p Filename with the contents
+/// \p Contents, included with the macros hashed in \p MacroContext.
+///
+/// A header may declare different entities depending on the macros that are
+/// defined where it is included, so each macro context gets its own record.
+std::string getIndexStoreRecordName(StringRef Filename, StringRef Contents,
+                                    uint64_t MacroContext);
+
+/// Returns the path of the unit file of the translation unit with the main
+/// file \p MainFile in the index store \p StorePath.
+std::string getIndexStoreUnitPath(StringRef StorePath, StringRef MainFile);
+
+} // namespace index
+} // namespace clang
+
+#endif
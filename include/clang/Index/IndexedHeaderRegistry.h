@@ -0,0 +1,80 @@
+//===--- IndexedHeaderRegistry.h - Headers indexed in a session -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_INDEX_INDEXEDHEADERREGISTRY_H
+#define LLVM_CLANG_INDEX_INDEXEDHEADERREGISTRY_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Mutex.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace clang {
+  class FileEntry;
+
+namespace index {
+
+/// The set of headers that were already indexed by the translation units of
+/// an indexing session.
+///
+/// A header is identified by its file, the hash of its contents and the hash
+/// of the macro context it is included in, i.e. the macros defined at the
+/// point of its inclusion. A translation unit that indexes a header claims
+/// it; once that translation unit was indexed without errors, the
+/// declarations of the header are skipped by all other translation units.
+/// Translation units that are indexed concurrently may index the same header
+/// until one of them finishes. The registry may be shared by translation
+/// units that are indexed concurrently.
+class IndexedHeaderRegistry {
+  llvm::sys::Mutex Lock;
+  llvm::StringSet<> IndexedHeaders;
+
+  std::atomic<unsigned> NumHeadersIndexed{0};
+  std::atomic<unsigned> NumHeadersSkipped{0};
+  std::atomic<unsigned> NumDeclsVisited{0};
+  std::atomic<unsigned> NumDeclsSkipped{0};
+
+public:
+  /// Returns the key of the header \p File with the contents \p Contents
+  /// included in the macro context \p MacroContext.
+  static std::string getHeaderKey(const FileEntry &File, StringRef Contents,
+                                  uint64_t MacroContext);
+
+  /// Claims the header \p Key for the calling translation unit.
+  ///
+  /// \returns true if the caller should index the header, or false if
+  /// another translation unit already indexed it.
+  bool claimHeader(StringRef Key);
+
+  /// Records that the translation unit which claimed the headers \p Keys was
+  /// indexed without errors, so that other translation units skip them.
+  void markHeadersIndexed(ArrayRef<std::string> Keys);
+
+  /// Records that a top-level declaration was visited or skipped.
+  void recordTopLevelDecl(bool Skipped) {
+    ++(Skipped ? NumDeclsSkipped : NumDeclsVisited);
+  }
+
+  unsigned getNumHeadersIndexed() const { return NumHeadersIndexed; }
+  unsigned getNumHeadersSkipped() const { return NumHeadersSkipped; }
+  unsigned getNumDeclsVisited() const { return NumDeclsVisited; }
+  unsigned getNumDeclsSkipped() const { return NumDeclsSkipped; }
+
+  /// Prints the number of headers and top-level declarations that were
+  /// indexed and skipped.
+  void printStats(raw_ostream &OS) const;
+};
+
+} // namespace index
+} // namespace clang
+
+#endif
@@ -29,6 +29,7 @@ namespace serialization {
 
 namespace index {
   class IndexDataConsumer;
+  class IndexedHeaderRegistry;
 
 struct IndexingOptions {
   enum class SystemSymbolFilterKind {
@@ -45,6 +46,9 @@ struct IndexingOptions {
   // callback is not available (e.g. after parsing has finished). Note that
   // macro references are not available in Proprocessor.
   bool IndexMacrosInPreprocessor = false;
+  // If set, the declarations of headers that were already indexed by another
+  // translation unit sharing the registry are skipped.
+  std::shared_ptr<IndexedHeaderRegistry> HeaderRegistry;
 };
 
 /// Creates a frontend action that indexes all symbols (macros and AST decls).
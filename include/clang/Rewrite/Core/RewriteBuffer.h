@@ -13,6 +13,7 @@
 #include "clang/Basic/LLVM.h"
 #include "clang/Rewrite/Core/DeltaTree.h"
 #include "clang/Rewrite/Core/RewriteRope.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 
 namespace clang {
@@ -35,6 +36,14 @@ class RewriteBuffer {
 public:
   using iterator = RewriteRope::const_iterator;
 
+  /// Edit - A replacement of \c OrigLength characters at \c OrigOffset in
+  /// the original buffer with \c NewText, for use with ApplyEdits.
+  struct Edit {
+    unsigned OrigOffset;
+    unsigned OrigLength;
+    StringRef NewText;
+  };
+
   iterator begin() const { return Buffer.begin(); }
   iterator end() const { return Buffer.end(); }
   unsigned size() const { return Buffer.size(); }
@@ -89,6 +98,13 @@ public:
   void ReplaceText(unsigned OrigOffset, unsigned OrigLength,
                    StringRef NewStr);
 
+  /// ApplyEdits - Apply a batch of replacements, whose ranges in the original
+  /// buffer must not overlap.  The result is the same as calling ReplaceText
+  /// for each edit in order of offset, with edits at the same offset applied
+  /// in the order given, but the buffer is rebuilt in a single pass instead
+  /// of being updated once per edit.  \p Edits is sorted in place.
+  void ApplyEdits(MutableArrayRef<Edit> Edits);
+
 private:
   /// getMappedOffset - Given an offset into the original SourceBuffer that this
   /// RewriteBuffer is based on, map it into the offset space of the
@@ -14,6 +14,7 @@
 #ifndef LLVM_CLANG_REWRITE_CORE_REWRITEROPE_H
 #define LLVM_CLANG_REWRITE_CORE_REWRITEROPE_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/StringRef.h"
 #include <cassert>
@@ -127,6 +128,10 @@ namespace clang {
       return llvm::StringRef(&(*CurPiece)[0], CurPiece->size());
     }
 
+    /// Returns the RopePiece the iterator points into, which shares its string
+    /// data with the tree.
+    const RopePiece &getRopePiece() const { return *CurPiece; }
+
     void MoveToNextPiece();
   };
 
@@ -155,6 +160,8 @@ namespace clang {
     void insert(unsigned Offset, const RopePiece &R);
 
     void erase(unsigned Offset, unsigned NumBytes);
+
+    void swap(RopePieceBTree &RHS) { std::swap(Root, RHS.Root); }
   };
 
   //===--------------------------------------------------------------------===//
@@ -174,6 +181,13 @@ class RewriteRope {
   unsigned AllocOffs = AllocChunkSize;
 
 public:
+  /// A replacement of the \c Length bytes at \c Offset with \c Text.
+  struct Edit {
+    unsigned Offset;
+    unsigned Length;
+    llvm::StringRef Text;
+  };
+
   RewriteRope() = default;
   RewriteRope(const RewriteRope &RHS) : Chunks(RHS.Chunks) {}
 
@@ -206,6 +220,17 @@ public:
     Chunks.erase(Offset, NumBytes);
   }
 
+  /// applyEdits - Apply all of \p Edits in a single pass over the rope.  The
+  /// edits must be sorted by offset and must not overlap, and their offsets
+  /// refer to the rope before any of them is applied.  Edits at the same
+  /// offset are applied in order.  The rope is rebuilt as a sequence of pieces
+  /// that share the unchanged text with the old rope instead of copying it.
+  ///
+  /// As with insert and erase, every edit must lie within the rope, i.e.
+  /// Offset+Length must not exceed size().  This is only checked by
+  /// assertions; an out-of-range edit is cut off at the end of the rope.
+  void applyEdits(llvm::ArrayRef<Edit> Edits);
+
 private:
   RopePiece MakeRopeString(const char *Start, const char *End);
 };
@@ -735,6 +735,10 @@ public:
   /// Add the parent context information to this code completion.
   void addParentContext(const DeclContext *DC);
 
+  /// Add the name of the parent context, e.g. one taken from another code
+  /// completion string.
+  void addParentName(StringRef Name);
+
   const char *getBriefComment() const { return BriefComment; }
   void addBriefComment(StringRef Comment);
 
@@ -1114,6 +1118,12 @@ public:
     return CodeCompleteOpts.LoadExternal;
   }
 
+  /// Whether cached global results may be omitted when their typed text does
+  /// not start with the identifier being completed.
+  bool filterByTypedPrefix() const {
+    return CodeCompleteOpts.FilterByTypedPrefix;
+  }
+
   /// Determine whether the output of this consumer is binary.
   bool isOutputBinary() const { return OutputIsBinary; }
 
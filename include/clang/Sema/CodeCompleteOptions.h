@@ -44,10 +44,14 @@ public:
   /// on member access, etc.
   unsigned IncludeFixIts : 1;
 
+  /// Omit cached global results whose typed text does not start with the
+  /// identifier being completed.
+  unsigned FilterByTypedPrefix : 1;
+
   CodeCompleteOptions()
       : IncludeMacros(0), IncludeCodePatterns(0), IncludeGlobals(1),
         IncludeNamespaceLevelDecls(1), IncludeBriefComments(0),
-        LoadExternal(1), IncludeFixIts(0) {}
+        LoadExternal(1), IncludeFixIts(0), FilterByTypedPrefix(0) {}
 };
 
 } // namespace clang
@@ -57,6 +57,7 @@
 #include "llvm/ADT/TinyPtrVector.h"
 #include <deque>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -1110,6 +1111,28 @@ public:
   /// The number of SFINAE diagnostics that have been trapped.
   unsigned NumSFINAEErrors;
 
+  /// Statistics about unqualified name lookup, printed by -print-stats.
+  struct {
+    unsigned NumLookups = 0;
+    uint64_t NumChainEntriesWalked = 0;
+    unsigned MaxChainEntriesWalked = 0;
+    uint64_t LookupTimeNS = 0;
+  } UnqualifiedLookupStats;
+
+  /// Statistics about overload resolution, printed by -print-stats.
+  struct {
+    unsigned NumResolutions = 0;
+    uint64_t NumCandidates = 0;
+    uint64_t NumArityMismatches = 0;
+    unsigned NumCalls = 0;
+    unsigned NumRepeatedCalls = 0;
+  } OverloadResolutionStats;
+
+  /// The callees and argument types of the overloaded calls seen so far, to
+  /// count the calls that repeat an earlier one. Only filled in when
+  /// statistics are collected.
+  std::set<std::vector<const void *>> OverloadedCallSignatures;
+
   typedef llvm::DenseMap<ParmVarDecl *, llvm::TinyPtrVector<ParmVarDecl *>>
     UnparsedDefaultArgInstantiationsMap;
 
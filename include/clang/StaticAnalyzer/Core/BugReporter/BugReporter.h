@@ -29,6 +29,7 @@
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableSet.h"
 #include "llvm/ADT/None.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
@@ -481,6 +482,11 @@ public:
     return {};
   }
 
+  /// Checks the feasibility of the candidate reports of all the given
+  /// equivalence classes before their diagnostics are generated, and marks
+  /// the infeasible ones invalid.
+  virtual void crosscheckReports(ArrayRef<BugReportEquivClass *> EQClasses) {}
+
   void Register(BugType *BT);
 
   /// Add the given report to the set of reports tracked by BugReporter.
@@ -513,6 +519,9 @@ private:
 class GRBugReporter : public BugReporter {
   ExprEngine& Eng;
 
+  /// The reports whose feasibility was checked by crosscheckReports().
+  llvm::SmallPtrSet<const BugReport *, 16> CrosscheckedReports;
+
 public:
   GRBugReporter(BugReporterData& d, ExprEngine& eng)
       : BugReporter(d, GRBugReporterKind), Eng(eng) {}
@@ -536,6 +545,17 @@ public:
   generatePathDiagnostics(ArrayRef<PathDiagnosticConsumer *> consumers,
                           ArrayRef<BugReport *> &bugReports) override;
 
+  /// If crosschecking with Z3 is enabled, checks the path constraints of the
+  /// first candidate reports of each equivalence class with the solver. The
+  /// queries run concurrently on a pool of threads.
+  void crosscheckReports(ArrayRef<BugReportEquivClass *> EQClasses) override;
+
+  /// Returns true if \p R was crosschecked by crosscheckReports(), so that
+  /// its path does not need to be checked again.
+  bool isCrosschecked(const BugReport *R) const {
+    return CrosscheckedReports.count(R);
+  }
+
   /// classof - Used by isa<>, cast<>, and dyn_cast<>.
   static bool classof(const BugReporter* R) {
     return R->getKind() == GRBugReporterKind;
@@ -17,6 +17,7 @@
 
 #include "clang/Basic/LLVM.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/RangedConstraintManager.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/SMTSolver.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SVals.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/STLExtras.h"
@@ -341,6 +342,19 @@ public:
 
   void finalizeVisitor(BugReporterContext &BRC, const ExplodedNode *EndPathNode,
                        BugReport &BR) override;
+
+  /// Adds the constraints of the state of \p N on the symbols that are not
+  /// constrained in \p Constraints yet.
+  static void addConstraints(ConstraintRangeTy &Constraints,
+                             const ExplodedNode *N);
+
+  /// Collects the constraints of the path ending in \p ErrorNode, in the
+  /// order in which the visitor collects them.
+  static ConstraintRangeTy collectConstraints(const ExplodedNode *ErrorNode);
+
+  /// Creates a solver that asserts the given constraints.
+  static SMTSolverRef createSolver(const ConstraintRangeTy &Constraints,
+                                   ASTContext &Ctx);
 };
 
 namespace bugreporter {
@@ -153,6 +153,10 @@ private:
   /// The flag, which specifies the mode of inlining for the engine.
   InliningModes HowToInline;
 
+  /// True if a call wasn't inlined because of a size or count limit, which
+  /// may depend on the functions analyzed earlier.
+  bool ExceededInliningBudget = false;
+
 public:
   ExprEngine(cross_tu::CrossTranslationUnitContext &CTU, AnalysisManager &mgr,
              SetOfConstDecls *VisitedCalleesIn,
@@ -396,6 +400,9 @@ public:
   bool hasEmptyWorkList() const { return !Engine.getWorkList()->hasWork(); }
   bool hasWorkRemaining() const { return Engine.hasWorkRemaining(); }
 
+  /// Returns true if a call wasn't inlined because of a size or count limit.
+  bool hasExceededInliningBudget() const { return ExceededInliningBudget; }
+
   const CoreEngine &getCoreEngine() const { return Engine; }
 
 public:
@@ -720,6 +727,20 @@ private:
   void conservativeEvalCall(const CallEvent &Call, NodeBuilder &Bldr,
                             ExplodedNode *Pred, ProgramStateRef State);
 
+  /// Returns true unless the body of the given function is known to have no
+  /// effects other than its return value. The result is cached in the
+  /// function summaries.
+  bool mayHaveSideEffects(const Decl *D);
+
+  /// Evaluate a call to the function without side effects \p D by only
+  /// binding its return value, instead of inlining it. The return value is
+  /// known when \p D always returns the same constant or parameter, and is
+  /// conjured otherwise. This is unsound: checkers do not see the events of
+  /// the callee.
+  void summarizedEvalCall(const CallEvent &Call, const Decl *D,
+                          NodeBuilder &Bldr, ExplodedNode *Pred,
+                          ProgramStateRef State);
+
   /// Either inline or process the call conservatively (or both), based
   /// on DynamicDispatchBifurcation data.
   void BifurcateCall(const MemRegion *BifurReg,
@@ -38,7 +38,7 @@ class FunctionSummariesTy {
     llvm::SmallBitVector VisitedBasicBlocks;
 
     /// Total number of blocks in the function.
-    unsigned TotalBasicBlocks : 30;
+    unsigned TotalBasicBlocks : 27;
 
     /// True if this function has been checked against the rules for which
     /// functions may be inlined.
@@ -47,12 +47,24 @@ class FunctionSummariesTy {
     /// True if this function may be inlined.
     unsigned MayInline : 1;
 
+    /// True if the body of this function has been checked for side effects.
+    unsigned SideEffectsChecked : 1;
+
+    /// True if calling this function may have effects that are visible to the
+    /// caller, other than through its return value.
+    unsigned MayHaveSideEffects : 1;
+
+    /// True if the analysis of an inlined call to this function exceeded the
+    /// maximum block count.
+    unsigned ReachedMaxBlockCount : 1;
+
     /// The number of times the function has been inlined.
     unsigned TimesInlined : 32;
 
     FunctionSummary()
         : TotalBasicBlocks(0), InlineChecked(0), MayInline(0),
-          TimesInlined(0) {}
+          SideEffectsChecked(0), MayHaveSideEffects(0),
+          ReachedMaxBlockCount(0), TimesInlined(0) {}
   };
 
   using MapTy = llvm::DenseMap<const Decl *, FunctionSummary>;
@@ -85,6 +97,12 @@ public:
 
   void markReachedMaxBlockCount(const Decl *D) {
     markShouldNotInline(D);
+    findOrInsertSummary(D)->second.ReachedMaxBlockCount = 1;
+  }
+
+  bool hasReachedMaxBlockCount(const Decl *D) {
+    MapTy::const_iterator I = Map.find(D);
+    return I != Map.end() && I->second.ReachedMaxBlockCount;
   }
 
   Optional<bool> mayInline(const Decl *D) {
@@ -94,6 +112,19 @@ public:
     return None;
   }
 
+  void markSideEffects(const Decl *D, bool MayHaveSideEffects) {
+    MapTy::iterator I = findOrInsertSummary(D);
+    I->second.SideEffectsChecked = 1;
+    I->second.MayHaveSideEffects = MayHaveSideEffects;
+  }
+
+  Optional<bool> mayHaveSideEffects(const Decl *D) {
+    MapTy::const_iterator I = Map.find(D);
+    if (I != Map.end() && I->second.SideEffectsChecked)
+      return I->second.MayHaveSideEffects;
+    return None;
+  }
+
   void markVisitedBasicBlock(unsigned ID, const Decl* D, unsigned TotalIDs) {
     MapTy::iterator I = findOrInsertSummary(D);
     llvm::SmallBitVector &Blocks = I->second.VisitedBasicBlocks;
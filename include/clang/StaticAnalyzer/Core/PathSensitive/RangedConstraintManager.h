@@ -108,6 +108,7 @@ private:
                         PrimRangeSet::iterator &e) const;
 
   const llvm::APSInt &getMinValue() const;
+  const llvm::APSInt &getMaxValue() const;
 
   bool pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const;
 
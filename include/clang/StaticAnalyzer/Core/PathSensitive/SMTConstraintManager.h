@@ -17,12 +17,31 @@
 
 #include "clang/StaticAnalyzer/Core/PathSensitive/RangedConstraintManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SMTConv.h"
+#include "llvm/Support/Timer.h"
 
 namespace clang {
 namespace ento {
 
+/// Counts the work done by an SMTConstraintManager.
+struct SMTQueryStats {
+  /// The number of satisfiability checks sent to the solver.
+  unsigned NumQueries = 0;
+
+  /// The number of queries answered from the query cache.
+  unsigned NumCachedQueries = 0;
+
+  /// The number of constraints asserted on the solver.
+  unsigned NumConstraintsAsserted = 0;
+
+  /// The number of constraints that were kept asserted from the previous
+  /// query instead of being asserted again.
+  unsigned NumConstraintsReused = 0;
+};
+
 template <typename ConstraintSMT, typename SMTExprTy>
 class SMTConstraintManager : public clang::ento::SimpleConstraintManager {
+  using ConstraintSMTTy = typename ProgramStateTrait<ConstraintSMT>::data_type;
+
   SMTSolverRef &Solver;
 
 public:
@@ -119,11 +138,10 @@ public:
       SMTExprRef Exp =
           SMTConv::fromData(Solver, SD->getSymbolID(), Ty, Ctx.getTypeSize(Ty));
 
-      Solver->reset();
-      addStateConstraints(State);
+      setStateConstraints(State);
 
       // Constraints are unsatisfiable
-      Optional<bool> isSat = Solver->check();
+      Optional<bool> isSat = checkSolver();
       if (!isSat.hasValue() || !isSat.getValue())
         return nullptr;
 
@@ -138,10 +156,11 @@ public:
                               : Solver->mkBitvector(Value, Value.getBitWidth()),
           /*isSigned=*/false);
 
+      Solver->push();
       Solver->addConstraint(NotExp);
-
-      Optional<bool> isNotSat = Solver->check();
-      if (!isSat.hasValue() || isNotSat.getValue())
+      Optional<bool> isNotSat = checkSolver();
+      Solver->pop();
+      if (!isNotSat.hasValue() || isNotSat.getValue())
         return nullptr;
 
       // This is the only solution, store it
@@ -267,7 +286,22 @@ public:
   /// Dumps SMT formula
   LLVM_DUMP_METHOD void dump() const { Solver->dump(); }
 
+  /// Measures the time spent asserting constraints and checking them with
+  /// the solver. The timers are shared by all constraint managers and are
+  /// printed with the other timers at the end of the compilation.
+  void enableSolverTimers() { TimeSolver = true; }
+
+  const SMTQueryStats &getQueryStats() const { return Stats; }
+
 protected:
+  /// Releases the solver expressions held by the constraint manager. The
+  /// solver is owned by the derived class, which must call this before it
+  /// destroys the solver, as the expressions refer to the solver's context.
+  void releaseSolverExprs() {
+    AssertedConstraints.clear();
+    Cached.clear();
+  }
+
   // Check whether a new model is satisfiable, and update the program state.
   virtual ProgramStateRef assumeExpr(ProgramStateRef State, SymbolRef Sym,
                                      const SMTExprRef &Exp) {
@@ -279,55 +313,102 @@ protected:
     return nullptr;
   }
 
-  /// Given a program state, construct the logical conjunction and add it to
-  /// the solver
-  virtual void addStateConstraints(ProgramStateRef State) const {
+  /// Makes the solver assert exactly the constraints of the program state.
+  ///
+  /// Each constraint is asserted in its own solver scope. The constraints that
+  /// the state shares with the previous query, in the order of the constraint
+  /// set, are kept, so that consecutive queries along a path only pop and
+  /// assert the constraints in which their states differ.
+  virtual void setStateConstraints(ProgramStateRef State) const {
     // TODO: Don't add all the constraints, only the relevant ones
+    llvm::NamedRegionTimer Timer("assert", "Asserting constraints", "smt",
+                                 "SMT solver timers", TimeSolver);
     auto CZ = State->get<ConstraintSMT>();
     auto I = CZ.begin(), IE = CZ.end();
 
-    // Construct the logical AND of all the constraints
-    if (I != IE) {
-      std::vector<SMTExprRef> ASTs;
+    size_t Kept = 0;
+    while (I != IE && Kept < AssertedConstraints.size() &&
+           AssertedConstraints[Kept].first == I->first &&
+           *AssertedConstraints[Kept].second == I->second) {
+      ++I;
+      ++Kept;
+    }
+    Stats.NumConstraintsReused += Kept;
 
-      SMTExprRef Constraint = Solver->newExprRef(I++->second);
-      while (I != IE) {
-        Constraint = Solver->mkAnd(Constraint, Solver->newExprRef(I++->second));
-      }
+    if (Kept < AssertedConstraints.size()) {
+      Solver->pop(AssertedConstraints.size() - Kept);
+      AssertedConstraints.resize(Kept);
+    }
 
+    for (; I != IE; ++I) {
+      SMTExprRef Constraint = Solver->newExprRef(I->second);
+      Solver->push();
       Solver->addConstraint(Constraint);
+      AssertedConstraints.emplace_back(I->first, Constraint);
+      ++Stats.NumConstraintsAsserted;
     }
   }
 
+  /// Checks the satisfiability of the constraints asserted on the solver.
+  Optional<bool> checkSolver() const {
+    llvm::NamedRegionTimer Timer("check", "Checking satisfiability", "smt",
+                                 "SMT solver timers", TimeSolver);
+    ++Stats.NumQueries;
+    return Solver->check();
+  }
+
   // Generate and check a Z3 model, using the given constraint.
   ConditionTruthVal checkModel(ProgramStateRef State, SymbolRef Sym,
                                const SMTExprRef &Exp) const {
-    ProgramStateRef NewState = State->add<ConstraintSMT>(
+    ConstraintSMTTy NewConstraints = State->get_context<ConstraintSMT>().add(
+        State->get<ConstraintSMT>(),
         std::make_pair(Sym, static_cast<const SMTExprTy &>(*Exp)));
 
-    llvm::FoldingSetNodeID ID;
-    NewState->get<ConstraintSMT>().Profile(ID);
+    // Constraint sets are uniqued, so the root of the set identifies it.
+    const void *Key = NewConstraints.getRootWithoutRetain();
+    auto I = Cached.find(Key);
+    if (I != Cached.end()) {
+      ++Stats.NumCachedQueries;
+      return I->second.second;
+    }
+
+    // Only the new constraint is asserted in a scope of its own, so that the
+    // constraints of the state stay asserted for the next query.
+    setStateConstraints(State);
+    Solver->push();
+    Solver->addConstraint(Exp);
+    Optional<bool> res = checkSolver();
+    Solver->pop();
+
+    ConditionTruthVal Result;
+    if (res.hasValue())
+      Result = ConditionTruthVal(res.getValue());
+
+    if (Cached.size() >= MaxCachedQueries)
+      Cached.clear();
+    Cached.try_emplace(Key, NewConstraints, Result);
+    return Result;
+  }
 
-    unsigned hash = ID.ComputeHash();
-    auto I = Cached.find(hash);
-    if (I != Cached.end())
-      return I->second;
+  /// The constraints currently asserted on the solver, each in its own scope.
+  mutable std::vector<std::pair<SymbolRef, SMTExprRef>> AssertedConstraints;
 
-    Solver->reset();
-    addStateConstraints(NewState);
+  // Cache the result of an SMT query (true, false, unknown). The key is the
+  // root of the constraint set of the query, which the entry keeps alive so
+  // that the key cannot be reused by a different set. The ProgramStateManager
+  // destroys the constraint manager before the factory of these sets.
+  mutable llvm::DenseMap<const void *,
+                         std::pair<ConstraintSMTTy, ConditionTruthVal>>
+      Cached;
 
-    Optional<bool> res = Solver->check();
-    if (!res.hasValue())
-      Cached[hash] = ConditionTruthVal();
-    else
-      Cached[hash] = ConditionTruthVal(res.getValue());
+  /// The number of cached queries beyond which the cache is cleared.
+  static constexpr unsigned MaxCachedQueries = 1 << 16;
 
-    return Cached[hash];
-  }
+  mutable SMTQueryStats Stats;
 
-  // Cache the result of an SMT query (true, false, unknown). The key is the
-  // hash of the constraints in a state
-  mutable llvm::DenseMap<unsigned, ConditionTruthVal> Cached;
+  /// Whether to measure the time spent asserting constraints and checking
+  /// their satisfiability.
+  bool TimeSolver = false;
 }; // end class SMTConstraintManager
 
 } // namespace ento
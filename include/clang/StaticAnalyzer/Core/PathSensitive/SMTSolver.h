@@ -288,6 +288,10 @@ public:
   /// Checks if the solver supports floating-points.
   virtual bool isFPSupported() = 0;
 
+  /// Limits the time a single check may take, in milliseconds. A limit of 0
+  /// lets checks run to completion.
+  virtual void setTimeout(unsigned Milliseconds) = 0;
+
   virtual void print(raw_ostream &OS) const = 0;
 };
 
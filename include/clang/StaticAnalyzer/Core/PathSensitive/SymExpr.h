@@ -37,11 +37,10 @@ public:
 #include "clang/StaticAnalyzer/Core/PathSensitive/Symbols.def"
   };
 
-private:
-  Kind K;
-
 protected:
-  SymExpr(Kind k) : K(k) {}
+  SymExpr(Kind k) : K(k) {
+    assert(K == k && "Symbol kind does not fit into a byte");
+  }
 
   static bool isValidTypeForSymbol(QualType T) {
     // FIXME: Depending on whether we choose to deprecate structural symbols,
@@ -51,10 +50,15 @@ protected:
 
   mutable unsigned Complexity = 0;
 
+private:
+  /// The kind is stored in a single byte after Complexity, so that subclasses
+  /// may place small fields in the tail padding of SymExpr.
+  unsigned char K;
+
 public:
   virtual ~SymExpr() = default;
 
-  Kind getKind() const { return K; }
+  Kind getKind() const { return static_cast<Kind>(K); }
 
   virtual void dump() const;
 
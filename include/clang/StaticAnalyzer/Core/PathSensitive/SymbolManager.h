@@ -31,6 +31,7 @@
 namespace clang {
 
 class ASTContext;
+class ProgramPointTag;
 class Stmt;
 
 namespace ento {
@@ -302,13 +303,16 @@ public:
 
 /// Represents a symbolic expression involving a binary operator
 class BinarySymExpr : public SymExpr {
-  BinaryOperator::Opcode Op;
+  /// The opcode is kept in a byte, which fits into the tail padding of
+  /// SymExpr and saves a word in every binary symbolic expression.
+  unsigned char Op;
   QualType T;
 
 protected:
   BinarySymExpr(Kind k, BinaryOperator::Opcode op, QualType t)
       : SymExpr(k), Op(op), T(t) {
     assert(classof(this));
+    assert(Op == op && "Opcode does not fit into a byte");
     // Binary expressions are results of arithmetic. Pointer arithmetic is not
     // handled by binary expressions, but it is instead handled by applying
     // sub-regions to regions.
@@ -320,7 +324,9 @@ public:
   // generation of virtual functions.
   QualType getType() const override { return T; }
 
-  BinaryOperator::Opcode getOpcode() const { return Op; }
+  BinaryOperator::Opcode getOpcode() const {
+    return static_cast<BinaryOperator::Opcode>(Op);
+  }
 
   // Implement isa<T> support.
   static bool classof(const SymExpr *SE) {
@@ -473,6 +479,22 @@ class SymbolManager {
   BasicValueFactory &BV;
   ASTContext &Ctx;
 
+  /// The checker on whose behalf new symbols are created, or null while the
+  /// analyzer core itself is running.
+  const ProgramPointTag *Creator = nullptr;
+
+  /// Whether SymbolsCreatedBy is updated. Off by default, as the update
+  /// would cost a map lookup for every new symbol.
+  bool CountSymbolCreators = false;
+
+  /// The number of symbols and symbolic expressions created by each checker.
+  llvm::DenseMap<const ProgramPointTag *, unsigned> SymbolsCreatedBy;
+
+  /// Allocates and interns a new symbol in place of the one that was not
+  /// found at InsertPos, and accounts for it in the statistics.
+  template <typename SymExprT, typename... ArgsT>
+  SymExpr *createSymbol(void *InsertPos, ArgsT &&... Args);
+
 public:
   SymbolManager(ASTContext &ctx, BasicValueFactory &bv,
                 llvm::BumpPtrAllocator& bpalloc)
@@ -543,6 +565,32 @@ public:
 
   ASTContext &getContext() { return Ctx; }
   BasicValueFactory &getBasicVals() { return BV; }
+
+  /// Enables counting the symbols created on behalf of each checker.
+  void enableSymbolCreatorCounting() { CountSymbolCreators = true; }
+
+  /// Returns the number of symbols and symbolic expressions created on behalf
+  /// of each checker. Symbols created by the analyzer core are counted under
+  /// a null tag. Empty unless enableSymbolCreatorCounting was called.
+  const llvm::DenseMap<const ProgramPointTag *, unsigned> &
+  getSymbolsCreatedBy() const {
+    return SymbolsCreatedBy;
+  }
+
+  /// Attributes the symbols created during its lifetime to the given checker.
+  class CreatorScope {
+    SymbolManager &SymMgr;
+    const ProgramPointTag *PrevCreator;
+
+  public:
+    CreatorScope(SymbolManager &SymMgr, const ProgramPointTag *Creator)
+        : SymMgr(SymMgr), PrevCreator(SymMgr.Creator) {
+      SymMgr.Creator = Creator;
+    }
+    CreatorScope(const CreatorScope &) = delete;
+    CreatorScope &operator=(const CreatorScope &) = delete;
+    ~CreatorScope() { SymMgr.Creator = PrevCreator; }
+  };
 };
 
 /// A class responsible for cleaning up unused symbols.
@@ -113,6 +113,18 @@ struct ComparisonOptions {
   /// mapping is computed, unless the size of either subtrees exceeds this.
   int MaxSize = 100;
 
+  /// The optimal mapping allocates two matrices with one entry for each pair
+  /// of nodes of both subtrees. If this is positive, the optimal mapping is
+  /// not computed when the product of the subtree sizes exceeds it, which
+  /// bounds the memory used for a single pair of subtrees.
+  int64_t MaxMatrixSize = 0;
+
+  /// During top-down matching, find identical subtrees by a hash of their
+  /// structure and node values instead of comparing every pair of subtrees of
+  /// the same height. This yields the same mapping, but scales to trees with
+  /// many identical subtrees.
+  bool UseSubtreeHashes = true;
+
   bool StopAfterTopDown = false;
 
   /// Returns false if the nodes should never be matched.
@@ -21,6 +21,7 @@
 
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Compiler.h"
@@ -258,6 +259,17 @@ public:
   /// category of replacements.
   llvm::Error add(const Replacement &R);
 
+  /// Adds all replacements in \p Rs to the current set of replacements.
+  ///
+  /// This is equivalent to calling add() for each replacement in \p Rs in
+  /// sorted order, but the replacements are sorted once and checked for
+  /// conflicts in a single sweep, so adding n replacements takes O(n log n)
+  /// time. Only replacements that overlap a previous one are checked with the
+  /// more expensive order-independence test of add().
+  /// Returns the error of the first replacement that conflicts; in that case
+  /// the replacements that sort before it have already been added.
+  llvm::Error addAll(ArrayRef<Replacement> Rs);
+
   /// Merges \p Replaces into the current replacements. \p Replaces
   /// refers to code after applying the current replacements.
   LLVM_NODISCARD Replacements merge(const Replacements &Replaces) const;
@@ -292,6 +304,9 @@ private:
   Replacements(const_iterator Begin, const_iterator End)
       : Replaces(Begin, End) {}
 
+  explicit Replacements(ReplacementsImpl &&Replaces)
+      : Replaces(std::move(Replaces)) {}
+
   // Returns `R` with new range that refers to code after `Replaces` being
   // applied.
   Replacement getReplacementInChangedCode(const Replacement &R) const;
@@ -329,6 +344,15 @@ bool applyAllReplacements(const Replacements &Replaces, Rewriter &Rewrite);
 llvm::Expected<std::string> applyAllReplacements(StringRef Code,
                                                  const Replacements &Replaces);
 
+/// Writes \p Code with all replacements in \p Replaces applied to \p OS.
+///
+/// Like the overload above, this ignores the path stored in each replacement.
+/// The result is written piece by piece in a single pass over \p Code,
+/// without building the rewritten code in memory. Returns an error if a
+/// replacement is out of the bounds of \p Code.
+llvm::Error applyAllReplacements(StringRef Code, const Replacements &Replaces,
+                                 raw_ostream &OS);
+
 /// Collection of Replacements generated from a single translation unit.
 struct TranslationUnitReplacements {
   /// Name of the main source for the translation unit.
@@ -21,12 +21,11 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/MemoryBuffer.h"
-#include "llvm/Support/SourceMgr.h"
-#include "llvm/Support/YAMLParser.h"
+#include <cstdint>
 #include <memory>
 #include <string>
-#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -58,16 +57,30 @@ namespace tooling {
 ///
 /// JSON compilation databases can for example be generated in CMake projects
 /// by setting the flag -DCMAKE_EXPORT_COMPILE_COMMANDS.
+///
+/// The database file is memory mapped and parsed in a single pass that only
+/// records where the values of each entry are. The command lines are decoded
+/// when they are looked up. The positions of the entries can be saved to a
+/// binary index file, so that the database doesn't need to be parsed again
+/// as long as it doesn't change. Databases that are not plain JSON but are
+/// valid YAML, e.g. with unquoted strings, are parsed with the YAML parser
+/// and can't be indexed.
 enum class JSONCommandLineSyntax { Windows, Gnu, AutoDetect };
 class JSONCompilationDatabase : public CompilationDatabase {
 public:
   /// Loads a JSON compilation database from the specified file.
   ///
+  /// If \p IndexPath is not empty and names an index that was written for the
+  /// current contents of the database file, the entries are read from the
+  /// index instead of parsing the database. Otherwise, the database is parsed
+  /// and the index is written to \p IndexPath. Failing to write the index is
+  /// not an error.
+  ///
   /// Returns NULL and sets ErrorMessage if the database could not be
   /// loaded from the given file.
   static std::unique_ptr<JSONCompilationDatabase>
   loadFromFile(StringRef FilePath, std::string &ErrorMessage,
-               JSONCommandLineSyntax Syntax);
+               JSONCommandLineSyntax Syntax, StringRef IndexPath = "");
 
   /// Loads a JSON compilation database from a data buffer.
   ///
@@ -93,12 +106,30 @@ public:
   /// database.
   std::vector<CompileCommand> getAllCompileCommands() const override;
 
+  /// Returns true if the entries were read from an index file instead of
+  /// parsing the database.
+  bool isLoadedFromIndex() const { return LoadedFromIndex; }
+
 private:
   /// Constructs a JSON compilation database on a memory buffer.
   JSONCompilationDatabase(std::unique_ptr<llvm::MemoryBuffer> Database,
                           JSONCommandLineSyntax Syntax)
-      : Database(std::move(Database)), Syntax(Syntax),
-        YAMLStream(this->Database->getBuffer(), SM) {}
+      : Database(std::move(Database)), Syntax(Syntax) {}
+
+  /// The raw JSON text of the values of a compile command in the database
+  /// buffer. Strings include their quotes and escape sequences, and
+  /// 'arguments' is the whole array. The values are only decoded when the
+  /// command is looked up.
+  ///
+  /// If both 'command' and 'arguments' are present, 'arguments' is used.
+  /// Missing values are empty.
+  struct CompileCommandRef {
+    StringRef Directory;
+    StringRef Filename;
+    StringRef Command;
+    StringRef Arguments;
+    StringRef Output;
+  };
 
   /// Parses the database file and creates the index.
   ///
@@ -106,35 +137,54 @@ private:
   /// failed.
   bool parse(std::string &ErrorMessage);
 
-  // Tuple (directory, filename, commandline, output) where 'commandline'
-  // points to the corresponding scalar nodes in the YAML stream.
-  // If the command line contains a single argument, it is a shell-escaped
-  // command line.
-  // Otherwise, each entry in the command line vector is a literal
-  // argument to the compiler.
-  // The output field may be a nullptr.
-  using CompileCommandRef =
-      std::tuple<llvm::yaml::ScalarNode *, llvm::yaml::ScalarNode *,
-                 std::vector<llvm::yaml::ScalarNode *>,
-                 llvm::yaml::ScalarNode *>;
-
-  /// Converts the given array of CompileCommandRefs to CompileCommands.
-  void getCommands(ArrayRef<CompileCommandRef> CommandsRef,
-                   std::vector<CompileCommand> &Commands) const;
-
-  // Maps file paths to the compile command lines for that file.
-  llvm::StringMap<std::vector<CompileCommandRef>> IndexByFile;
+  /// Parses the database file with the JSON scanner. Returns false without
+  /// adding any command if the database is not plain JSON.
+  bool parseJSON(std::string &ErrorMessage);
+
+  /// Parses the database file with the YAML parser, which also accepts the
+  /// YAML syntax that isn't JSON. The values are re-encoded as JSON strings
+  /// in YAMLValues, so they are decoded like those of a JSON database.
+  bool parseYAML(std::string &ErrorMessage);
+
+  /// Reads the entries from the index file \p IndexPath, which must have been
+  /// written for a database file with the same size and contents.
+  ///
+  /// Returns false if the index is missing, stale or malformed.
+  bool readIndex(StringRef IndexPath);
+
+  /// Writes the entries to the index file \p IndexPath.
+  void writeIndex(StringRef IndexPath) const;
+
+  /// Adds a compile command for the file \p NativeFilePath to AllCommands,
+  /// IndexByFile and MatchTrie.
+  void addCommand(const CompileCommandRef &Command, StringRef NativeFilePath);
+
+  /// Decodes the given CompileCommandRef into a CompileCommand.
+  CompileCommand getCommand(const CompileCommandRef &CommandRef) const;
+
+  // Maps file paths to the indices of the compile commands for that file.
+  llvm::StringMap<std::vector<unsigned>> IndexByFile;
 
   /// All the compile commands in the order that they were provided in the
   /// JSON stream.
   std::vector<CompileCommandRef> AllCommands;
 
+  /// The file paths of AllCommands, as used in IndexByFile.
+  std::vector<StringRef> CommandFiles;
+
   FileMatchTrie MatchTrie;
 
   std::unique_ptr<llvm::MemoryBuffer> Database;
   JSONCommandLineSyntax Syntax;
-  llvm::SourceMgr SM;
-  llvm::yaml::Stream YAMLStream;
+
+  /// The re-encoded values of a database parsed with the YAML parser.
+  llvm::BumpPtrAllocator YAMLValues;
+
+  /// Whether the database was parsed with the YAML parser, in which case the
+  /// values are not in the database buffer and it can't be indexed.
+  bool ParsedAsYAML = false;
+
+  bool LoadedFromIndex = false;
 };
 
 } // namespace tooling
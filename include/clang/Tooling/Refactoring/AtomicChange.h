@@ -20,6 +20,8 @@
 #include "clang/Tooling/Core/Replacement.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include <map>
 
 namespace clang {
 namespace tooling {
@@ -173,6 +175,24 @@ applyAtomicChanges(llvm::StringRef FilePath, llvm::StringRef Code,
                    llvm::ArrayRef<AtomicChange> Changes,
                    const ApplyChangesSpec &Spec);
 
+/// Applies all AtomicChanges in \p Changes to the files they refer to.
+///
+/// The changes are grouped by their file path, and the changes of each file
+/// are applied to its contents in \p FS with applyAtomicChanges(), including
+/// the cleanup and formatting of the affected ranges requested by \p Spec.
+/// The files are processed concurrently on \p NumThreads threads; if
+/// \p NumThreads is 0, the number of hardware threads is used. \p FS must
+/// support concurrent reads.
+///
+/// \returns A map from file path to changed code if all changes are applied
+/// successfully; otherwise, an llvm::Error joining the errors of all files
+/// that failed, in the order of their file paths.
+llvm::Expected<std::map<std::string, std::string>>
+applyAtomicChangesInFiles(llvm::ArrayRef<AtomicChange> Changes,
+                          llvm::vfs::FileSystem &FS,
+                          const ApplyChangesSpec &Spec,
+                          unsigned NumThreads = 0);
+
 } // end namespace tooling
 } // end namespace clang
 
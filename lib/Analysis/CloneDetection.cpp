@@ -15,8 +15,14 @@
 
 #include "clang/AST/DataCollection.h"
 #include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <tuple>
 
 using namespace clang;
 
@@ -628,3 +634,257 @@ unsigned VariablePattern::countPatternDifferences(
 
   return NumberOfDifferences;
 }
+
+void VariablePattern::addToHash(llvm::MD5 &Hash) const {
+  for (const VariableOccurence &Occurence : Occurences) {
+    uint64_t KindID = Occurence.KindID;
+    Hash.update(
+        StringRef(reinterpret_cast<const char *>(&KindID), sizeof(KindID)));
+  }
+}
+
+namespace {
+/// Computes the fingerprints of the statements in a code body that have at
+/// least a given complexity.
+///
+/// The hashes are computed bottom-up like in saveHash, except that they are
+/// not truncated. Only whole statements are fingerprinted, so a CompoundStmt
+/// contributes the sequence of all its children but none of its proper
+/// sub-sequences, and the number of fingerprints is linear in the size of the
+/// body. The fingerprints are linked to their parent statements once the
+/// whole body was visited.
+class CloneFingerprintBuilder {
+  const Decl *D;
+  ASTContext &Context;
+  unsigned MinComplexity;
+  MinComplexityConstraint Complexity;
+  std::vector<CloneFingerprint> &Result;
+
+  /// The lower half of the hash of every fingerprinted statement.
+  llvm::DenseMap<const Stmt *, uint64_t> Hashes;
+
+  /// The parent statements of the fingerprints added to Result.
+  std::vector<std::pair<size_t, const Stmt *>> Parents;
+
+public:
+  CloneFingerprintBuilder(const Stmt *Body, const Decl *D,
+                          unsigned MinComplexity,
+                          std::vector<CloneFingerprint> &Result)
+      : D(D), Context(D->getASTContext()), MinComplexity(MinComplexity),
+        Complexity(MinComplexity), Result(Result) {
+    visit(Body, nullptr);
+
+    for (const auto &P : Parents) {
+      auto It = Hashes.find(P.second);
+      if (It != Hashes.end())
+        Result[P.first].ParentHash = It->second;
+    }
+  }
+
+private:
+  llvm::MD5::MD5Result visit(const Stmt *S, const Stmt *Parent) {
+    llvm::MD5 Hash;
+    CloneTypeIIStmtDataCollector<llvm::MD5>(S, Context, Hash);
+
+    for (const Stmt *Child : S->children()) {
+      if (Child)
+        Hash.update(visit(Child, S).Bytes);
+    }
+
+    llvm::MD5::MD5Result HashResult;
+    Hash.final(HashResult);
+    StmtSequence Seq(S, D);
+    if (Complexity.calculateStmtComplexity(Seq, MinComplexity) >=
+        MinComplexity)
+      addFingerprint(Seq, HashResult, Parent);
+    return HashResult;
+  }
+
+  void addFingerprint(const StmtSequence &Seq,
+                      const llvm::MD5::MD5Result &DataHash,
+                      const Stmt *Parent) {
+    // The location is taken from the file itself rather than from the
+    // presumed location, so that #line directives don't change which
+    // fingerprints of a header are recognized as the same code.
+    const SourceManager &SM = Context.getSourceManager();
+    SourceLocation Begin = SM.getExpansionLoc(Seq.getBeginLoc());
+    SourceLocation End = SM.getExpansionLoc(Seq.getEndLoc());
+    const FileEntry *File = SM.getFileEntryForID(SM.getFileID(Begin));
+    if (!File || End.isInvalid())
+      return;
+
+    // The pattern is part of the hash so that only clones with matching
+    // variable patterns end up in the same group.
+    llvm::MD5 Hash;
+    Hash.update(DataHash.Bytes);
+    VariablePattern(Seq).addToHash(Hash);
+    llvm::MD5::MD5Result HashResult;
+    Hash.final(HashResult);
+
+    CloneFingerprint Fingerprint;
+    Fingerprint.HashHigh = HashResult.high();
+    Fingerprint.HashLow = HashResult.low();
+    Fingerprint.Filename = File->tryGetRealPathName();
+    if (Fingerprint.Filename.empty())
+      Fingerprint.Filename = File->getName();
+    Fingerprint.BeginLine = SM.getSpellingLineNumber(Begin);
+    Fingerprint.BeginColumn = SM.getSpellingColumnNumber(Begin);
+    Fingerprint.EndLine = SM.getSpellingLineNumber(End);
+    Fingerprint.EndColumn = SM.getSpellingColumnNumber(End);
+
+    Hashes[Seq.front()] = Fingerprint.HashLow;
+    Parents.emplace_back(Result.size(), Parent);
+    Result.push_back(std::move(Fingerprint));
+  }
+};
+} // end anonymous namespace
+
+void CloneDetector::collectFingerprints(std::vector<CloneFingerprint> &Result,
+                                        unsigned MinComplexity,
+                                        StringRef IgnoredFilesPattern) const {
+  FilenamePatternConstraint FilenameConstraint(IgnoredFilesPattern);
+  for (const StmtSequence &Body : Sequences) {
+    if (FilenameConstraint.isAutoGenerated(CloneGroup{Body}))
+      continue;
+    CloneFingerprintBuilder(Body.front(), Body.getContainingDecl(),
+                            MinComplexity, Result);
+  }
+}
+
+void clang::writeCloneFingerprints(ArrayRef<CloneFingerprint> Fingerprints,
+                                   raw_ostream &OS) {
+  OS << "clone-fingerprints\n";
+  StringRef Filename;
+  for (const CloneFingerprint &F : Fingerprints) {
+    if (F.Filename != Filename || &F == Fingerprints.begin()) {
+      Filename = F.Filename;
+      OS << "file " << Filename << '\n';
+    }
+    OS << llvm::format_hex_no_prefix(F.HashHigh, 16)
+       << llvm::format_hex_no_prefix(F.HashLow, 16) << ' '
+       << llvm::format_hex_no_prefix(F.ParentHash, 16) << ' '
+       << F.BeginLine << ':' << F.BeginColumn << ' ' << F.EndLine << ':'
+       << F.EndColumn << '\n';
+  }
+}
+
+/// Parses a "line:column" pair.
+/// \returns true if an error occurred.
+static bool parseLineAndColumn(StringRef Str, unsigned &Line,
+                               unsigned &Column) {
+  StringRef LineStr, ColumnStr;
+  std::tie(LineStr, ColumnStr) = Str.split(':');
+  return LineStr.getAsInteger(10, Line) || ColumnStr.getAsInteger(10, Column);
+}
+
+llvm::Error
+clang::readCloneFingerprints(StringRef Buffer,
+                             std::vector<CloneFingerprint> &Result) {
+  StringRef Line;
+  std::tie(Line, Buffer) = Buffer.split('\n');
+  if (Line != "clone-fingerprints")
+    return llvm::make_error<llvm::StringError>(
+        "not a clone fingerprint file", llvm::inconvertibleErrorCode());
+
+  StringRef Filename;
+  unsigned LineNumber = 1;
+  while (!Buffer.empty()) {
+    std::tie(Line, Buffer) = Buffer.split('\n');
+    ++LineNumber;
+    if (Line.empty())
+      continue;
+    if (Line.consume_front("file ")) {
+      Filename = Line;
+      continue;
+    }
+
+    SmallVector<StringRef, 4> Fields;
+    Line.split(Fields, ' ');
+    CloneFingerprint F;
+    if (Filename.empty() || Fields.size() != 4 || Fields[0].size() != 32 ||
+        Fields[0].take_front(16).getAsInteger(16, F.HashHigh) ||
+        Fields[0].drop_front(16).getAsInteger(16, F.HashLow) ||
+        Fields[1].getAsInteger(16, F.ParentHash) ||
+        parseLineAndColumn(Fields[2], F.BeginLine, F.BeginColumn) ||
+        parseLineAndColumn(Fields[3], F.EndLine, F.EndColumn))
+      return llvm::make_error<llvm::StringError>(
+          "malformed clone fingerprint at line " + Twine(LineNumber),
+          llvm::inconvertibleErrorCode());
+    F.Filename = Filename;
+    Result.push_back(std::move(F));
+  }
+  return llvm::Error::success();
+}
+
+static auto getLocationTuple(const CloneFingerprint &F)
+    -> decltype(std::tie(F.Filename, F.BeginLine, F.BeginColumn, F.EndLine,
+                         F.EndColumn)) {
+  return std::tie(F.Filename, F.BeginLine, F.BeginColumn, F.EndLine,
+                  F.EndColumn);
+}
+
+std::vector<std::vector<CloneFingerprint>>
+clang::findClonesInFingerprints(std::vector<CloneFingerprint> Fingerprints) {
+  // Sort by the lower half of the hash first, so that the number of
+  // fingerprints with a given parent hash can be looked up by binary search.
+  llvm::sort(Fingerprints, [](const CloneFingerprint &LHS,
+                              const CloneFingerprint &RHS) {
+    return std::tuple_cat(std::tie(LHS.HashLow, LHS.HashHigh),
+                          getLocationTuple(LHS)) <
+           std::tuple_cat(std::tie(RHS.HashLow, RHS.HashHigh),
+                          getLocationTuple(RHS));
+  });
+
+  // A header that is included by several translation units is fingerprinted
+  // by each of them.
+  Fingerprints.erase(
+      std::unique(Fingerprints.begin(), Fingerprints.end(),
+                  [](const CloneFingerprint &LHS, const CloneFingerprint &RHS) {
+                    return LHS.HashLow == RHS.HashLow &&
+                           LHS.HashHigh == RHS.HashHigh &&
+                           getLocationTuple(LHS) == getLocationTuple(RHS);
+                  }),
+      Fingerprints.end());
+
+  auto countWithHash = [&Fingerprints](uint64_t HashLow) {
+    auto Begin = std::lower_bound(
+        Fingerprints.begin(), Fingerprints.end(), HashLow,
+        [](const CloneFingerprint &F, uint64_t H) { return F.HashLow < H; });
+    auto End = std::upper_bound(
+        Begin, Fingerprints.end(), HashLow,
+        [](uint64_t H, const CloneFingerprint &F) { return H < F.HashLow; });
+    return static_cast<size_t>(End - Begin);
+  };
+
+  std::vector<std::vector<CloneFingerprint>> Result;
+  for (auto GroupBegin = Fingerprints.begin();
+       GroupBegin != Fingerprints.end();) {
+    auto GroupEnd = std::find_if(
+        GroupBegin, Fingerprints.end(), [&](const CloneFingerprint &F) {
+          return F.HashLow != GroupBegin->HashLow ||
+                 F.HashHigh != GroupBegin->HashHigh;
+        });
+    size_t GroupSize = GroupEnd - GroupBegin;
+
+    // If every clone in the group is part of a clone of the same larger
+    // group, the larger group already covers this one.
+    uint64_t ParentHash = GroupBegin->ParentHash;
+    bool IsContained =
+        GroupSize > 1 && ParentHash != 0 &&
+        std::all_of(GroupBegin, GroupEnd,
+                    [&](const CloneFingerprint &F) {
+                      return F.ParentHash == ParentHash;
+                    }) &&
+        countWithHash(ParentHash) >= GroupSize;
+
+    if (GroupSize > 1 && !IsContained)
+      Result.emplace_back(GroupBegin, GroupEnd);
+    GroupBegin = GroupEnd;
+  }
+
+  llvm::sort(Result, [](const std::vector<CloneFingerprint> &LHS,
+                        const std::vector<CloneFingerprint> &RHS) {
+    return getLocationTuple(LHS.front()) < getLocationTuple(RHS.front());
+  });
+  return Result;
+}
@@ -31,7 +31,9 @@
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/PackedVector.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Casting.h"
 #include <algorithm>
@@ -63,8 +65,10 @@ class DeclToIndex {
 public:
   DeclToIndex() = default;
 
-  /// Compute the actual mapping from declarations to bits.
-  void computeMap(const DeclContext &dc);
+  /// Compute the actual mapping from declarations to bits for the tracked
+  /// variables of \p dc that are in \p relevant.
+  void computeMap(const DeclContext &dc,
+                  const llvm::SmallPtrSetImpl<const VarDecl *> &relevant);
 
   /// Return the number of declarations in the map.
   unsigned size() const { return map.size(); }
@@ -75,13 +79,15 @@ public:
 
 } // namespace
 
-void DeclToIndex::computeMap(const DeclContext &dc) {
+void DeclToIndex::computeMap(
+    const DeclContext &dc,
+    const llvm::SmallPtrSetImpl<const VarDecl *> &relevant) {
   unsigned count = 0;
   DeclContext::specific_decl_iterator<VarDecl> I(dc.decls_begin()),
                                                E(dc.decls_end());
   for ( ; I != E; ++I) {
     const VarDecl *vd = *I;
-    if (isTrackedVar(vd, &dc))
+    if (relevant.count(vd) && isTrackedVar(vd, &dc))
       map[vd] = count++;
   }
 }
@@ -127,7 +133,13 @@ public:
 
   unsigned getNumEntries() const { return declToIndex.size(); }
 
-  void computeSetOfDeclarations(const DeclContext &dc);
+  void computeSetOfDeclarations(
+      const DeclContext &dc,
+      const llvm::SmallPtrSetImpl<const VarDecl *> &relevant);
+
+  bool hasEntry(const VarDecl *vd) const {
+    return declToIndex.getValueIndex(vd).hasValue();
+  }
 
   ValueVector &getValueVector(const CFGBlock *block) {
     return vals[block->getBlockID()];
@@ -157,8 +169,10 @@ public:
 
 CFGBlockValues::CFGBlockValues(const CFG &c) : cfg(c), vals(0) {}
 
-void CFGBlockValues::computeSetOfDeclarations(const DeclContext &dc) {
-  declToIndex.computeMap(dc);
+void CFGBlockValues::computeSetOfDeclarations(
+    const DeclContext &dc,
+    const llvm::SmallPtrSetImpl<const VarDecl *> &relevant) {
+  declToIndex.computeMap(dc, relevant);
   unsigned decls = declToIndex.size();
   scratch.resize(decls);
   unsigned n = cfg.getNumBlockIDs();
@@ -337,6 +351,9 @@ private:
   const DeclContext *DC;
   llvm::DenseMap<const DeclRefExpr *, Class> Classification;
 
+  /// Tracked variables that are captured by copy by a block.
+  llvm::SmallPtrSet<const VarDecl *, 4> CapturedByCopy;
+
   bool isTrackedVar(const VarDecl *VD) const {
     return ::isTrackedVar(VD, DC);
   }
@@ -346,6 +363,7 @@ private:
 public:
   ClassifyRefs(AnalysisDeclContext &AC) : DC(cast<DeclContext>(AC.getDecl())) {}
 
+  void VisitBlockExpr(BlockExpr *BE);
   void VisitDeclStmt(DeclStmt *DS);
   void VisitUnaryOperator(UnaryOperator *UO);
   void VisitBinaryOperator(BinaryOperator *BO);
@@ -354,6 +372,12 @@ public:
 
   void operator()(Stmt *S) { Visit(S); }
 
+  /// Collects the variables that may be reported as used uninitialized, i.e.
+  /// those with a reference classified as a use or self-initialization, or
+  /// that are captured by copy by a block.
+  void collectPossiblyUsedVars(
+      llvm::SmallPtrSetImpl<const VarDecl *> &Vars) const;
+
   Class get(const DeclRefExpr *DRE) const {
     llvm::DenseMap<const DeclRefExpr*, Class>::const_iterator I
         = Classification.find(DRE);
@@ -428,6 +452,20 @@ void ClassifyRefs::classify(const Expr *E, Class C) {
     Classification[DRE] = std::max(Classification[DRE], C);
 }
 
+void ClassifyRefs::collectPossiblyUsedVars(
+    llvm::SmallPtrSetImpl<const VarDecl *> &Vars) const {
+  for (const auto &P : Classification)
+    if (P.second == Use || P.second == SelfInit)
+      Vars.insert(cast<VarDecl>(P.first->getDecl()));
+  Vars.insert(CapturedByCopy.begin(), CapturedByCopy.end());
+}
+
+void ClassifyRefs::VisitBlockExpr(BlockExpr *BE) {
+  for (const auto &I : BE->getBlockDecl()->captures())
+    if (!I.isByRef() && isTrackedVar(I.getVariable()))
+      CapturedByCopy.insert(I.getVariable());
+}
+
 void ClassifyRefs::VisitDeclStmt(DeclStmt *DS) {
   for (auto *DI : DS->decls()) {
     auto *VD = dyn_cast<VarDecl>(DI);
@@ -534,9 +572,9 @@ public:
   void VisitObjCForCollectionStmt(ObjCForCollectionStmt *FS);
   void VisitObjCMessageExpr(ObjCMessageExpr *ME);
 
-  bool isTrackedVar(const VarDecl *vd) {
-    return ::isTrackedVar(vd, cast<DeclContext>(ac.getDecl()));
-  }
+  /// Returns true if the analysis computes values for \p vd, i.e. \p vd is a
+  /// tracked variable that may be reported.
+  bool isTrackedVar(const VarDecl *vd) { return vals.hasEntry(vd); }
 
   FindVarResult findVar(const Expr *ex) {
     return ::findVar(ex, cast<DeclContext>(ac.getDecl()));
@@ -694,6 +732,8 @@ public:
 } // namespace
 
 void TransferFunctions::reportUse(const Expr *ex, const VarDecl *vd) {
+  if (!isTrackedVar(vd))
+    return;
   Value v = vals[vd];
   if (isUninitialized(v))
     handler.handleUseOfUninitVariable(vd, getUninitUse(ex, vd, v));
@@ -753,7 +793,8 @@ void TransferFunctions::VisitDeclRefExpr(DeclRefExpr *dr) {
     reportUse(dr, cast<VarDecl>(dr->getDecl()));
     break;
   case ClassifyRefs::Init:
-    vals[cast<VarDecl>(dr->getDecl())] = Initialized;
+    if (isTrackedVar(cast<VarDecl>(dr->getDecl())))
+      vals[cast<VarDecl>(dr->getDecl())] = Initialized;
     break;
   case ClassifyRefs::SelfInit:
       handler.handleSelfInit(cast<VarDecl>(dr->getDecl()));
@@ -765,7 +806,8 @@ void TransferFunctions::VisitBinaryOperator(BinaryOperator *BO) {
   if (BO->getOpcode() == BO_Assign) {
     FindVarResult Var = findVar(BO->getLHS());
     if (const VarDecl *VD = Var.getDecl())
-      vals[VD] = Initialized;
+      if (isTrackedVar(VD))
+        vals[VD] = Initialized;
   }
 }
 
@@ -817,6 +859,23 @@ void TransferFunctions::VisitObjCMessageExpr(ObjCMessageExpr *ME) {
 // High-level "driver" logic for uninitialized values analysis.
 //====------------------------------------------------------------------------//
 
+/// Returns true if \p S refers to \p vd, directly or through the captures of
+/// a block.
+static bool refersToVar(const Stmt *S, const VarDecl *vd) {
+  if (!S)
+    return false;
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S))
+    if (DRE->getDecl() == vd)
+      return true;
+  if (const auto *BE = dyn_cast<BlockExpr>(S))
+    if (BE->getBlockDecl()->capturesVariable(vd))
+      return true;
+  for (const Stmt *Child : S->children())
+    if (refersToVar(Child, vd))
+      return true;
+  return false;
+}
+
 static bool runOnBlock(const CFGBlock *block, const CFG &cfg,
                        AnalysisDeclContext &ac, CFGBlockValues &vals,
                        const ClassifyRefs &classification,
@@ -888,17 +947,38 @@ void clang::runUninitializedVariablesAnalysis(
     AnalysisDeclContext &ac,
     UninitVariablesHandler &handler,
     UninitVariablesAnalysisStats &stats) {
-  CFGBlockValues vals(cfg);
-  vals.computeSetOfDeclarations(dc);
-  if (vals.hasNoDeclarations())
+  if (llvm::none_of(dc.decls(), [&dc](const Decl *D) {
+        const auto *vd = dyn_cast<VarDecl>(D);
+        return vd && isTrackedVar(vd, &dc);
+      }))
     return;
 
-  stats.NumVariablesAnalyzed = vals.getNumEntries();
-
   // Precompute which expressions are uses and which are initializations.
   ClassifyRefs classification(ac);
   cfg.VisitBlockStmts(classification);
 
+  // Only compute values for the variables that may be reported. The values
+  // of a variable only depend on the references to that variable, so the
+  // other variables do not need to be tracked. This keeps the per-block
+  // value vectors small in functions with many locals.
+  //
+  // In C++, a jump may not bypass the initialization of a variable, so a
+  // variable with an initializer is initialized wherever it is referenced,
+  // unless it is referenced by its own initializer.
+  llvm::SmallPtrSet<const VarDecl *, 32> possiblyUsed, relevant;
+  classification.collectPossiblyUsedVars(possiblyUsed);
+  bool isCPlusPlus = ac.getASTContext().getLangOpts().CPlusPlus;
+  for (const VarDecl *vd : possiblyUsed)
+    if (!isCPlusPlus || !vd->getInit() || refersToVar(vd->getInit(), vd))
+      relevant.insert(vd);
+
+  CFGBlockValues vals(cfg);
+  vals.computeSetOfDeclarations(dc, relevant);
+  if (vals.hasNoDeclarations())
+    return;
+
+  stats.NumVariablesAnalyzed = vals.getNumEntries();
+
   // Mark all variables uninitialized at the entry.
   const CFGBlock &entry = cfg.getEntry();
   ValueVector &vec = vals.getValueVector(&entry);
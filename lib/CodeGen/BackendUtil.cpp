@@ -28,7 +28,10 @@
 #include "llvm/CodeGen/SchedulerRegistry.h"
 #include "llvm/CodeGen/TargetSubtargetInfo.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DiagnosticHandler.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/IRPrintingPasses.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
@@ -42,6 +45,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -61,9 +65,13 @@
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "llvm/Transforms/Utils.h"
 #include "llvm/Transforms/Utils/CheriSetBounds.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/NameAnonGlobals.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "llvm/Transforms/Utils/SymbolRewriter.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
 using namespace clang;
 using namespace llvm;
 
@@ -103,12 +111,31 @@ class EmitAssemblyHelper {
   /// the requested target.
   void CreateTargetMachine(bool MustCreateTM);
 
+  /// Creates a new TargetMachine for the module's triple, configured from the
+  /// code generation options. Returns null and sets \p Error if the target is
+  /// not available.
+  std::unique_ptr<TargetMachine> createTargetMachine(std::string &Error) const;
+
   /// Add passes necessary to emit assembly or LLVM IR.
   ///
   /// \return True on success.
   bool AddEmitPasses(legacy::PassManager &CodeGenPasses, BackendAction Action,
                      raw_pwrite_stream &OS, raw_pwrite_stream *DwoOS);
 
+  /// Whether machine code generation should be split into partitions, one
+  /// for the main output and one per -parallel-codegen-output file.
+  bool usesParallelCodeGen(BackendAction Action) const {
+    return Action == Backend_EmitObj &&
+           !CodeGenOpts.ParallelCodeGenOutputs.empty();
+  }
+
+  /// Split the optimized module into partitions and run code generation for
+  /// each of them on up to CodeGenOpts.ParallelCodeGen threads. The first
+  /// partition is written to \p OS.
+  ///
+  /// \return True on success.
+  bool EmitParallelCodeGen(BackendAction Action, raw_pwrite_stream &OS);
+
   std::unique_ptr<llvm::ToolOutputFile> openOutputFile(StringRef Path) {
     std::error_code EC;
     auto F = llvm::make_unique<llvm::ToolOutputFile>(Path, EC,
@@ -747,16 +774,12 @@ static void setCommandLineOpts(const CodeGenOptions &CodeGenOpts) {
                                     BackendArgs.data());
 }
 
-void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
-  // Create the TargetMachine for generating code.
-  std::string Error;
+std::unique_ptr<TargetMachine>
+EmitAssemblyHelper::createTargetMachine(std::string &Error) const {
   std::string Triple = TheModule->getTargetTriple();
   const llvm::Target *TheTarget = TargetRegistry::lookupTarget(Triple, Error);
-  if (!TheTarget) {
-    if (MustCreateTM)
-      Diags.Report(diag::err_fe_unable_to_create_target) << Error;
-    return;
-  }
+  if (!TheTarget)
+    return nullptr;
 
   Optional<llvm::CodeModel::Model> CM = getCodeModel(CodeGenOpts);
   std::string FeaturesStr =
@@ -766,8 +789,16 @@ void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
 
   llvm::TargetOptions Options;
   initTargetOptions(Options, CodeGenOpts, TargetOpts, LangOpts, HSOpts);
-  TM.reset(TheTarget->createTargetMachine(Triple, TargetOpts.CPU, FeaturesStr,
-                                          Options, RM, CM, OptLevel));
+  return std::unique_ptr<TargetMachine>(TheTarget->createTargetMachine(
+      Triple, TargetOpts.CPU, FeaturesStr, Options, RM, CM, OptLevel));
+}
+
+void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
+  // Create the TargetMachine for generating code.
+  std::string Error;
+  TM = createTargetMachine(Error);
+  if (!TM && MustCreateTM)
+    Diags.Report(diag::err_fe_unable_to_create_target) << Error;
 }
 
 bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
@@ -799,6 +830,170 @@ bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
   return true;
 }
 
+namespace {
+/// Passes the diagnostics of a parallel code generation thread to the
+/// handlers of the main context, which report them through clang's
+/// DiagnosticsEngine. The handlers are not thread safe, so only one
+/// diagnostic is passed on at a time.
+class ForwardingDiagnosticHandler final : public DiagnosticHandler {
+public:
+  ForwardingDiagnosticHandler(LLVMContext &MainCtx, std::mutex &Lock)
+      : MainCtx(MainCtx), Lock(Lock) {}
+
+  bool handleDiagnostics(const DiagnosticInfo &DI) override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    MainCtx.diagnose(DI);
+    return true;
+  }
+
+  bool isAnalysisRemarkEnabled(StringRef PassName) const override {
+    return MainCtx.getDiagHandlerPtr()->isAnalysisRemarkEnabled(PassName);
+  }
+  bool isMissedOptRemarkEnabled(StringRef PassName) const override {
+    return MainCtx.getDiagHandlerPtr()->isMissedOptRemarkEnabled(PassName);
+  }
+  bool isPassedOptRemarkEnabled(StringRef PassName) const override {
+    return MainCtx.getDiagHandlerPtr()->isPassedOptRemarkEnabled(PassName);
+  }
+  bool isAnyRemarkEnabled() const override {
+    return MainCtx.getDiagHandlerPtr()->isAnyRemarkEnabled();
+  }
+
+  /// Creates a handler for \p Ctx that passes its diagnostics, including
+  /// those of inline assembly, to \p MainCtx.
+  static void install(LLVMContext &Ctx, LLVMContext &MainCtx,
+                      std::mutex &Lock) {
+    auto Handler =
+        llvm::make_unique<ForwardingDiagnosticHandler>(MainCtx, Lock);
+    if (MainCtx.getInlineAsmDiagnosticHandler())
+      Ctx.setInlineAsmDiagnosticHandler(handleInlineAsmDiagnostic,
+                                        Handler.get());
+    Ctx.setDiagnosticHandler(std::move(Handler));
+  }
+
+private:
+  static void handleInlineAsmDiagnostic(const SMDiagnostic &D, void *Context,
+                                        unsigned LocCookie) {
+    auto *Handler = static_cast<ForwardingDiagnosticHandler *>(Context);
+    LLVMContext &MainCtx = Handler->MainCtx;
+    std::lock_guard<std::mutex> Guard(Handler->Lock);
+    MainCtx.getInlineAsmDiagnosticHandler()(
+        D, MainCtx.getInlineAsmDiagnosticContext(), LocCookie);
+  }
+
+  LLVMContext &MainCtx;
+  std::mutex &Lock;
+};
+} // namespace
+
+bool EmitAssemblyHelper::EmitParallelCodeGen(BackendAction Action,
+                                             raw_pwrite_stream &OS) {
+  SmallVector<std::unique_ptr<llvm::ToolOutputFile>, 4> PartFiles;
+  SmallVector<raw_pwrite_stream *, 4> PartOSs;
+  PartOSs.push_back(&OS);
+  for (const std::string &Path : CodeGenOpts.ParallelCodeGenOutputs) {
+    PartFiles.push_back(openOutputFile(Path));
+    if (!PartFiles.back())
+      return false;
+    PartOSs.push_back(&PartFiles.back()->os());
+  }
+
+  // Each partition gets its own TargetMachine. Create them up front so that
+  // any failure is diagnosed on this thread.
+  std::vector<std::unique_ptr<TargetMachine>> PartTMs;
+  for (unsigned I = 0, E = PartOSs.size(); I != E; ++I) {
+    std::string Error;
+    PartTMs.push_back(createTargetMachine(Error));
+    if (!PartTMs.back()) {
+      Diags.Report(diag::err_fe_unable_to_create_target) << Error;
+      return false;
+    }
+  }
+
+  // SplitModule consumes its input, so partition a copy and leave TheModule
+  // untouched for the caller. The partitions still share TheModule's context,
+  // which is not thread safe, so serialize each of them to bitcode here and
+  // let the worker threads load them into contexts of their own. Local
+  // symbols are kept with their users so that no symbol has to be renamed or
+  // externalized, and the linked partitions match a serial compile.
+  std::vector<SmallString<0>> PartBitcode;
+  SplitModule(CloneModule(*TheModule), PartOSs.size(),
+              [&](std::unique_ptr<Module> MPart) {
+                PartBitcode.emplace_back();
+                raw_svector_ostream BCOS(PartBitcode.back());
+                WriteBitcodeToFile(*MPart, BCOS);
+              },
+              /*PreserveLocals=*/true);
+  assert(PartBitcode.size() == PartOSs.size() &&
+         "SplitModule produced an unexpected number of partitions");
+
+  // The CSetBounds statistics are a process-wide log that the backend appends
+  // to without locking. The IR-level logging pass has already run over the
+  // whole module, so only the machine-level passes need to be serialized.
+  unsigned Threads = cheri::ShouldCollectCSetBoundsStats
+                         ? 1
+                         : std::min<unsigned>(CodeGenOpts.ParallelCodeGen,
+                                              PartOSs.size());
+  // Errors are only recorded on the worker threads and reported once all of
+  // them are done. Backend diagnostics are passed to the main context as they
+  // happen, so that they reach clang's DiagnosticsEngine instead of the
+  // default handler of the worker's context, which exits on errors.
+  std::atomic<bool> Failed(false);
+  std::vector<std::string> ReadErrors(PartOSs.size());
+  std::mutex DiagLock;
+  {
+    PrettyStackTraceString CrashInfo("Parallel code generation");
+    ThreadPool CodeGenThreadPool(Threads);
+    for (unsigned I = 0, E = PartOSs.size(); I != E; ++I) {
+      CodeGenThreadPool.async([&, I] {
+        LLVMContext Ctx;
+        ForwardingDiagnosticHandler::install(Ctx, TheModule->getContext(),
+                                             DiagLock);
+        Expected<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
+            MemoryBufferRef(StringRef(PartBitcode[I].data(),
+                                      PartBitcode[I].size()),
+                            "<split-module>"),
+            Ctx);
+        if (!MOrErr) {
+          ReadErrors[I] = toString(MOrErr.takeError());
+          return;
+        }
+        std::unique_ptr<Module> MPart = std::move(*MOrErr);
+        TargetMachine &PartTM = *PartTMs[I];
+
+        legacy::PassManager CodeGenPasses;
+        CodeGenPasses.add(
+            createTargetTransformInfoWrapperPass(PartTM.getTargetIRAnalysis()));
+        llvm::Triple TargetTriple(MPart->getTargetTriple());
+        std::unique_ptr<TargetLibraryInfoImpl> TLII(
+            createTLII(TargetTriple, CodeGenOpts));
+        CodeGenPasses.add(new TargetLibraryInfoWrapperPass(*TLII));
+        if (CodeGenOpts.OptimizationLevel > 0)
+          CodeGenPasses.add(createObjCARCContractPass());
+        if (PartTM.addPassesToEmitFile(
+                CodeGenPasses, *PartOSs[I], nullptr, getCodeGenFileType(Action),
+                /*DisableVerify=*/!CodeGenOpts.VerifyModule)) {
+          Failed = true;
+          return;
+        }
+        CodeGenPasses.run(*MPart);
+      });
+    }
+  }
+
+  for (const std::string &Error : ReadErrors)
+    if (!Error.empty())
+      Diags.Report(diag::err_fe_unable_to_read_split_module) << Error;
+  if (Failed)
+    Diags.Report(diag::err_fe_unable_to_interface_with_target);
+  if (Failed || Diags.hasErrorOccurred())
+    return false;
+
+  for (auto &F : PartFiles)
+    F->keep();
+  return true;
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
                                       std::unique_ptr<raw_pwrite_stream> OS) {
   TimeRegion Region(FrontendTimesIsEnabled ? &CodeGenerationTime : nullptr);
@@ -867,6 +1062,10 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
     break;
 
   default:
+    // Parallel code generation sets up its own pipelines once the module has
+    // been optimized and split.
+    if (usesParallelCodeGen(Action))
+      break;
     if (!CodeGenOpts.SplitDwarfFile.empty() &&
         (CodeGenOpts.getSplitDwarfMode() == CodeGenOptions::SplitFileFission)) {
       DwoOS = openOutputFile(CodeGenOpts.SplitDwarfFile);
@@ -899,7 +1098,10 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
     PerModulePasses.run(*TheModule);
   }
 
-  {
+  if (usesParallelCodeGen(Action)) {
+    if (!EmitParallelCodeGen(Action, *OS))
+      return;
+  } else {
     PrettyStackTraceString CrashInfo("Code generation");
     CodeGenPasses.run(*TheModule);
   }
@@ -1103,6 +1305,8 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   case Backend_EmitAssembly:
   case Backend_EmitMCNull:
   case Backend_EmitObj:
+    if (usesParallelCodeGen(Action))
+      break;
     NeedCodeGen = true;
     CodeGenPasses.add(
         createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
@@ -1131,6 +1335,9 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   if (NeedCodeGen) {
     PrettyStackTraceString CrashInfo("Code generation");
     CodeGenPasses.run(*TheModule);
+  } else if (usesParallelCodeGen(Action)) {
+    if (!EmitParallelCodeGen(Action, *OS))
+      return;
   }
 
   if (ThinLinkOS)
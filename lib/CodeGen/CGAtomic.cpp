@@ -516,6 +516,65 @@ static void emitAtomicCmpXchgFailureSet(CodeGenFunction &CGF, AtomicExpr *E,
   CGF.Builder.SetInsertPoint(ContBB);
 }
 
+/// There is no atomicrmw for capabilities, so emit capability fetch_add and
+/// fetch_sub as a compare-exchange loop that adjusts the offset of the loaded
+/// capability. The backend expands the cmpxchg into a capability LL/SC
+/// sequence, so this avoids a call to __atomic_fetch_{add,sub}_cap.
+static void emitCapabilityAtomicRMW(CodeGenFunction &CGF, AtomicExpr *E,
+                                    Address Dest, Address Ptr, Address Val1,
+                                    llvm::AtomicRMWInst::BinOp Op,
+                                    bool ReturnNewValue,
+                                    llvm::AtomicOrdering Order,
+                                    llvm::SyncScope::ID Scope) {
+  assert((Op == llvm::AtomicRMWInst::Add || Op == llvm::AtomicRMWInst::Sub) &&
+         "Unsupported capability atomic operation");
+  CGBuilderTy &Builder = CGF.Builder;
+  llvm::Type *CapTy = Ptr.getElementType();
+
+  // Val1 is the temporary holding the increment. For pointers it is the
+  // number of bytes to add. For __intcap_t and __uintcap_t it is a capability,
+  // and like ordinary __intcap_t arithmetic we add its integer value.
+  QualType IncTy = E->getVal1()->getType();
+  llvm::Value *Inc = Builder.CreateLoad(Val1, "atomicrmw.cap.inc");
+  if (IncTy->isCHERICapabilityType(CGF.getContext()))
+    Inc = CGF.getCapabilityIntegerValue(
+        Builder.CreateBitCast(Inc, CGF.Int8CheriCapTy));
+  else
+    Inc = Builder.CreateIntCast(Inc, CGF.PtrDiffTy,
+                                IncTy->isSignedIntegerOrEnumerationType());
+  if (Op == llvm::AtomicRMWInst::Sub)
+    Inc = Builder.CreateNeg(Inc);
+
+  llvm::LoadInst *Initial = Builder.CreateLoad(Ptr, "atomicrmw.cap.initial");
+  Initial->setAtomic(llvm::AtomicOrdering::Monotonic, Scope);
+  Initial->setVolatile(E->isVolatile());
+  llvm::BasicBlock *EntryBB = Builder.GetInsertBlock();
+  llvm::BasicBlock *LoopBB =
+      CGF.createBasicBlock("atomicrmw.cap.loop", CGF.CurFn);
+  llvm::BasicBlock *ContBB =
+      CGF.createBasicBlock("atomicrmw.cap.cont", CGF.CurFn);
+  Builder.CreateBr(LoopBB);
+
+  Builder.SetInsertPoint(LoopBB);
+  llvm::PHINode *Old = Builder.CreatePHI(CapTy, 2, "atomicrmw.cap.old");
+  Old->addIncoming(Initial, EntryBB);
+  llvm::Value *New = Builder.CreateBitCast(
+      Builder.CreateGEP(CGF.Int8Ty,
+                        Builder.CreateBitCast(Old, CGF.Int8CheriCapTy), Inc),
+      CapTy, "atomicrmw.cap.new");
+  llvm::AtomicCmpXchgInst *Pair = Builder.CreateAtomicCmpXchg(
+      Ptr.getPointer(), Old, New, Order,
+      llvm::AtomicCmpXchgInst::getStrongestFailureOrdering(Order), Scope);
+  Pair->setVolatile(E->isVolatile());
+  Pair->setWeak(true);
+  Old->addIncoming(Builder.CreateExtractValue(Pair, 0),
+                   Builder.GetInsertBlock());
+  Builder.CreateCondBr(Builder.CreateExtractValue(Pair, 1), ContBB, LoopBB);
+
+  Builder.SetInsertPoint(ContBB);
+  Builder.CreateStore(ReturnNewValue ? New : Old, Dest);
+}
+
 static void EmitAtomicOp(CodeGenFunction &CGF, AtomicExpr *E, Address Dest,
                          Address Ptr, Address Val1, Address Val2,
                          llvm::Value *IsWeak, llvm::Value *FailureOrder,
@@ -663,6 +722,13 @@ static void EmitAtomicOp(CodeGenFunction &CGF, AtomicExpr *E, Address Dest,
     break;
   }
 
+  if (E->getValueType()->isCHERICapabilityType(CGF.getContext()) &&
+      Op != llvm::AtomicRMWInst::Xchg) {
+    emitCapabilityAtomicRMW(CGF, E, Dest, Ptr, Val1, Op, PostOp != 0, Order,
+                            Scope);
+    return;
+  }
+
   llvm::Value *LoadVal1 = CGF.Builder.CreateLoad(Val1);
   llvm::AtomicRMWInst *RMWI =
       CGF.Builder.CreateAtomicRMW(Op, Ptr.getPointer(), LoadVal1, Order, Scope);
@@ -929,7 +995,12 @@ RValue CodeGenFunction::EmitAtomicExpr(AtomicExpr *E) {
   assert(Atomics.shouldUseLibcall() == UseLibcall);
 
   Ptr = Atomics.emitCastToAtomicIntPointer(Ptr);
-  if (Val1.isValid()) Val1 = Atomics.convertToAtomicIntPointer(Val1);
+  // emitCapabilityAtomicRMW() loads integer increments itself, so they must
+  // not be turned into a null-derived capability here.
+  bool IsInlineCapabilityRMW = IsCheriCap && !UseLibcall && Val1.isValid() &&
+                               Val1.getElementType()->isIntegerTy();
+  if (Val1.isValid() && !IsInlineCapabilityRMW)
+    Val1 = Atomics.convertToAtomicIntPointer(Val1);
   if (Val2.isValid()) Val2 = Atomics.convertToAtomicIntPointer(Val2);
   if (Dest.isValid())
     Dest = Atomics.emitCastToAtomicIntPointer(Dest);
@@ -7019,14 +7019,14 @@ public:
     case AtomicExpr::AO__c11_atomic_compare_exchange_weak:
     case AtomicExpr::AO__atomic_compare_exchange:
     case AtomicExpr::AO__atomic_compare_exchange_n:
-      return false;
+    // These are emitted as a cmpxchg loop that increments the offset.
     case AtomicExpr::AO__atomic_fetch_add:
     case AtomicExpr::AO__atomic_fetch_sub:
     case AtomicExpr::AO__atomic_add_fetch:
     case AtomicExpr::AO__atomic_sub_fetch:
     case AtomicExpr::AO__c11_atomic_fetch_add:
     case AtomicExpr::AO__c11_atomic_fetch_sub:
-      return true; // TODO: allow emitting this without a libcall
+      return false;
 
     default:
       llvm_unreachable("Atomic op should not be supported for capabilities");
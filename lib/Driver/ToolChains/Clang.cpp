@@ -5183,8 +5183,40 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       isa<CompileJobAction>(JA))
     CmdArgs.push_back("-disable-llvm-passes");
 
+  // With -fparallel-codegen=N, cc1 writes each of the N code generation
+  // partitions to a temporary object of its own and a relocatable link
+  // combines them into the requested output.
+  SmallVector<const char *, 4> ParallelCodeGenObjects;
+  if (Arg *A = Args.getLastArg(options::OPT_fparallel_codegen_EQ)) {
+    unsigned Threads;
+    if (StringRef(A->getValue()).getAsInteger(10, Threads) || Threads == 0)
+      D.Diag(diag::err_drv_invalid_int_value)
+          << A->getAsString(Args) << A->getValue();
+    else if (Threads > 1 && Output.isFilename() &&
+             Output.getType() == types::TY_Object && !SplitDWARF &&
+             RawTriple.isOSBinFormatELF() &&
+             (isa<AssembleJobAction>(JA) || isa<CompileJobAction>(JA) ||
+              isa<BackendJobAction>(JA))) {
+      CmdArgs.push_back(Args.MakeArgString("-fparallel-codegen=" +
+                                           Twine(Threads)));
+      for (unsigned I = 0; I != Threads; ++I) {
+        std::string TmpName = D.GetTemporaryPath(
+            "parallel-codegen", types::getTypeTempSuffix(types::TY_Object));
+        ParallelCodeGenObjects.push_back(
+            C.addTempFile(Args.MakeArgString(TmpName)));
+        if (I == 0)
+          continue;
+        CmdArgs.push_back("-parallel-codegen-output");
+        CmdArgs.push_back(ParallelCodeGenObjects.back());
+      }
+    }
+  }
+
   if (Output.getType() == types::TY_Dependencies) {
     // Handled with other dependency code.
+  } else if (!ParallelCodeGenObjects.empty()) {
+    CmdArgs.push_back("-o");
+    CmdArgs.push_back(ParallelCodeGenObjects.front());
   } else if (Output.isFilename()) {
     CmdArgs.push_back("-o");
     CmdArgs.push_back(Output.getFilename());
@@ -5398,6 +5430,18 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     C.addCommand(llvm::make_unique<Command>(JA, *this, Exec, CmdArgs, Inputs));
   }
 
+  if (!ParallelCodeGenObjects.empty()) {
+    ArgStringList LinkArgs;
+    LinkArgs.push_back("-r");
+    LinkArgs.push_back("-o");
+    LinkArgs.push_back(Output.getFilename());
+    LinkArgs.append(ParallelCodeGenObjects.begin(),
+                    ParallelCodeGenObjects.end());
+    const char *Linker = Args.MakeArgString(TC.GetLinkerPath());
+    C.addCommand(
+        llvm::make_unique<Command>(JA, *this, Linker, LinkArgs, Inputs));
+  }
+
   // Make the compile command echo its inputs for /showFilenames.
   if (Output.getType() == types::TY_Object &&
       Args.hasFlag(options::OPT__SLASH_showFilenames,
@@ -10,7 +10,10 @@
 #include "NamespaceEndCommentsFixer.h"
 #include "UnwrappedLineFormatter.h"
 #include "WhitespaceManager.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <queue>
 
 #define DEBUG_TYPE "format-formatter"
@@ -18,6 +21,50 @@
 namespace clang {
 namespace format {
 
+class UnwrappedLineFormatter::StateNodePool {
+public:
+  /// An edge in the solution space from \c Previous->State to \c State,
+  /// inserting a newline dependent on the \c NewLine.
+  struct StateNode {
+    StateNode(const LineState &State, bool NewLine, StateNode *Previous)
+        : State(State), NewLine(NewLine), Previous(Previous) {}
+    LineState State;
+    bool NewLine;
+    StateNode *Previous;
+  };
+
+  /// Returns a node for the given edge, reusing a released node if there is
+  /// one. Reused nodes keep the capacity of their \c LineState::Stack.
+  StateNode *create(const LineState &State, bool NewLine,
+                    StateNode *Previous) {
+    if (FreeNodes.empty())
+      return new (Allocator.Allocate()) StateNode(State, NewLine, Previous);
+    StateNode *Node = FreeNodes.pop_back_val();
+    Node->State = State;
+    Node->NewLine = NewLine;
+    Node->Previous = Previous;
+    return Node;
+  }
+
+  /// Makes \p Nodes available to later searches.
+  void release(ArrayRef<StateNode *> Nodes) {
+    FreeNodes.append(Nodes.begin(), Nodes.end());
+  }
+
+private:
+  llvm::SpecificBumpPtrAllocator<StateNode> Allocator;
+  SmallVector<StateNode *, 0> FreeNodes;
+};
+
+UnwrappedLineFormatter::~UnwrappedLineFormatter() = default;
+
+UnwrappedLineFormatter::StateNodePool &
+UnwrappedLineFormatter::getStateNodePool() {
+  if (!NodePool)
+    NodePool = llvm::make_unique<StateNodePool>();
+  return *NodePool;
+}
+
 namespace {
 
 bool startsExternCBlock(const AnnotatedLine &Line) {
@@ -678,6 +725,73 @@ static void printLineState(const LineState &State) {
 }
 #endif
 
+/// Computes the signature of formatting \p Line with the given start columns,
+/// i.e. everything the search for its best line breaks depends on, into
+/// \p Key.
+///
+/// Returns \c false if the formatting of the line may also depend on other
+/// lines, in which case its solution must not be cached.
+static bool getLineSolutionKey(const AnnotatedLine &Line, unsigned FirstIndent,
+                               unsigned FirstStartColumn, std::string &Key) {
+  if (!Line.Children.empty())
+    return false;
+
+  llvm::SmallDenseMap<const FormatToken *, unsigned, 32> TokenIndex;
+  unsigned Index = 0;
+  for (const FormatToken *Tok = Line.First; Tok; Tok = Tok->Next)
+    TokenIndex[Tok] = Index++;
+
+  llvm::raw_string_ostream OS(Key);
+  auto Add = [&OS](unsigned Value) { OS << Value << ','; };
+  Add(FirstIndent);
+  Add(FirstStartColumn);
+  Add(Line.Type);
+  Add(Line.Level);
+  Add(Line.InPPDirective);
+  Add(Line.MustBeDeclaration);
+  Add(Line.MightBeFunctionDecl);
+  Add(Line.IsMultiVariableDeclStmt);
+  for (const FormatToken *Tok = Line.First; Tok; Tok = Tok->Next) {
+    // Comments can be reflowed with the comments on adjacent lines, and the
+    // formatting of nested blocks is not part of the line's solution.
+    if (Tok->is(tok::comment) || !Tok->Children.empty())
+      return false;
+
+    unsigned Matching = 0;
+    if (Tok->MatchingParen) {
+      auto It = TokenIndex.find(Tok->MatchingParen);
+      if (It == TokenIndex.end())
+        return false;
+      Matching = It->second + 1;
+    }
+
+    Add(Tok->Tok.getKind());
+    Add(Tok->Type);
+    Add(Tok->BlockKind);
+    Add(Tok->PackingKind);
+    Add(Tok->MustBreakBefore);
+    Add(Tok->CanBreakBefore);
+    Add(Tok->SpacesRequiredBefore);
+    Add(Tok->SplitPenalty);
+    Add(Tok->NewlinesBefore);
+    Add(Tok->HasUnescapedNewline);
+    Add(Tok->LastNewlineOffset);
+    // The original column only matters for comments, which are not cached,
+    // and for the width of tokens containing tabs, so the widths are used
+    // instead. Otherwise re-indented lines would never hit the cache.
+    Add(Tok->ColumnWidth);
+    Add(Tok->LastLineColumnWidth);
+    Add(Tok->IsMultiline);
+    Add(Tok->IsFirst);
+    Add(Tok->Finalized);
+    Add(Tok->Decision);
+    Add(Matching);
+    OS << Tok->TokenText.size() << ':' << Tok->TokenText;
+  }
+  OS.flush();
+  return true;
+}
+
 /// Base class for classes that format one \c AnnotatedLine.
 class LineFormatter {
 public:
@@ -771,6 +885,8 @@ protected:
     return true;
   }
 
+  UnwrappedLineFormatter *getBlockFormatter() const { return BlockFormatter; }
+
   ContinuationIndenter *Indenter;
 
 private:
@@ -837,7 +953,11 @@ public:
                           WhitespaceManager *Whitespaces,
                           const FormatStyle &Style,
                           UnwrappedLineFormatter *BlockFormatter)
-      : LineFormatter(Indenter, Whitespaces, Style, BlockFormatter) {}
+      : LineFormatter(Indenter, Whitespaces, Style, BlockFormatter),
+        BeamWidth(Style.LineBreakSearchBeamWidth),
+        Pool(BlockFormatter->getStateNodePool()) {}
+
+  ~OptimizingLineFormatter() override { Pool.release(Nodes); }
 
   /// Formats the line by finding the best line breaks with line lengths
   /// below the column limit.
@@ -851,8 +971,24 @@ public:
     if (State.Line->Type == LT_ObjCMethodDecl)
       State.Stack.back().BreakBeforeParameter = true;
 
+    // Identical lines starting at the same column have the same best
+    // solution, so only search the solution space once for them.
+    std::string Key;
+    if (!getLineSolutionKey(Line, FirstIndent, FirstStartColumn, Key))
+      return analyzeSolutionSpace(State, DryRun);
+
+    if (const UnwrappedLineFormatter::LineSolution *Cached =
+            getBlockFormatter()->getCachedSolution(Key)) {
+      if (!DryRun && Cached->Found)
+        applySolution(State, Cached->NewLines);
+      return Cached->Penalty;
+    }
+
     // Find best solution in solution space.
-    return analyzeSolutionSpace(State, DryRun);
+    UnwrappedLineFormatter::LineSolution Solution;
+    unsigned Penalty = analyzeSolutionSpace(State, DryRun, &Solution);
+    getBlockFormatter()->cacheSolution(Key, std::move(Solution));
+    return Penalty;
   }
 
 private:
@@ -869,15 +1005,7 @@ private:
   /// that break the line as late as possible.
   typedef std::pair<unsigned, unsigned> OrderedPenalty;
 
-  /// An edge in the solution space from \c Previous->State to \c State,
-  /// inserting a newline dependent on the \c NewLine.
-  struct StateNode {
-    StateNode(const LineState &State, bool NewLine, StateNode *Previous)
-        : State(State), NewLine(NewLine), Previous(Previous) {}
-    LineState State;
-    bool NewLine;
-    StateNode *Previous;
-  };
+  typedef UnwrappedLineFormatter::StateNodePool::StateNode StateNode;
 
   /// An item in the prioritized BFS search queue. The \c StateNode's
   /// \c State has the given \c OrderedPenalty.
@@ -895,18 +1023,27 @@ private:
   /// find the shortest path (the one with lowest penalty) from \p InitialState
   /// to a state where all tokens are placed. Returns the penalty.
   ///
-  /// If \p DryRun is \c false, directly applies the changes.
-  unsigned analyzeSolutionSpace(LineState &InitialState, bool DryRun) {
+  /// If \c BeamWidth is non-zero, at most \c BeamWidth states are expanded
+  /// per token. States are expanded in order of increasing penalty, so only
+  /// the most expensive ways to reach a token are pruned.
+  ///
+  /// If \p DryRun is \c false, directly applies the changes. If \p Solution
+  /// is given, the line breaks of the best solution are stored in it.
+  unsigned analyzeSolutionSpace(
+      LineState &InitialState, bool DryRun,
+      UnwrappedLineFormatter::LineSolution *Solution = nullptr) {
     std::set<LineState *, CompareLineStatePointers> Seen;
 
+    // Number of states expanded per next token, used for the beam pruning.
+    llvm::DenseMap<const FormatToken *, unsigned> Expanded;
+
     // Increasing count of \c StateNode items we have created. This is used to
     // create a deterministic order independent of the container.
     unsigned Count = 0;
     QueueType Queue;
 
     // Insert start element into queue.
-    StateNode *Node =
-        new (Allocator.Allocate()) StateNode(InitialState, false, nullptr);
+    StateNode *Node = createNode(InitialState, false, nullptr);
     Queue.push(QueueItem(OrderedPenalty(0, Count), Node));
     ++Count;
 
@@ -932,6 +1069,10 @@ private:
         // State already examined with lower penalty.
         continue;
 
+      if (BeamWidth && ++Expanded[Node->State.NextToken] > BeamWidth)
+        // Enough cheaper ways to reach this token have been examined.
+        continue;
+
       FormatDecision LastFormat = Node->State.NextToken->Decision;
       if (LastFormat == FD_Unformatted || LastFormat == FD_Continue)
         addNextStateToQueue(Penalty, Node, /*NewLine=*/false, &Count, &Queue);
@@ -943,9 +1084,19 @@ private:
       // We were unable to find a solution, do nothing.
       // FIXME: Add diagnostic?
       LLVM_DEBUG(llvm::dbgs() << "Could not find a solution.\n");
+      if (Solution)
+        *Solution = {/*Found=*/false, /*Penalty=*/0, {}};
       return 0;
     }
 
+    if (Solution) {
+      *Solution = {/*Found=*/true, Penalty, {}};
+      for (StateNode *Step = Queue.top().second; Step->Previous;
+           Step = Step->Previous)
+        Solution->NewLines.push_back(Step->NewLine);
+      std::reverse(Solution->NewLines.begin(), Solution->NewLines.end());
+    }
+
     // Reconstruct the solution.
     if (!DryRun)
       reconstructPath(InitialState, Queue.top().second);
@@ -968,8 +1119,7 @@ private:
     if (!NewLine && Indenter->mustBreak(PreviousNode->State))
       return;
 
-    StateNode *Node = new (Allocator.Allocate())
-        StateNode(PreviousNode->State, NewLine, PreviousNode);
+    StateNode *Node = createNode(PreviousNode->State, NewLine, PreviousNode);
     if (!formatChildren(Node->State, NewLine, /*DryRun=*/true, Penalty))
       return;
 
@@ -1004,7 +1154,27 @@ private:
     }
   }
 
-  llvm::SpecificBumpPtrAllocator<StateNode> Allocator;
+  /// Applies the line breaks of a solution that was found for an identical
+  /// line before.
+  void applySolution(LineState &State, const std::vector<bool> &NewLines) {
+    for (bool NewLine : NewLines) {
+      unsigned Penalty = 0;
+      formatChildren(State, NewLine, /*DryRun=*/false, Penalty);
+      Indenter->addTokenToState(State, NewLine, /*DryRun=*/false);
+    }
+  }
+
+  StateNode *createNode(const LineState &State, bool NewLine,
+                        StateNode *Previous) {
+    StateNode *Node = Pool.create(State, NewLine, Previous);
+    Nodes.push_back(Node);
+    return Node;
+  }
+
+  unsigned BeamWidth;
+  UnwrappedLineFormatter::StateNodePool &Pool;
+  /// The nodes taken from \c Pool, returned to it on destruction.
+  SmallVector<StateNode *, 32> Nodes;
 };
 
 } // anonymous namespace
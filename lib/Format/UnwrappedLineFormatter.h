@@ -18,7 +18,10 @@
 
 #include "ContinuationIndenter.h"
 #include "clang/Format/Format.h"
+#include "llvm/ADT/StringMap.h"
 #include <map>
+#include <memory>
+#include <vector>
 
 namespace clang {
 namespace format {
@@ -36,6 +39,7 @@ public:
                          FormattingAttemptStatus *Status)
       : Indenter(Indenter), Whitespaces(Whitespaces), Style(Style),
         Keywords(Keywords), SourceMgr(SourceMgr), Status(Status) {}
+  ~UnwrappedLineFormatter();
 
   /// Format the current block and return the penalty.
   unsigned format(const SmallVectorImpl<AnnotatedLine *> &Lines,
@@ -45,6 +49,38 @@ public:
                   unsigned NextStartColumn = 0,
                   unsigned LastStartColumn = 0);
 
+  /// The best way to break a line found by searching its solution space.
+  struct LineSolution {
+    /// \c false if no solution within the column limit was found.
+    bool Found;
+    /// The penalty of the solution.
+    unsigned Penalty;
+    /// Whether to break before each token after the first one.
+    std::vector<bool> NewLines;
+  };
+
+  /// Returns the solution previously stored for a line with the signature
+  /// \p Key, or \c nullptr. Reused solutions are counted in the status.
+  const LineSolution *getCachedSolution(StringRef Key) {
+    auto It = SolutionCache.find(Key);
+    if (It == SolutionCache.end())
+      return nullptr;
+    if (Status)
+      ++Status->NumReusedLineSolutions;
+    return &It->second;
+  }
+
+  /// Remembers \p Solution for lines with the signature \p Key.
+  void cacheSolution(StringRef Key, LineSolution Solution) {
+    SolutionCache[Key] = std::move(Solution);
+  }
+
+  /// Storage for the states explored when searching the solution space of a
+  /// line. Shared by all lines (including nested blocks) of this formatter so
+  /// that the states of finished searches are reused.
+  class StateNodePool;
+  StateNodePool &getStateNodePool();
+
 private:
   /// Add a new line and the required indent before the first Token
   /// of the \c UnwrappedLine if there was no structural parsing error.
@@ -65,6 +101,14 @@ private:
            unsigned>
       PenaltyCache;
 
+  // Cache of the best line breaks for lines that have been formatted before,
+  // keyed by everything the search depends on (see getLineSolutionKey). Lines
+  // with identical tokens, annotations and start column are frequent in
+  // generated code and only need to be analyzed once.
+  llvm::StringMap<LineSolution> SolutionCache;
+
+  std::unique_ptr<StateNodePool> NodePool;
+
   ContinuationIndenter *Indenter;
   WhitespaceManager *Whitespaces;
   const FormatStyle &Style;
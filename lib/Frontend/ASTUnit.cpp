@@ -65,12 +65,15 @@
 #include "clang/Serialization/PCHContainerOperations.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
@@ -84,6 +87,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/Timer.h"
@@ -96,6 +100,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -265,6 +270,7 @@ ASTUnit::~ASTUnit() {
   }
 
   ClearCachedCompletionResults();
+  releasePreamble();
 
   if (getenv("LIBCLANG_OBJTRACKING"))
     fprintf(stderr, "--- %u translation units\n", --ActiveASTUnitObjects);
@@ -359,6 +365,95 @@ static uint64_t getDeclShowContexts(const NamedDecl *ND,
   return Contexts;
 }
 
+/// Returns the file that declares the entity of the code-completion result
+/// \p R, or an invalid FileID if it has none.
+static FileID getCompletionResultFile(const SourceManager &SM,
+                                      const CodeCompletionResult &R) {
+  SourceLocation Loc;
+  if (R.Kind == CodeCompletionResult::RK_Declaration)
+    Loc = R.Declaration->getLocation();
+  else if (R.Kind == CodeCompletionResult::RK_Macro && R.MacroDefInfo)
+    Loc = R.MacroDefInfo->getDefinitionLoc();
+  if (Loc.isInvalid())
+    return FileID();
+  return SM.getFileID(SM.getExpansionLoc(Loc));
+}
+
+/// Returns a hash identifying the contents of the file \p FID. Like the
+/// preamble, files on disk are identified by their size and modification
+/// time, and remapped files by their contents.
+static llvm::hash_code getFileContentsHash(const SourceManager &SM,
+                                           FileID FID) {
+  const FileEntry *File = SM.getFileEntryForID(FID);
+  if (File->getModificationTime() && !SM.isFileOverridden(File))
+    return llvm::hash_combine(File->getName(), File->getSize(),
+                              File->getModificationTime());
+  return llvm::hash_combine(File->getName(), SM.getBufferData(FID));
+}
+
+/// Returns a hash of the text of the file that \p FID was included from,
+/// directly or through other headers, up to that inclusion. Macros defined
+/// there may change the meaning of the header.
+static llvm::hash_code getIncludingTextHash(const SourceManager &SM,
+                                            FileID FID) {
+  std::pair<FileID, unsigned> Include(FID, 0);
+  for (SourceLocation Loc = SM.getIncludeLoc(FID); Loc.isValid();
+       Loc = SM.getIncludeLoc(Include.first))
+    Include = SM.getDecomposedExpansionLoc(Loc);
+  if (Include.first == FID)
+    return llvm::hash_value(0);
+  return llvm::hash_value(
+      SM.getBufferData(Include.first).take_front(Include.second));
+}
+
+/// Returns a hash of the names and kinds of the code-completion results
+/// \p Results selected by \p Indices.
+static llvm::hash_code
+getCompletionResultsSignature(ArrayRef<CodeCompletionResult> Results,
+                              ArrayRef<unsigned> Indices) {
+  llvm::hash_code Signature = llvm::hash_value(Indices.size());
+  for (unsigned I : Indices) {
+    const CodeCompletionResult &R = Results[I];
+    Signature = llvm::hash_combine(Signature, R.Kind, R.Priority,
+                                   R.Availability,
+                                   bool(R.StartsNestedNameSpecifier));
+    if (R.Kind == CodeCompletionResult::RK_Declaration)
+      Signature =
+          llvm::hash_combine(Signature, R.Declaration->getKind(),
+                             R.Declaration->getDeclName().getAsString());
+    else if (R.Kind == CodeCompletionResult::RK_Macro)
+      Signature = llvm::hash_combine(
+          Signature, R.Macro->getName(),
+          R.MacroDefInfo && R.MacroDefInfo->isFunctionLike(),
+          R.MacroDefInfo ? R.MacroDefInfo->getNumParams() : 0);
+  }
+  return Signature;
+}
+
+/// Copies the completion string \p CCS and all of its strings into
+/// \p Allocator.
+static CodeCompletionString *
+copyCompletionString(const CodeCompletionString &CCS,
+                     CodeCompletionAllocator &Allocator,
+                     CodeCompletionTUInfo &CCTUInfo) {
+  CodeCompletionBuilder Builder(
+      Allocator, CCTUInfo, CCS.getPriority(),
+      static_cast<CXAvailabilityKind>(CCS.getAvailability()));
+  for (const CodeCompletionString::Chunk &C : CCS) {
+    if (C.Kind == CodeCompletionString::CK_Optional)
+      Builder.AddOptionalChunk(
+          copyCompletionString(*C.Optional, Allocator, CCTUInfo));
+    else
+      Builder.AddChunk(C.Kind, Allocator.CopyString(C.Text));
+  }
+  for (unsigned I = 0, N = CCS.getAnnotationCount(); I != N; ++I)
+    Builder.AddAnnotation(Allocator.CopyString(CCS.getAnnotation(I)));
+  Builder.addParentName(CCS.getParentContextName());
+  if (const char *Comment = CCS.getBriefComment())
+    Builder.addBriefComment(Comment);
+  return Builder.TakeString();
+}
+
 void ASTUnit::CacheCodeCompletionResults() {
   if (!TheSema)
     return;
@@ -366,8 +461,10 @@ void ASTUnit::CacheCodeCompletionResults() {
   SimpleTimer Timer(WantTiming);
   Timer.setOutput("Cache global code completions for " + getMainFileName());
 
-  // Clear out the previous results.
-  ClearCachedCompletionResults();
+  // Clear out the previous results, but keep the chunks and the type
+  // identifiers they refer to.
+  CachedCompletionResults.clear();
+  CachedCompletionsByTypedText.clear();
 
   // Gather the set of global code completions.
   using Result = CodeCompletionResult;
@@ -381,7 +478,8 @@ void ASTUnit::CacheCodeCompletionResults() {
   llvm::DenseMap<CanQualType, unsigned> CompletionTypes;
   CodeCompletionContext CCContext(CodeCompletionContext::CCC_TopLevel);
 
-  for (auto &R : Results) {
+  auto CacheResult = [&](Result &R,
+                         std::vector<CachedCodeCompletionResult> &Cached) {
     switch (R.Kind) {
     case Result::RK_Declaration: {
       bool IsNestedNameSpecifier = false;
@@ -411,15 +509,17 @@ void ASTUnit::CacheCodeCompletionResults() {
         // temporary, CanQualType-based hash table to find the associated value.
         unsigned &TypeValue = CompletionTypes[CanUsageType];
         if (TypeValue == 0) {
-          TypeValue = CompletionTypes.size();
-          CachedCompletionTypes[QualType(CanUsageType).getAsString()]
-            = TypeValue;
+          unsigned &StoredValue =
+              CachedCompletionTypes[QualType(CanUsageType).getAsString()];
+          if (StoredValue == 0)
+            StoredValue = CachedCompletionTypes.size();
+          TypeValue = StoredValue;
         }
 
         CachedResult.Type = TypeValue;
       }
 
-      CachedCompletionResults.push_back(CachedResult);
+      Cached.push_back(CachedResult);
 
       /// Handle nested-name-specifiers in C++.
       if (TheSema->Context.getLangOpts().CPlusPlus && IsNestedNameSpecifier &&
@@ -457,7 +557,7 @@ void ASTUnit::CacheCodeCompletionResults() {
           CachedResult.Priority = CCP_NestedNameSpecifier;
           CachedResult.TypeClass = STC_Void;
           CachedResult.Type = 0;
-          CachedCompletionResults.push_back(CachedResult);
+          Cached.push_back(CachedResult);
         }
       }
       break;
@@ -493,18 +593,120 @@ void ASTUnit::CacheCodeCompletionResults() {
       CachedResult.Availability = R.Availability;
       CachedResult.TypeClass = STC_Void;
       CachedResult.Type = 0;
-      CachedCompletionResults.push_back(CachedResult);
+      Cached.push_back(CachedResult);
       break;
     }
     }
+  };
+
+  // Group the results by the file that declares them.
+  const SourceManager &SM = getSourceManager();
+  llvm::MapVector<FileID, SmallVector<unsigned, 16>> ResultsByFile;
+  for (unsigned I = 0, N = Results.size(); I != N; ++I)
+    ResultsByFile[getCompletionResultFile(SM, Results[I])].push_back(I);
+
+  // Order the headers by inclusion, so that the key of each chunk covers the
+  // contents of all headers that were included before it.
+  SmallVector<FileID, 32> Headers;
+  for (const auto &Entry : ResultsByFile)
+    if (Entry.first.isValid() && Entry.first != SM.getMainFileID() &&
+        SM.getFileEntryForID(Entry.first))
+      Headers.push_back(Entry.first);
+  llvm::sort(Headers, [&SM](FileID LHS, FileID RHS) {
+    return SM.isBeforeInTranslationUnit(SM.getLocForStartOfFile(LHS),
+                                        SM.getLocForStartOfFile(RHS));
+  });
+
+  llvm::StringMap<CachedCompletionChunk> Chunks;
+  llvm::hash_code Key = llvm::hash_value(0);
+  unsigned NumReusedChunks = 0;
+  for (FileID FID : Headers) {
+    Key = llvm::hash_combine(Key, getIncludingTextHash(SM, FID),
+                             getFileContentsHash(SM, FID));
+    ArrayRef<unsigned> Indices = ResultsByFile[FID];
+    StringRef Name = SM.getFileEntryForID(FID)->getName();
+    // A header that was entered more than once only gets a chunk for its
+    // first inclusion.
+    if (Chunks.count(Name)) {
+      for (unsigned I : Indices)
+        CacheResult(Results[I], CachedCompletionResults);
+      continue;
+    }
+
+    llvm::hash_code Signature = getCompletionResultsSignature(Results, Indices);
+    auto Previous = CachedCompletionChunks.find(Name);
+    if (Previous != CachedCompletionChunks.end() &&
+        Previous->second.Key == Key &&
+        Previous->second.Signature == Signature) {
+      // Copy the strings, so that the previous allocator can be freed.
+      CachedCompletionChunk &Chunk = Chunks[Name];
+      Chunk = std::move(Previous->second);
+      for (CachedCodeCompletionResult &R : Chunk.Results)
+        R.Completion = copyCompletionString(
+            *R.Completion, *CachedCompletionAllocator, CCTUInfo);
+      ++NumReusedChunks;
+    } else {
+      CachedCompletionChunk &Chunk = Chunks[Name];
+      Chunk.Key = Key;
+      Chunk.Signature = Signature;
+      for (unsigned I : Indices)
+        CacheResult(Results[I], Chunk.Results);
+    }
+    const std::vector<CachedCodeCompletionResult> &ChunkResults =
+        Chunks[Name].Results;
+    CachedCompletionResults.insert(CachedCompletionResults.end(),
+                                   ChunkResults.begin(), ChunkResults.end());
   }
+  CachedCompletionChunks = std::move(Chunks);
+
+  // The results of the main file and of builtin entities are always rebuilt.
+  for (auto &Entry : ResultsByFile) {
+    if (Entry.first.isValid() && Entry.first != SM.getMainFileID() &&
+        SM.getFileEntryForID(Entry.first))
+      continue;
+    for (unsigned I : Entry.second)
+      CacheResult(Results[I], CachedCompletionResults);
+  }
+
+  if (WantTiming)
+    llvm::errs() << "Reused " << NumReusedChunks << " of " << Headers.size()
+                 << " cached code-completion chunks\n";
+
+  // Index the results by their typed text to speed up completion at a known
+  // prefix.
+  CachedCompletionsByTypedText.resize(CachedCompletionResults.size());
+  std::iota(CachedCompletionsByTypedText.begin(),
+            CachedCompletionsByTypedText.end(), 0);
+  llvm::sort(CachedCompletionsByTypedText, [this](unsigned LHS, unsigned RHS) {
+    return StringRef(CachedCompletionResults[LHS].Completion->getTypedText()) <
+           StringRef(CachedCompletionResults[RHS].Completion->getTypedText());
+  });
 
   // Save the current top-level hash value.
   CompletionCacheTopLevelHashValue = CurrentTopLevelHashValue;
 }
 
+ArrayRef<unsigned>
+ASTUnit::getCachedCompletionsWithPrefix(StringRef Prefix) const {
+  auto TypedText = [this](unsigned I) {
+    return StringRef(CachedCompletionResults[I].Completion->getTypedText());
+  };
+  auto Begin = std::lower_bound(
+      CachedCompletionsByTypedText.begin(), CachedCompletionsByTypedText.end(),
+      Prefix,
+      [&](unsigned I, StringRef Prefix) { return TypedText(I) < Prefix; });
+  auto End = std::find_if_not(Begin, CachedCompletionsByTypedText.end(),
+                              [&](unsigned I) {
+                                return TypedText(I).startswith(Prefix);
+                              });
+  return llvm::makeArrayRef(CachedCompletionsByTypedText)
+      .slice(Begin - CachedCompletionsByTypedText.begin(), End - Begin);
+}
+
 void ASTUnit::ClearCachedCompletionResults() {
   CachedCompletionResults.clear();
+  CachedCompletionsByTypedText.clear();
+  CachedCompletionChunks.clear();
   CachedCompletionTypes.clear();
   CachedCompletionAllocator = nullptr;
 }
@@ -1311,7 +1513,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
       PreambleRebuildCounter = 1;
       return MainFileBuffer;
     } else {
-      Preamble.reset();
+      releasePreamble();
       PreambleDiagnostics.clear();
       TopLevelDeclsInPreamble.clear();
       PreambleSrcLocCache.clear();
@@ -1333,6 +1535,41 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   if (!AllowRebuild)
     return nullptr;
 
+  // Another ASTUnit may already have built this preamble.
+  std::string SharedPreambleKey;
+  if (PreambleCache) {
+    SharedPreambleKey = SharedPreambleCache::getKey(
+        PreambleInvocationIn, MainFileBuffer.get(), Bounds,
+        SkipFunctionBodies == SkipFunctionBodiesScope::Preamble, *VFS);
+    llvm::Optional<SharedPreambleCache::Entry> Shared =
+        PreambleCache->lookup(SharedPreambleKey);
+    if (Shared && Shared->Preamble->CanReuse(PreambleInvocationIn,
+                                             MainFileBuffer.get(), Bounds,
+                                             VFS.get())) {
+      Preamble = std::move(Shared->Preamble);
+      PreambleCache->retain(*Preamble);
+      PreambleRebuildCounter = 1;
+
+      getDiagnostics().Reset();
+      ProcessWarningOptions(getDiagnostics(),
+                            PreambleInvocationIn.getDiagnosticOpts());
+      getDiagnostics().setNumWarnings(Shared->NumWarnings);
+      NumWarningsInPreamble = Shared->NumWarnings;
+
+      TopLevelDecls.clear();
+      TopLevelDeclsInPreamble = std::move(Shared->TopLevelDeclIDs);
+      checkAndRemoveNonDriverDiags(StoredDiagnostics);
+      PreambleDiagnostics = std::move(Shared->Diagnostics);
+
+      PreambleTopLevelHashValue = Shared->TopLevelHashValue;
+      if (CurrentTopLevelHashValue != PreambleTopLevelHashValue) {
+        CompletionCacheTopLevelHashValue = 0;
+        PreambleTopLevelHashValue = CurrentTopLevelHashValue;
+      }
+      return MainFileBuffer;
+    }
+  }
+
   SmallVector<StandaloneDiagnostic, 4> NewPreambleDiagsStandalone;
   SmallVector<StoredDiagnostic, 4> NewPreambleDiags;
   ASTUnitPreambleCallbacks Callbacks;
@@ -1359,7 +1596,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
         PreviousSkipFunctionBodies;
 
     if (NewPreamble) {
-      Preamble = std::move(*NewPreamble);
+      Preamble = std::make_shared<PrecompiledPreamble>(std::move(*NewPreamble));
       PreambleRebuildCounter = 1;
     } else {
       switch (static_cast<BuildPreambleError>(NewPreamble.getError().value())) {
@@ -1390,6 +1627,17 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   StoredDiagnostics = std::move(NewPreambleDiags);
   PreambleDiagnostics = std::move(NewPreambleDiagsStandalone);
 
+  if (PreambleCache) {
+    SharedPreambleCache::Entry Shared;
+    Shared.Preamble = Preamble;
+    Shared.TopLevelDeclIDs = TopLevelDeclsInPreamble;
+    Shared.Diagnostics = PreambleDiagnostics;
+    Shared.NumWarnings = NumWarningsInPreamble;
+    Shared.TopLevelHashValue = PreambleTopLevelHashValue;
+    PreambleCache->insert(SharedPreambleKey, Shared);
+    PreambleCache->retain(*Preamble);
+  }
+
   // If the hash of top-level entities differs from the hash of the top-level
   // entities the last time we rebuilt the preamble, clear out the completion
   // cache.
@@ -1463,6 +1711,18 @@ StringRef ASTUnit::getASTFileName() const {
   return Mod.FileName;
 }
 
+unsigned ASTUnit::getPreambleShareCount() const {
+  if (!Preamble)
+    return 0;
+  return PreambleCache ? PreambleCache->getShareCount(*Preamble) : 1;
+}
+
+void ASTUnit::releasePreamble() {
+  if (Preamble && PreambleCache)
+    PreambleCache->release(*Preamble);
+  Preamble.reset();
+}
+
 std::unique_ptr<ASTUnit>
 ASTUnit::create(std::shared_ptr<CompilerInvocation> CI,
                 IntrusiveRefCntPtr<DiagnosticsEngine> Diags,
@@ -1710,7 +1970,8 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
     bool AllowPCHWithCompilerErrors, SkipFunctionBodiesScope SkipFunctionBodies,
     bool SingleFileParse, bool UserFilesAreVolatile, bool ForSerialization,
     llvm::Optional<StringRef> ModuleFormat, std::unique_ptr<ASTUnit> *ErrAST,
-    IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS) {
+    IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS,
+    std::shared_ptr<SharedPreambleCache> PreambleCache) {
   assert(Diags.get() && "no DiagnosticsEngine was provided");
 
   SmallVector<StoredDiagnostic, 4> StoredDiagnostics;
@@ -1768,6 +2029,7 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
   AST->UserFilesAreVolatile = UserFilesAreVolatile;
   AST->Invocation = CI;
   AST->SkipFunctionBodies = SkipFunctionBodies;
+  AST->PreambleCache = std::move(PreambleCache);
   if (ForSerialization)
     AST->WriterData.reset(new ASTWriterData(*AST->PCMCache));
   // Zero out now to ease cleanup during crash recovery.
@@ -2028,14 +2290,11 @@ void AugmentedCodeCompleteConsumer::ProcessCodeCompleteResults(Sema &S,
   llvm::StringSet<llvm::BumpPtrAllocator> HiddenNames;
   using Result = CodeCompletionResult;
   SmallVector<Result, 8> AllResults;
-  for (ASTUnit::cached_completion_iterator
-            C = AST.cached_completion_begin(),
-         CEnd = AST.cached_completion_end();
-       C != CEnd; ++C) {
+  auto AddCachedResult = [&](const ASTUnit::CachedCodeCompletionResult *C) {
     // If the context we are in matches any of the contexts we are
     // interested in, we'll add this result.
     if ((C->ShowInContexts & InContexts) == 0)
-      continue;
+      return;
 
     // If we haven't added any results previously, do so now.
     if (!AddedResult) {
@@ -2049,7 +2308,7 @@ void AugmentedCodeCompleteConsumer::ProcessCodeCompleteResults(Sema &S,
     // completion result. If so, skip it.
     if (C->Kind != CXCursor_MacroDefinition &&
         HiddenNames.count(C->Completion->getTypedText()))
-      continue;
+      return;
 
     // Adjust priority based on similar type classes.
     unsigned Priority = C->Priority;
@@ -2092,6 +2351,21 @@ void AugmentedCodeCompleteConsumer::ProcessCodeCompleteResults(Sema &S,
 
     AllResults.push_back(Result(Completion, Priority, C->Kind,
                                 C->Availability));
+  };
+
+  // When the consumer only wants results matching the identifier being
+  // completed, visit just the cached results with that prefix.
+  StringRef Filter = S.getPreprocessor().getCodeCompletionFilter();
+  if (filterByTypedPrefix() && !Filter.empty()) {
+    ASTUnit::cached_completion_iterator Cached = AST.cached_completion_begin();
+    for (unsigned I : AST.getCachedCompletionsWithPrefix(Filter))
+      AddCachedResult(&Cached[I]);
+  } else {
+    for (ASTUnit::cached_completion_iterator
+              C = AST.cached_completion_begin(),
+           CEnd = AST.cached_completion_end();
+         C != CEnd; ++C)
+      AddCachedResult(&*C);
   }
 
   // If we did not add any cached completion results, just forward the
@@ -2134,6 +2408,7 @@ void ASTUnit::CodeComplete(
   CodeCompleteOpts.IncludeBriefComments = IncludeBriefComments;
   CodeCompleteOpts.LoadExternal = Consumer.loadExternal();
   CodeCompleteOpts.IncludeFixIts = Consumer.includeFixIts();
+  CodeCompleteOpts.FilterByTypedPrefix = Consumer.filterByTypedPrefix();
 
   assert(IncludeBriefComments == this->IncludeBriefCommentsInCodeCompletion);
 
@@ -2688,3 +2963,119 @@ void ASTUnit::ConcurrencyState::start() {}
 void ASTUnit::ConcurrencyState::finish() {}
 
 #endif // NDEBUG
+
+std::string SharedPreambleCache::getKey(const CompilerInvocation &Invocation,
+                                        const llvm::MemoryBuffer *MainFileBuffer,
+                                        PreambleBounds Bounds,
+                                        bool SkipFunctionBodies,
+                                        llvm::vfs::FileSystem &VFS) {
+  llvm::MD5 Hash;
+  // Terminate each string so that different splits of the same characters
+  // hash differently.
+  auto AddString = [&Hash](StringRef Str) {
+    Hash.update(Str);
+    Hash.update(StringRef("\0", 1));
+  };
+  auto AddNumber = [&AddString](uint64_t N) { AddString(llvm::utostr(N)); };
+
+  AddNumber(Bounds.Size);
+  AddNumber(Bounds.PreambleEndsAtStartOfLine);
+  AddString(MainFileBuffer->getBuffer().take_front(Bounds.Size));
+  AddNumber(SkipFunctionBodies);
+
+  // Source locations in the preamble, e.g. those of its preprocessing record,
+  // point into the main file it was built for.
+  AddString(Invocation.getFrontendOpts().Inputs[0].getFile());
+
+  // Relative paths are resolved against the working directory, and remapped
+  // files may hide the files on disk.
+  AddString(Invocation.getFileSystemOpts().WorkingDir);
+  if (llvm::ErrorOr<std::string> CWD = VFS.getCurrentWorkingDirectory())
+    AddString(*CWD);
+
+  // The module hash covers the language, target and macro options, but not
+  // the include paths or the files included from the command line.
+  AddString(Invocation.getModuleHash());
+  const HeaderSearchOptions &HSOpts = Invocation.getHeaderSearchOpts();
+  for (const HeaderSearchOptions::Entry &E : HSOpts.UserEntries) {
+    AddString(E.Path);
+    AddNumber(E.Group);
+    AddNumber(E.IsFramework);
+    AddNumber(E.IgnoreSysRoot);
+  }
+  for (const HeaderSearchOptions::SystemHeaderPrefix &P :
+       HSOpts.SystemHeaderPrefixes) {
+    AddString(P.Prefix);
+    AddNumber(P.IsSystemHeader);
+  }
+  const PreprocessorOptions &PPOpts = Invocation.getPreprocessorOpts();
+  for (const std::string &Include : PPOpts.Includes)
+    AddString(Include);
+  for (const std::string &Include : PPOpts.MacroIncludes)
+    AddString(Include);
+  AddString(PPOpts.ImplicitPCHInclude);
+  for (const auto &Remapped : PPOpts.RemappedFiles) {
+    AddString(Remapped.first);
+    AddString(Remapped.second);
+  }
+  for (const auto &Remapped : PPOpts.RemappedFileBuffers)
+    AddString(Remapped.first);
+  for (const std::string &Warning : Invocation.getDiagnosticOpts().Warnings)
+    AddString(Warning);
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  return Result.digest().str();
+}
+
+llvm::Optional<SharedPreambleCache::Entry>
+SharedPreambleCache::lookup(StringRef Key) {
+  llvm::sys::ScopedLock L(Lock);
+  auto It = Entries.find(Key);
+  if (It == Entries.end())
+    return None;
+  std::shared_ptr<PrecompiledPreamble> Preamble = It->second.Preamble.lock();
+  if (!Preamble) {
+    Entries.erase(It);
+    return None;
+  }
+  Entry Result = It->second.Results;
+  Result.Preamble = std::move(Preamble);
+  return Result;
+}
+
+void SharedPreambleCache::insert(StringRef Key, const Entry &E) {
+  llvm::sys::ScopedLock L(Lock);
+  removeUnusedEntries();
+  StoredEntry &Stored = Entries[Key];
+  Stored.Preamble = E.Preamble;
+  Stored.Results = E;
+  Stored.Results.Preamble = nullptr;
+}
+
+void SharedPreambleCache::retain(const PrecompiledPreamble &Preamble) {
+  llvm::sys::ScopedLock L(Lock);
+  ++ShareCounts[&Preamble];
+}
+
+void SharedPreambleCache::release(const PrecompiledPreamble &Preamble) {
+  llvm::sys::ScopedLock L(Lock);
+  auto It = ShareCounts.find(&Preamble);
+  assert(It != ShareCounts.end() && "Preamble was not retained");
+  if (--It->second == 0)
+    ShareCounts.erase(It);
+}
+
+unsigned SharedPreambleCache::getShareCount(
+    const PrecompiledPreamble &Preamble) {
+  llvm::sys::ScopedLock L(Lock);
+  return ShareCounts.lookup(&Preamble);
+}
+
+void SharedPreambleCache::removeUnusedEntries() {
+  for (auto It = Entries.begin(), End = Entries.end(); It != End;) {
+    auto Current = It++;
+    if (Current->second.Preamble.expired())
+      Entries.erase(Current);
+  }
+}
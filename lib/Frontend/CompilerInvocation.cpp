@@ -933,6 +933,18 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
 
   Opts.ThinLinkBitcodeFile = Args.getLastArgValue(OPT_fthin_link_bitcode_EQ);
 
+  Opts.ParallelCodeGen =
+      getLastArgIntValue(Args, OPT_fparallel_codegen_EQ, 1, Diags);
+  if (Opts.ParallelCodeGen == 0)
+    Diags.Report(diag::err_drv_invalid_int_value)
+        << Args.getLastArg(OPT_fparallel_codegen_EQ)->getAsString(Args)
+        << "0";
+  Opts.ParallelCodeGenOutputs =
+      Args.getAllArgValues(OPT_parallel_codegen_output);
+  if (!Opts.ParallelCodeGenOutputs.empty() && !Opts.SplitDwarfFile.empty())
+    Diags.Report(diag::err_drv_argument_not_allowed_with)
+        << "-parallel-codegen-output" << "-split-dwarf-file";
+
   Opts.MSVolatile = Args.hasArg(OPT_fms_volatile);
 
   Opts.VectorizeLoop = Args.hasArg(OPT_vectorize_loops);
@@ -51,6 +51,50 @@ extern struct capreloc __start___cap_relocs;
 __attribute__((weak))
 extern struct capreloc __stop___cap_relocs;
 
+#ifdef CHERI_INIT_GLOBALS_USE_COMPACT_RELOCS
+/*
+ * Compact capability relocations (the __cap_relocs_compact section).
+ *
+ * No linker emits this section yet, so this is only available when
+ * CHERI_INIT_GLOBALS_USE_COMPACT_RELOCS is defined.
+ *
+ * The section starts with a capreloc_compact_header, followed by
+ * null_bitmap_words 64-bit words of a bitmap and then group_count groups.
+ * Bit i of the bitmap is set if the capability-sized slot at
+ * null_bitmap_base + i * sizeof(void *) must be initialized to NULL.
+ *
+ * Each group holds all relocations that are derived from the same capability
+ * (PCC if function_reloc_flag is set in permissions, otherwise the global data
+ * capability) with the same permissions. A group is a capreloc_compact_group
+ * followed by run_count runs. Each run describes slot_count consecutive
+ * capability-sized slots starting at capability_location that all point into
+ * the same object, and is followed by slot_count 64-bit offsets into that
+ * object (one per slot). Bounds are set once per run and permissions once per
+ * group, so most slots only need a single offset adjustment.
+ */
+struct capreloc_compact_header {
+    __UINT64_TYPE__ group_count;
+    __UINT64_TYPE__ null_bitmap_base;
+    __UINT64_TYPE__ null_bitmap_words;
+};
+struct capreloc_compact_group {
+    /* Permissions to keep, or zero to keep all of the base capability's. */
+    __UINT64_TYPE__ permissions;
+    __UINT64_TYPE__ run_count;
+};
+struct capreloc_compact_run {
+    __UINT64_TYPE__ capability_location;
+    __UINT64_TYPE__ object;
+    __UINT64_TYPE__ size;
+    __UINT64_TYPE__ slot_count;
+};
+
+__attribute__((weak))
+extern __UINT64_TYPE__ __start___cap_relocs_compact;
+__attribute__((weak))
+extern __UINT64_TYPE__ __stop___cap_relocs_compact;
+#endif
+
 __attribute__((weak)) extern void *__capability
 __cap_table_start;
 __attribute__((weak)) extern void *__capability
@@ -122,36 +166,115 @@ void cheri_init_globals_impl(const struct capreloc *start_relocs,
   }
 }
 
+#ifdef CHERI_INIT_GLOBALS_USE_COMPACT_RELOCS
+static __attribute__((always_inline))
+void cheri_init_globals_compact_impl(const __UINT64_TYPE__ *start_relocs,
+                                     const __UINT64_TYPE__ *stop_relocs,
+                                     void* gdc, void* pcc,
+                                     __UINT64_TYPE__ relocbase) {
+  if (start_relocs >= stop_relocs)
+    return;
+  gdc = __builtin_cheri_perms_and(gdc, global_pointer_permissions);
+  pcc = __builtin_cheri_perms_and(pcc, function_pointer_permissions);
+  __UINT64_TYPE__ gdc_base = __builtin_cheri_base_get(gdc);
+  __UINT64_TYPE__ pcc_base = __builtin_cheri_base_get(pcc);
+  const struct capreloc_compact_header *header =
+      (const struct capreloc_compact_header *)start_relocs;
+  const __UINT64_TYPE__ *data = (const __UINT64_TYPE__ *)(header + 1);
+
+  /* XXXAR: clang fills uninitialized capabilities with 0xcacaca..., so we
+   * we need to explicitly write NULL to these slots */
+  void **null_slots = __builtin_cheri_offset_set(
+      gdc, header->null_bitmap_base + relocbase - gdc_base);
+  for (__UINT64_TYPE__ word = 0; word < header->null_bitmap_words; word++) {
+    __UINT64_TYPE__ bits = data[word];
+    while (bits != 0) {
+      null_slots[word * 64 + __builtin_ctzll(bits)] = (void*)0;
+      bits &= bits - 1;
+    }
+  }
+  data += header->null_bitmap_words;
+
+  for (__UINT64_TYPE__ group = 0; group < header->group_count; group++) {
+    const struct capreloc_compact_group *g =
+        (const struct capreloc_compact_group *)data;
+    _Bool isFunction =
+        (g->permissions & function_reloc_flag) == function_reloc_flag;
+    __UINT64_TYPE__ perms = g->permissions & ~function_reloc_flag;
+    void *base_cap = isFunction ? pcc : gdc;
+    __UINT64_TYPE__ base = isFunction ? pcc_base : gdc_base;
+    if (perms != 0)
+      base_cap = __builtin_cheri_perms_and(base_cap, perms);
+    data = (const __UINT64_TYPE__ *)(g + 1);
+    for (__UINT64_TYPE__ run = 0; run < g->run_count; run++) {
+      const struct capreloc_compact_run *r =
+          (const struct capreloc_compact_run *)data;
+      const __UINT64_TYPE__ *offsets = (const __UINT64_TYPE__ *)(r + 1);
+      void **dest = __builtin_cheri_offset_set(
+          gdc, r->capability_location + relocbase - gdc_base);
+      void *src = __builtin_cheri_offset_set(base_cap, r->object - base);
+      if (!isFunction && (r->size != 0)) {
+        src = __builtin_cheri_bounds_set(src, r->size);
+      }
+      for (__UINT64_TYPE__ slot = 0; slot < r->slot_count; slot++)
+        dest[slot] = __builtin_cheri_offset_increment(src, offsets[slot]);
+      data = offsets + r->slot_count;
+    }
+  }
+}
+#endif
+
 #ifndef ADDITIONAL_CAPRELOC_PROCESSING
 #define ADDITIONAL_CAPRELOC_PROCESSING
 #endif
-static __attribute__((always_inline)) void cheri_init_globals_gdc(void *gdc) {
-  struct capreloc *start_relocs;
-  struct capreloc *stop_relocs;
-#ifndef __CHERI_CAPABILITY_TABLE__
 
-  /* If we are not using the CHERI capability table we can just synthesize
-   * the capabilities for these using the GOT and $ddc */
-  start_relocs = &__start___cap_relocs;
-  stop_relocs = &__stop___cap_relocs;
+/*
+ * Returns a 'type *' for the start of the section delimited by the
+ * __start_<section> and __stop_<section> symbols and sets *stop to its end.
+ */
+#ifndef __CHERI_CAPABILITY_TABLE__
+#define CHERI_INIT_GLOBALS_SECTION_BOUNDS(gdc, type, section, stop)            \
+  /* If we are not using the CHERI capability table we can just synthesize     \
+   * the capabilities for these using the GOT and $ddc */                      \
+  (*(stop) = (type *)&__stop_##section, (type *)&__start_##section)
 #else
-  __UINT64_TYPE__ start_addr, end_addr;
-  __asm__ (".option pic0\n\t"
-       "dla %0, __start___cap_relocs\n\t"
-       "dla %1, __stop___cap_relocs\n\t"
-       :"=r"(start_addr), "=r"(end_addr));
-  long relocs_size = end_addr - start_addr;
-  start_relocs = __builtin_cheri_offset_set(gdc, start_addr - __builtin_cheri_base_get(gdc));
-  start_relocs = __builtin_cheri_bounds_set(start_relocs, relocs_size);
-  stop_relocs = __builtin_cheri_offset_set(start_relocs, relocs_size);
+#define CHERI_INIT_GLOBALS_SECTION_BOUNDS(gdc, type, section, stop)            \
+  __extension__({                                                              \
+    __UINT64_TYPE__ start_addr, end_addr;                                      \
+    __asm__ (".option pic0\n\t"                                                \
+         "dla %0, __start_" #section "\n\t"                                    \
+         "dla %1, __stop_" #section "\n\t"                                     \
+         :"=r"(start_addr), "=r"(end_addr));                                   \
+    long section_size = end_addr - start_addr;                                 \
+    type *section_start = __builtin_cheri_offset_set(                          \
+        (gdc), start_addr - __builtin_cheri_base_get(gdc));                    \
+    section_start = __builtin_cheri_bounds_set(section_start, section_size);   \
+    *(stop) = __builtin_cheri_offset_set(section_start, section_size);         \
+    section_start;                                                             \
+  })
 #endif
+
+static __attribute__((always_inline)) void cheri_init_globals_gdc(void *gdc) {
   void *pcc = __builtin_cheri_program_counter_get();
   /*
    * We can assume that all relocations in the __cap_relocs section have already
    * been processed so we don't need to add a relocation base address to the
    * location of the capreloc.
    */
+#ifdef CHERI_INIT_GLOBALS_USE_COMPACT_RELOCS
+  __UINT64_TYPE__ *start_relocs;
+  __UINT64_TYPE__ *stop_relocs;
+  start_relocs = CHERI_INIT_GLOBALS_SECTION_BOUNDS(
+      gdc, __UINT64_TYPE__, __cap_relocs_compact, &stop_relocs);
+  cheri_init_globals_compact_impl(start_relocs, stop_relocs, gdc, pcc,
+                                  /*relocbase=*/0);
+#else
+  struct capreloc *start_relocs;
+  struct capreloc *stop_relocs;
+  start_relocs = CHERI_INIT_GLOBALS_SECTION_BOUNDS(gdc, struct capreloc,
+                                                   __cap_relocs, &stop_relocs);
   cheri_init_globals_impl(start_relocs, stop_relocs, gdc, pcc, /*relocbase=*/0);
+#endif
 }
 
 #ifndef CHERI_INIT_GLOBALS_GDC_ONLY
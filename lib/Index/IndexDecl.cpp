@@ -9,6 +9,7 @@
 
 #include "IndexingContext.h"
 #include "clang/Index/IndexDataConsumer.h"
+#include "clang/Index/IndexedHeaderRegistry.h"
 #include "clang/AST/DeclVisitor.h"
 
 using namespace clang;
@@ -754,6 +755,13 @@ bool IndexingContext::indexTopLevelDecl(const Decl *D) {
   if (isa<ObjCMethodDecl>(D))
     return true; // Wait for the objc container.
 
+  if (IndexOpts.HeaderRegistry) {
+    bool Skip = isInIndexedHeader(D);
+    IndexOpts.HeaderRegistry->recordTopLevelDecl(Skip);
+    if (Skip)
+      return true;
+  }
+
   return indexDecl(D);
 }
 
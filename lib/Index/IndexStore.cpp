@@ -0,0 +1,343 @@
+//===- IndexStore.cpp - Persistent on-disk index store --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Index/IndexStore.h"
+#include "MacroContextTracker.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Index/IndexDataConsumer.h"
+#include "clang/Index/IndexSymbol.h"
+#include "clang/Index/USRGeneration.h"
+#include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <set>
+
+using namespace clang;
+using namespace clang::index;
+
+static std::string getMD5String(ArrayRef<StringRef> Data) {
+  llvm::MD5 Hash;
+  for (StringRef D : Data) {
+    Hash.update(D);
+    Hash.update(StringRef("\0", 1));
+  }
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  return Result.digest().str();
+}
+
+std::string index::getIndexStoreRecordName(StringRef Filename,
+                                           StringRef Contents,
+                                           uint64_t MacroContext) {
+  return (llvm::sys::path::filename(Filename) + "-" +
+          getMD5String({Filename, Contents, std::to_string(MacroContext)}))
+      .str();
+}
+
+std::string index::getIndexStoreUnitPath(StringRef StorePath,
+                                         StringRef MainFile) {
+  SmallString<256> Path(StorePath);
+  llvm::sys::path::append(Path, "units",
+                          llvm::sys::path::filename(MainFile) + "-" +
+                              getMD5String(MainFile));
+  return Path.str();
+}
+
+/// Writes \p Contents to \p Path through a temporary file, so that concurrent
+/// readers and writers never observe a partially written file.
+///
+/// \returns true if an error occurred.
+static bool writeFileAtomically(StringRef Path, StringRef Contents) {
+  SmallString<256> TempPath(Path);
+  TempPath += "-%%%%%%%%";
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(TempPath, FD, TempPath))
+    return true;
+
+  llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+  Out << Contents;
+  Out.close();
+  if (Out.has_error()) {
+    Out.clear_error();
+    llvm::sys::fs::remove(TempPath);
+    return true;
+  }
+
+  if (llvm::sys::fs::rename(TempPath, Path)) {
+    llvm::sys::fs::remove(TempPath);
+    return true;
+  }
+  return false;
+}
+
+namespace {
+
+class IndexStoreDataConsumer : public IndexDataConsumer {
+  /// The occurrences of a single file of the translation unit.
+  struct FileRecord {
+    std::string Path;
+    std::string RecordName;
+
+    /// Whether the record is already in the store, in which case its
+    /// occurrences are not collected.
+    bool Exists = false;
+
+    /// Whether the declarations of the file were skipped because another
+    /// translation unit indexed it, in which case that translation unit
+    /// writes the record and this one only lists it in its unit.
+    bool Skipped = false;
+
+    /// The occurrences in the file with their file offset.
+    std::vector<std::pair<unsigned, std::string>> Occurrences;
+  };
+
+  std::string StorePath;
+  IndexStoreStats *Stats;
+  const SourceManager *SM = nullptr;
+  const LangOptions *LangOpts = nullptr;
+  std::shared_ptr<MacroContextTracker> MacroContexts;
+  llvm::DenseMap<FileID, std::unique_ptr<FileRecord>> Records;
+
+public:
+  IndexStoreDataConsumer(StringRef StorePath, IndexStoreStats *Stats)
+      : StorePath(StorePath), Stats(Stats) {}
+
+  void initialize(ASTContext &Ctx) override {
+    SM = &Ctx.getSourceManager();
+    LangOpts = &Ctx.getLangOpts();
+  }
+
+  void setPreprocessor(std::shared_ptr<Preprocessor> PP) override {
+    SM = &PP->getSourceManager();
+    LangOpts = &PP->getLangOpts();
+    if (!MacroContexts) {
+      MacroContexts = std::make_shared<MacroContextTracker>(*PP);
+      PP->addPPCallbacks(
+          MacroContextTracker::createPPCallbacks(MacroContexts, *PP));
+    }
+  }
+
+  bool handleDeclOccurence(const Decl *D, SymbolRoleSet Roles,
+                           ArrayRef<SymbolRelation> Relations,
+                           SourceLocation Loc, ASTNodeInfo ASTNode) override {
+    unsigned Offset;
+    FileRecord *Record = getRecordForLocation(Loc, Offset);
+    if (!Record || Record->Exists)
+      return true;
+
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+    printLocationAndSymbolInfo(Loc, getSymbolInfo(D), OS);
+    if (printSymbolName(D, *LangOpts, OS))
+      OS << "<no-name>";
+    OS << " | ";
+    SmallString<256> USR;
+    if (generateUSRForDecl(D, USR))
+      OS << "<no-usr>";
+    else
+      OS << USR;
+    OS << " | ";
+    printSymbolRoles(Roles, OS);
+    Record->Occurrences.emplace_back(Offset, std::move(OS.str()));
+    return true;
+  }
+
+  bool handleMacroOccurence(const IdentifierInfo *Name, const MacroInfo *MI,
+                            SymbolRoleSet Roles, SourceLocation Loc) override {
+    unsigned Offset;
+    FileRecord *Record = getRecordForLocation(Loc, Offset);
+    if (!Record || Record->Exists)
+      return true;
+
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+    printLocationAndSymbolInfo(Loc, getSymbolInfoForMacro(*MI), OS);
+    OS << Name->getName() << " | ";
+    SmallString<256> USR;
+    if (generateUSRForMacro(Name->getName(), MI->getDefinitionLoc(), *SM, USR))
+      OS << "<no-usr>";
+    else
+      OS << USR;
+    OS << " | ";
+    printSymbolRoles(Roles, OS);
+    Record->Occurrences.emplace_back(Offset, std::move(OS.str()));
+    return true;
+  }
+
+  void handleSkippedFile(FileID FID) override {
+    if (!SM)
+      return;
+    unsigned Offset;
+    if (FileRecord *Record =
+            getRecordForLocation(SM->getLocForStartOfFile(FID), Offset))
+      Record->Skipped = true;
+  }
+
+  void finish() override {
+    if (!SM)
+      return;
+
+    // The unit lists the main file even if it has no occurrences.
+    unsigned Offset;
+    getRecordForLocation(SM->getLocForStartOfFile(SM->getMainFileID()), Offset);
+    if (!Records.count(SM->getMainFileID()))
+      return;
+
+    SmallString<256> RecordsDir(StorePath), UnitsDir(StorePath);
+    llvm::sys::path::append(RecordsDir, "records");
+    llvm::sys::path::append(UnitsDir, "units");
+    if (llvm::sys::fs::create_directories(RecordsDir) ||
+        llvm::sys::fs::create_directories(UnitsDir))
+      return;
+
+    // A header entered more than once with the same macros gets a FileID for
+    // each entry, but they all share one record. Merge them in the order of
+    // their FileIDs, which is the order in which they were entered.
+    std::vector<std::pair<FileID, FileRecord *>> Entries;
+    for (auto &Entry : Records)
+      Entries.emplace_back(Entry.first, Entry.second.get());
+    llvm::sort(Entries, llvm::less_first());
+    llvm::StringMap<FileRecord *> RecordsByName;
+    std::vector<FileRecord *> SortedRecords;
+    for (const auto &Entry : Entries) {
+      FileRecord *Record = Entry.second;
+      auto Inserted = RecordsByName.try_emplace(Record->RecordName, Record);
+      if (Inserted.second) {
+        SortedRecords.push_back(Record);
+        continue;
+      }
+      FileRecord *First = Inserted.first->second;
+      First->Skipped &= Record->Skipped;
+      First->Occurrences.insert(First->Occurrences.end(),
+                                Record->Occurrences.begin(),
+                                Record->Occurrences.end());
+    }
+    llvm::sort(SortedRecords, [](FileRecord *LHS, FileRecord *RHS) {
+      return LHS->Path < RHS->Path;
+    });
+
+    for (FileRecord *Record : SortedRecords)
+      writeRecord(*Record, RecordsDir);
+
+    std::string Unit;
+    llvm::raw_string_ostream OS(Unit);
+    const FileRecord &MainRecord = *Records[SM->getMainFileID()];
+    OS << "unit " << MainRecord.Path << '\n';
+    for (const FileRecord *Record : SortedRecords)
+      OS << Record->RecordName << " | " << Record->Path << '\n';
+    if (!writeFileAtomically(getIndexStoreUnitPath(StorePath, MainRecord.Path),
+                             OS.str()) &&
+        Stats)
+      ++Stats->NumUnitsWritten;
+  }
+
+private:
+  /// Returns the record of the file containing \p Loc, creating it on first
+  /// use, or null if \p Loc is not in a file.
+  FileRecord *getRecordForLocation(SourceLocation Loc, unsigned &Offset) {
+    if (!SM || Loc.isInvalid())
+      return nullptr;
+    std::pair<FileID, unsigned> Decomposed =
+        SM->getDecomposedLoc(SM->getFileLoc(Loc));
+    Offset = Decomposed.second;
+
+    std::unique_ptr<FileRecord> &Record = Records[Decomposed.first];
+    if (Record)
+      return Record.get();
+
+    const FileEntry *File = SM->getFileEntryForID(Decomposed.first);
+    if (!File) {
+      Records.erase(Decomposed.first);
+      return nullptr;
+    }
+
+    Record = llvm::make_unique<FileRecord>();
+    Record->Path = File->tryGetRealPathName();
+    if (Record->Path.empty())
+      Record->Path = File->getName();
+    Record->RecordName = getIndexStoreRecordName(
+        Record->Path, SM->getBufferData(Decomposed.first),
+        getMacroContext(Decomposed.first));
+
+    SmallString<256> RecordPath(StorePath);
+    llvm::sys::path::append(RecordPath, "records", Record->RecordName);
+    Record->Exists = llvm::sys::fs::exists(RecordPath);
+    return Record.get();
+  }
+
+  /// Returns the macro context the file \p FID was included in. If the file
+  /// was preprocessed before the consumer got the preprocessor, only the
+  /// predefined and command-line macros are known.
+  uint64_t getMacroContext(FileID FID) const {
+    if (!MacroContexts)
+      return 0;
+    return MacroContexts->getContext(FID).getValueOr(
+        MacroContexts->getPredefinedContext());
+  }
+
+  void printLocationAndSymbolInfo(SourceLocation Loc, SymbolInfo SymInfo,
+                                  raw_ostream &OS) {
+    Loc = SM->getFileLoc(Loc);
+    OS << SM->getSpellingLineNumber(Loc) << ':'
+       << SM->getSpellingColumnNumber(Loc) << " | "
+       << getSymbolKindString(SymInfo.Kind);
+    if (SymInfo.SubKind != SymbolSubKind::None)
+      OS << '/' << getSymbolSubKindString(SymInfo.SubKind);
+    OS << '/' << getSymbolLanguageString(SymInfo.Lang) << " | ";
+  }
+
+  void writeRecord(FileRecord &Record, StringRef RecordsDir) {
+    if (Record.Exists) {
+      if (Stats)
+        ++Stats->NumRecordsReused;
+      return;
+    }
+    if (Record.Skipped)
+      return;
+
+    // The entries of a header that was entered more than once report the
+    // same occurrences.
+    std::stable_sort(Record.Occurrences.begin(), Record.Occurrences.end(),
+                     llvm::less_first());
+    std::set<std::pair<unsigned, std::string>> Seen;
+    llvm::erase_if(Record.Occurrences,
+                   [&](const std::pair<unsigned, std::string> &Occurrence) {
+                     return !Seen.insert(Occurrence).second;
+                   });
+
+    std::string Contents;
+    llvm::raw_string_ostream OS(Contents);
+    OS << "record " << Record.Path << '\n';
+    for (const auto &Occurrence : Record.Occurrences)
+      OS << Occurrence.second << '\n';
+
+    SmallString<256> RecordPath(RecordsDir);
+    llvm::sys::path::append(RecordPath, Record.RecordName);
+    if (!writeFileAtomically(RecordPath, OS.str()) && Stats)
+      ++Stats->NumRecordsWritten;
+  }
+};
+
+} // anonymous namespace
+
+std::shared_ptr<IndexDataConsumer>
+index::createIndexStoreDataConsumer(StringRef StorePath,
+                                    IndexStoreStats *Stats) {
+  return std::make_shared<IndexStoreDataConsumer>(StorePath, Stats);
+}
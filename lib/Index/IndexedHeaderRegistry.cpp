@@ -0,0 +1,51 @@
+//===- IndexedHeaderRegistry.cpp - Headers indexed in a session -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Index/IndexedHeaderRegistry.h"
+#include "clang/Basic/FileManager.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+using namespace clang::index;
+
+std::string IndexedHeaderRegistry::getHeaderKey(const FileEntry &File,
+                                                StringRef Contents,
+                                                uint64_t MacroContext) {
+  SmallString<128> Key;
+  llvm::raw_svector_ostream OS(Key);
+  const llvm::sys::fs::UniqueID &ID = File.getUniqueID();
+  OS << ID.getDevice() << ':' << ID.getFile() << ':'
+     << uint64_t(llvm::hash_value(Contents)) << ':' << MacroContext;
+  return OS.str();
+}
+
+bool IndexedHeaderRegistry::claimHeader(StringRef Key) {
+  bool Claimed;
+  {
+    llvm::sys::ScopedLock L(Lock);
+    Claimed = !IndexedHeaders.count(Key);
+  }
+  ++(Claimed ? NumHeadersIndexed : NumHeadersSkipped);
+  return Claimed;
+}
+
+void IndexedHeaderRegistry::markHeadersIndexed(ArrayRef<std::string> Keys) {
+  llvm::sys::ScopedLock L(Lock);
+  for (const std::string &Key : Keys)
+    IndexedHeaders.insert(Key);
+}
+
+void IndexedHeaderRegistry::printStats(raw_ostream &OS) const {
+  OS << "headers indexed: " << getNumHeadersIndexed() << '\n';
+  OS << "headers skipped: " << getNumHeadersSkipped() << '\n';
+  OS << "top-level decls visited: " << getNumDeclsVisited() << '\n';
+  OS << "top-level decls skipped: " << getNumDeclsSkipped() << '\n';
+}
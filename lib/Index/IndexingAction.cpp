@@ -9,6 +9,7 @@
 
 #include "clang/Index/IndexingAction.h"
 #include "IndexingContext.h"
+#include "MacroContextTracker.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/MultiplexConsumer.h"
@@ -123,12 +124,21 @@ protected:
                                                IndexCtx);
   }
 
-  std::unique_ptr<PPCallbacks> createIndexPPCallbacks() {
-    return llvm::make_unique<IndexPPCallbacks>(IndexCtx);
+  void addIndexPPCallbacks(Preprocessor &PP) {
+    PP.addPPCallbacks(llvm::make_unique<IndexPPCallbacks>(IndexCtx));
+    if (IndexCtx->getIndexOpts().HeaderRegistry) {
+      auto Tracker = std::make_shared<MacroContextTracker>(PP);
+      PP.addPPCallbacks(MacroContextTracker::createPPCallbacks(Tracker, PP));
+      IndexCtx->setMacroContextTracker(std::move(Tracker));
+    }
   }
 
-  void finish() {
+  void finish(CompilerInstance &CI) {
     DataConsumer->finish();
+    // A translation unit with errors may have missed declarations of the
+    // headers it claimed, so other translation units index them again.
+    if (!CI.getDiagnostics().hasErrorOccurred())
+      IndexCtx->markClaimedHeadersIndexed();
   }
 };
 
@@ -145,13 +155,13 @@ protected:
   }
 
   bool BeginSourceFileAction(clang::CompilerInstance &CI) override {
-    CI.getPreprocessor().addPPCallbacks(createIndexPPCallbacks());
+    addIndexPPCallbacks(CI.getPreprocessor());
     return true;
   }
 
   void EndSourceFileAction() override {
     FrontendAction::EndSourceFileAction();
-    finish();
+    finish(getCompilerInstance());
   }
 };
 
@@ -182,7 +192,7 @@ protected:
 
   bool BeginSourceFileAction(clang::CompilerInstance &CI) override {
     WrapperFrontendAction::BeginSourceFileAction(CI);
-    CI.getPreprocessor().addPPCallbacks(createIndexPPCallbacks());
+    addIndexPPCallbacks(CI.getPreprocessor());
     return true;
   }
 
@@ -190,7 +200,7 @@ protected:
     // Invoke wrapped action's method.
     WrapperFrontendAction::EndSourceFileAction();
     if (!IndexActionFailed)
-      finish();
+      finish(getCompilerInstance());
   }
 };
 
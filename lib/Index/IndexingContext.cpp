@@ -8,8 +8,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "IndexingContext.h"
+#include "MacroContextTracker.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Index/IndexDataConsumer.h"
+#include "clang/Index/IndexedHeaderRegistry.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/DeclObjC.h"
@@ -29,6 +31,43 @@ bool IndexingContext::shouldIndex(const Decl *D) {
   return !isGeneratedDecl(D);
 }
 
+bool IndexingContext::isInIndexedHeader(const Decl *D) {
+  if (!IndexOpts.HeaderRegistry || !MacroContexts)
+    return false;
+
+  SourceManager &SM = Ctx->getSourceManager();
+  FileID FID = SM.getFileID(SM.getFileLoc(D->getLocation()));
+  if (FID.isInvalid() || FID == SM.getMainFileID())
+    return false;
+
+  auto Known = SkippedHeaders.find(FID);
+  if (Known != SkippedHeaders.end())
+    return Known->second;
+
+  // A header that was not entered while the macros were tracked, e.g. one
+  // from a precompiled preamble, is always indexed.
+  const FileEntry *File = SM.getFileEntryForID(FID);
+  Optional<uint64_t> MacroContext = MacroContexts->getContext(FID);
+  bool Skip = false;
+  if (File && MacroContext) {
+    std::string Key = IndexedHeaderRegistry::getHeaderKey(
+        *File, SM.getBufferData(FID), *MacroContext);
+    Skip = !IndexOpts.HeaderRegistry->claimHeader(Key);
+    if (Skip)
+      DataConsumer.handleSkippedFile(FID);
+    else
+      ClaimedHeaders.push_back(std::move(Key));
+  }
+  SkippedHeaders[FID] = Skip;
+  return Skip;
+}
+
+void IndexingContext::markClaimedHeadersIndexed() {
+  if (IndexOpts.HeaderRegistry)
+    IndexOpts.HeaderRegistry->markHeadersIndexed(ClaimedHeaders);
+  ClaimedHeaders.clear();
+}
+
 const LangOptions &IndexingContext::getLangOpts() const {
   return Ctx->getLangOpts();
 }
@@ -12,10 +12,15 @@
 
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceLocation.h"
 #include "clang/Index/IndexSymbol.h"
 #include "clang/Index/IndexingAction.h"
 #include "clang/Lex/MacroInfo.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace clang {
   class ASTContext;
@@ -35,12 +40,25 @@ namespace clang {
 
 namespace index {
   class IndexDataConsumer;
+  class MacroContextTracker;
 
 class IndexingContext {
   IndexingOptions IndexOpts;
   IndexDataConsumer &DataConsumer;
   ASTContext *Ctx = nullptr;
 
+  /// The macros defined at the inclusion of each file, which distinguish the
+  /// configurations a header is indexed in. Headers are never skipped without
+  /// it.
+  std::shared_ptr<MacroContextTracker> MacroContexts;
+
+  /// Whether the declarations of a header are skipped because another
+  /// translation unit already indexed it.
+  llvm::DenseMap<FileID, bool> SkippedHeaders;
+
+  /// The registry keys of the headers claimed by this translation unit.
+  std::vector<std::string> ClaimedHeaders;
+
 public:
   IndexingContext(IndexingOptions IndexOpts, IndexDataConsumer &DataConsumer)
     : IndexOpts(IndexOpts), DataConsumer(DataConsumer) {}
@@ -50,6 +68,15 @@ public:
 
   void setASTContext(ASTContext &ctx) { Ctx = &ctx; }
 
+  void setMacroContextTracker(std::shared_ptr<MacroContextTracker> Tracker) {
+    MacroContexts = std::move(Tracker);
+  }
+
+  /// Records in the header registry that the headers claimed by this
+  /// translation unit were indexed. Must only be called if the translation
+  /// unit was indexed without errors.
+  void markClaimedHeadersIndexed();
+
   bool shouldIndex(const Decl *D);
 
   const LangOptions &getLangOpts() const;
@@ -121,6 +148,10 @@ public:
 private:
   bool shouldIgnoreIfImplicit(const Decl *D);
 
+  /// Whether \p D is in a header that was already indexed by another
+  /// translation unit sharing the header registry.
+  bool isInIndexedHeader(const Decl *D);
+
   bool handleDeclOccurrence(const Decl *D, SourceLocation Loc,
                             bool IsRef, const Decl *Parent,
                             SymbolRoleSet Roles,
@@ -0,0 +1,91 @@
+//===- MacroContextTracker.cpp - Macro state at file inclusions -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MacroContextTracker.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/STLExtras.h"
+
+using namespace clang;
+using namespace clang::index;
+
+namespace {
+
+class MacroContextCallbacks : public PPCallbacks {
+  std::shared_ptr<MacroContextTracker> Tracker;
+  const Preprocessor &PP;
+
+public:
+  MacroContextCallbacks(std::shared_ptr<MacroContextTracker> Tracker,
+                        const Preprocessor &PP)
+      : Tracker(std::move(Tracker)), PP(PP) {}
+
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override {
+    if (Reason == EnterFile)
+      Tracker->fileEntered(PP.getSourceManager().getFileID(Loc));
+  }
+
+  void MacroDefined(const Token &MacroNameTok,
+                    const MacroDirective *MD) override {
+    Tracker->macroDefined(*MacroNameTok.getIdentifierInfo(),
+                          *MD->getMacroInfo(), PP);
+  }
+
+  void MacroUndefined(const Token &MacroNameTok, const MacroDefinition &MD,
+                      const MacroDirective *Undef) override {
+    if (!MD.getMacroInfo())  // Ignore noop #undef.
+      return;
+    Tracker->macroUndefined(*MacroNameTok.getIdentifierInfo());
+  }
+};
+
+} // anonymous namespace
+
+MacroContextTracker::MacroContextTracker(const Preprocessor &PP)
+    : PredefinedContext(llvm::hash_value(PP.getPredefines())),
+      CurrentContext(PredefinedContext) {}
+
+Optional<uint64_t> MacroContextTracker::getContext(FileID FID) const {
+  auto Known = FileContexts.find(FID);
+  if (Known == FileContexts.end())
+    return None;
+  return Known->second;
+}
+
+std::unique_ptr<PPCallbacks> MacroContextTracker::createPPCallbacks(
+    std::shared_ptr<MacroContextTracker> Tracker, const Preprocessor &PP) {
+  return llvm::make_unique<MacroContextCallbacks>(std::move(Tracker), PP);
+}
+
+void MacroContextTracker::fileEntered(FileID FID) {
+  FileContexts.insert(std::make_pair(FID, CurrentContext));
+}
+
+void MacroContextTracker::macroDefined(const IdentifierInfo &Name,
+                                       const MacroInfo &MI,
+                                       const Preprocessor &PP) {
+  llvm::hash_code Hash =
+      llvm::hash_combine(CurrentContext, 'd', Name.getName(),
+                         MI.isFunctionLike(), MI.isVariadic());
+  for (const IdentifierInfo *Param : MI.params())
+    Hash = llvm::hash_combine(Hash, Param->getName());
+  for (const Token &Tok : MI.tokens())
+    Hash = llvm::hash_combine(Hash, unsigned(Tok.getKind()),
+                              Tok.hasLeadingSpace(), PP.getSpelling(Tok));
+  CurrentContext = Hash;
+}
+
+void MacroContextTracker::macroUndefined(const IdentifierInfo &Name) {
+  CurrentContext = llvm::hash_combine(CurrentContext, 'u', Name.getName());
+}
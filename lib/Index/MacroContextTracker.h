@@ -0,0 +1,69 @@
+//===- MacroContextTracker.h - Macro state at file inclusions ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_INDEX_MACROCONTEXTTRACKER_H
+#define LLVM_CLANG_LIB_INDEX_MACROCONTEXTTRACKER_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include <cstdint>
+#include <memory>
+
+namespace clang {
+  class IdentifierInfo;
+  class MacroInfo;
+  class PPCallbacks;
+  class Preprocessor;
+
+namespace index {
+
+/// Records, for each file entered by the preprocessor, a hash of the macros
+/// that are defined at the point where the file is entered.
+///
+/// A header that is included with different macros defined may declare
+/// different entities, so the hash identifies the configuration the header
+/// is indexed in. It starts from the predefined and command-line macros and
+/// covers every #define and #undef seen before the inclusion, in order. It is
+/// conservative: two inclusions that only differ in macros the header doesn't
+/// use get different contexts.
+class MacroContextTracker {
+  uint64_t PredefinedContext;
+  uint64_t CurrentContext;
+  llvm::DenseMap<FileID, uint64_t> FileContexts;
+
+public:
+  explicit MacroContextTracker(const Preprocessor &PP);
+
+  /// Returns the hash of the predefined and command-line macros of the
+  /// translation unit.
+  uint64_t getPredefinedContext() const { return PredefinedContext; }
+
+  /// Returns the macro context at the point where the file \p FID was
+  /// entered, or None if the file was not entered while the callbacks of the
+  /// tracker were attached to the preprocessor.
+  Optional<uint64_t> getContext(FileID FID) const;
+
+  /// Returns the preprocessor callbacks that update \p Tracker. They must be
+  /// added to \p PP before the main file is entered.
+  static std::unique_ptr<PPCallbacks>
+  createPPCallbacks(std::shared_ptr<MacroContextTracker> Tracker,
+                    const Preprocessor &PP);
+
+  void fileEntered(FileID FID);
+  void macroDefined(const IdentifierInfo &Name, const MacroInfo &MI,
+                    const Preprocessor &PP);
+  void macroUndefined(const IdentifierInfo &Name);
+};
+
+} // namespace index
+} // namespace clang
+
+#endif
@@ -768,6 +768,47 @@ void RopePieceBTree::erase(unsigned Offset, unsigned NumBytes) {
 // RewriteRope Implementation
 //===----------------------------------------------------------------------===//
 
+void RewriteRope::applyEdits(ArrayRef<Edit> Edits) {
+  RopePieceBTree NewChunks;
+  iterator Piece = begin();
+  unsigned PieceStart = 0;
+  unsigned Pos = 0;
+
+  // Advance to offset End in the old rope, appending the text in between to
+  // the new rope if Copy is true.
+  auto AdvanceTo = [&](unsigned End, bool Copy) {
+    assert(End <= size() && "Invalid edit offset!");
+    // Don't walk past the last piece if an edit is out of range anyway.
+    End = std::min(End, size());
+    while (Pos < End) {
+      const RopePiece &P = Piece.getRopePiece();
+      unsigned PieceEnd = PieceStart + P.size();
+      unsigned CopyEnd = std::min(End, PieceEnd);
+      if (Copy)
+        NewChunks.insert(NewChunks.size(),
+                         RopePiece(P.StrData, P.StartOffs + (Pos - PieceStart),
+                                   P.StartOffs + (CopyEnd - PieceStart)));
+      Pos = CopyEnd;
+      if (Pos == PieceEnd) {
+        PieceStart = PieceEnd;
+        Piece.MoveToNextPiece();
+      }
+    }
+  };
+
+  for (const Edit &E : Edits) {
+    assert(E.Offset >= Pos && "Edits must be sorted and must not overlap!");
+    AdvanceTo(E.Offset, /*Copy=*/true);
+    if (!E.Text.empty())
+      NewChunks.insert(NewChunks.size(),
+                       MakeRopeString(E.Text.begin(), E.Text.end()));
+    AdvanceTo(E.Offset + E.Length, /*Copy=*/false);
+  }
+  AdvanceTo(size(), /*Copy=*/true);
+
+  Chunks.swap(NewChunks);
+}
+
 /// MakeRopeString - This copies the specified byte range into some instance of
 /// RopeRefCountString, and return a RopePiece that represents it.  This uses
 /// the AllocBuffer object to aggregate requests for small strings into one
@@ -26,6 +26,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cassert>
 #include <iterator>
 #include <map>
@@ -126,6 +127,25 @@ void RewriteBuffer::ReplaceText(unsigned OrigOffset, unsigned OrigLength,
     AddReplaceDelta(OrigOffset, NewStr.size() - OrigLength);
 }
 
+void RewriteBuffer::ApplyEdits(MutableArrayRef<Edit> Edits) {
+  std::stable_sort(Edits.begin(), Edits.end(),
+                   [](const Edit &LHS, const Edit &RHS) {
+                     return LHS.OrigOffset < RHS.OrigOffset;
+                   });
+
+  // Map all edits into the current buffer before any deltas are added.
+  SmallVector<RewriteRope::Edit, 64> RopeEdits;
+  RopeEdits.reserve(Edits.size());
+  for (const Edit &E : Edits)
+    RopeEdits.push_back(RewriteRope::Edit{getMappedOffset(E.OrigOffset, true),
+                                          E.OrigLength, E.NewText});
+  Buffer.applyEdits(RopeEdits);
+
+  for (const Edit &E : Edits)
+    if (E.OrigLength != E.NewText.size())
+      AddReplaceDelta(E.OrigOffset, E.NewText.size() - E.OrigLength);
+}
+
 //===----------------------------------------------------------------------===//
 // Rewriter class
 //===----------------------------------------------------------------------===//
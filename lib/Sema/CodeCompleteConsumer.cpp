@@ -477,6 +477,11 @@ void CodeCompletionBuilder::addParentContext(const DeclContext *DC) {
   ParentName = getCodeCompletionTUInfo().getParentName(DC);
 }
 
+void CodeCompletionBuilder::addParentName(StringRef Name) {
+  if (!Name.empty())
+    ParentName = Allocator.CopyString(Name);
+}
+
 void CodeCompletionBuilder::addBriefComment(StringRef Comment) {
   BriefComment = Allocator.CopyString(Comment);
 }
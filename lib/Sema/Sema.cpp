@@ -40,6 +40,7 @@
 #include "clang/Sema/TemplateInstCallback.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/Support/Format.h"
 using namespace clang;
 using namespace sema;
 
@@ -437,6 +438,30 @@ void Sema::PrintStats() const {
   llvm::errs() << "\n*** Semantic Analysis Stats:\n";
   llvm::errs() << NumSFINAEErrors << " SFINAE diagnostics trapped.\n";
 
+  const auto &Lookups = UnqualifiedLookupStats;
+  llvm::errs() << Lookups.NumLookups << " unqualified lookups.\n";
+  llvm::errs() << Lookups.NumChainEntriesWalked
+               << " identifier chain entries at lookup (max chain length "
+               << Lookups.MaxChainEntriesWalked << ", average "
+               << llvm::format("%.2f",
+                               Lookups.NumLookups
+                                   ? double(Lookups.NumChainEntriesWalked) /
+                                         Lookups.NumLookups
+                                   : 0.0)
+               << ").\n";
+  llvm::errs() << llvm::format("%.3f", Lookups.LookupTimeNS / 1e6)
+               << " ms spent in unqualified lookup.\n";
+
+  const auto &Overloads = OverloadResolutionStats;
+  llvm::errs() << Overloads.NumResolutions << " overload resolutions, "
+               << Overloads.NumCandidates << " candidates, "
+               << Overloads.NumArityMismatches
+               << " candidates with the wrong number of arguments.\n";
+  llvm::errs() << Overloads.NumCalls << " overloaded calls, "
+               << Overloads.NumRepeatedCalls
+               << " with the same callees and argument types as an earlier "
+                  "call.\n";
+
   BumpAlloc.PrintStats();
   AnalysisWarnings.PrintStats();
 }
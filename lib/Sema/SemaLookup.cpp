@@ -41,6 +41,7 @@
 #include "llvm/ADT/edit_distance.h"
 #include "llvm/Support/ErrorHandling.h"
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 #include <list>
 #include <set>
@@ -1703,6 +1704,44 @@ NamedDecl *LookupResult::getAcceptableDeclSlow(NamedDecl *D) const {
   return findAcceptableDecl(getSema(), D, IDNS);
 }
 
+namespace {
+/// Records an unqualified lookup in the -print-stats counters of Sema: the
+/// length of the identifier chain it started from and the time it took.
+class UnqualifiedLookupStatsRecorder {
+  Sema &SemaRef;
+  std::chrono::steady_clock::time_point Start;
+
+public:
+  UnqualifiedLookupStatsRecorder(Sema &SemaRef, DeclarationName Name)
+      : SemaRef(SemaRef) {
+    if (!SemaRef.CollectStats)
+      return;
+
+    auto &Stats = SemaRef.UnqualifiedLookupStats;
+    ++Stats.NumLookups;
+    unsigned ChainLength = 0;
+    for (IdentifierResolver::iterator I = SemaRef.IdResolver.begin(Name),
+                                      IEnd = SemaRef.IdResolver.end();
+         I != IEnd; ++I)
+      ++ChainLength;
+    Stats.NumChainEntriesWalked += ChainLength;
+    Stats.MaxChainEntriesWalked =
+        std::max(Stats.MaxChainEntriesWalked, ChainLength);
+    Start = std::chrono::steady_clock::now();
+  }
+
+  ~UnqualifiedLookupStatsRecorder() {
+    if (!SemaRef.CollectStats)
+      return;
+
+    SemaRef.UnqualifiedLookupStats.LookupTimeNS +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - Start)
+            .count();
+  }
+};
+} // end anonymous namespace
+
 /// Perform unqualified name lookup starting from a given
 /// scope.
 ///
@@ -1735,6 +1774,7 @@ bool Sema::LookupName(LookupResult &R, Scope *S, bool AllowBuiltinCreation) {
   DeclarationName Name = R.getLookupName();
   if (!Name) return false;
 
+  UnqualifiedLookupStatsRecorder StatsRecorder(*this, Name);
   LookupNameKind NameKind = R.getLookupKind();
 
   if (!getLangOpts().CPlusPlus) {
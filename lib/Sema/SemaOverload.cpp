@@ -9373,6 +9373,17 @@ void Sema::diagnoseEquivalentInternalLinkageDeclarations(
 OverloadingResult
 OverloadCandidateSet::BestViableFunction(Sema &S, SourceLocation Loc,
                                          iterator &Best) {
+  if (S.CollectStats) {
+    auto &Stats = S.OverloadResolutionStats;
+    ++Stats.NumResolutions;
+    Stats.NumCandidates += size();
+    for (const OverloadCandidate &Cand : *this)
+      if (!Cand.Viable &&
+          (Cand.FailureKind == ovl_fail_too_many_arguments ||
+           Cand.FailureKind == ovl_fail_too_few_arguments))
+        ++Stats.NumArityMismatches;
+  }
+
   llvm::SmallVector<OverloadCandidate *, 16> Candidates;
   std::transform(begin(), end(), std::back_inserter(Candidates),
                  [](OverloadCandidate &Cand) { return &Cand; });
@@ -12144,6 +12155,36 @@ static void markUnaddressableCandidatesUnviable(Sema &S,
   }
 }
 
+/// Counts an overloaded call in the -print-stats counters of \p S, noting
+/// whether an earlier call had the same callees and argument types. Such a
+/// call could have been answered by a cache of overload resolution results.
+///
+/// \param Kind Distinguishes function calls (0) from binary operators
+/// (1 + the BinaryOperatorKind).
+static void noteOverloadedCall(Sema &S, unsigned Kind,
+                               UnresolvedSetIterator FnsBegin,
+                               UnresolvedSetIterator FnsEnd,
+                               ArrayRef<Expr *> Args) {
+  if (!S.CollectStats)
+    return;
+
+  std::vector<const void *> Signature;
+  Signature.push_back(reinterpret_cast<const void *>(uintptr_t(Kind)));
+  for (UnresolvedSetIterator I = FnsBegin; I != FnsEnd; ++I)
+    Signature.push_back(I.getDecl());
+  Signature.push_back(nullptr);
+  for (const Expr *Arg : Args) {
+    Signature.push_back(
+        S.Context.getCanonicalType(Arg->getType()).getAsOpaquePtr());
+    Signature.push_back(
+        reinterpret_cast<const void *>(uintptr_t(Arg->getValueKind())));
+  }
+
+  ++S.OverloadResolutionStats.NumCalls;
+  if (!S.OverloadedCallSignatures.insert(std::move(Signature)).second)
+    ++S.OverloadResolutionStats.NumRepeatedCalls;
+}
+
 /// BuildOverloadedCallExpr - Given the call expression that calls Fn
 /// (which eventually refers to the declaration Func) and the call
 /// arguments Args/NumArgs, attempt to resolve the function call down
@@ -12171,6 +12212,9 @@ ExprResult Sema::BuildOverloadedCallExpr(Scope *S, Expr *Fn,
   if (CalleesAddressIsTaken)
     markUnaddressableCandidatesUnviable(*this, CandidateSet);
 
+  noteOverloadedCall(*this, /*Kind=*/0, ULE->decls_begin(), ULE->decls_end(),
+                     Args);
+
   OverloadCandidateSet::iterator Best;
   OverloadingResult OverloadResult =
       CandidateSet.BestViableFunction(*this, Fn->getBeginLoc(), Best);
@@ -12478,6 +12522,8 @@ Sema::CreateOverloadedBinOp(SourceLocation OpLoc,
 
   bool HadMultipleCandidates = (CandidateSet.size() > 1);
 
+  noteOverloadedCall(*this, 1 + Opc, Fns.begin(), Fns.end(), Args);
+
   // Perform overload resolution.
   OverloadCandidateSet::iterator Best;
   switch (CandidateSet.BestViableFunction(*this, OpLoc, Best)) {
@@ -21,6 +21,10 @@
 #include "clang/StaticAnalyzer/Core/CheckerManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
 using namespace ento;
@@ -47,6 +51,12 @@ public:
   void reportSuspiciousClones(
       BugReporter &BR, AnalysisManager &Mgr,
       std::vector<CloneDetector::CloneGroup> &CloneGroups) const;
+
+  /// Writes the clone fingerprints of the translation unit to a new file in
+  /// the given directory, to be merged with other translation units later.
+  void writeFingerprints(AnalysisManager &Mgr, StringRef Directory,
+                         unsigned MinComplexity,
+                         StringRef IgnoredFilesPattern) const;
 };
 } // end anonymous namespace
 
@@ -76,6 +86,18 @@ void CloneChecker::checkEndOfTranslationUnit(const TranslationUnitDecl *TU,
   StringRef IgnoredFilesPattern = Mgr.getAnalyzerOptions()
     .getCheckerStringOption("IgnoredFilesPattern", "", this);
 
+  StringRef FingerprintDirectory = Mgr.getAnalyzerOptions()
+    .getCheckerStringOption("FingerprintDirectory", "", this);
+
+  // Clones across translation units are found by merging the fingerprints of
+  // all translation units with clang-clone-merge, which also reports the
+  // clones within this translation unit.
+  if (!FingerprintDirectory.empty()) {
+    writeFingerprints(Mgr, FingerprintDirectory, MinComplexity,
+                      IgnoredFilesPattern);
+    return;
+  }
+
   // Let the CloneDetector create a list of clones from all the analyzed
   // statements. We don't filter for matching variable patterns at this point
   // because reportSuspiciousClones() wants to search them for errors.
@@ -195,6 +217,60 @@ void CloneChecker::reportSuspiciousClones(
   }
 }
 
+void CloneChecker::writeFingerprints(AnalysisManager &Mgr, StringRef Directory,
+                                     unsigned MinComplexity,
+                                     StringRef IgnoredFilesPattern) const {
+  std::vector<CloneFingerprint> Fingerprints;
+  Detector.collectFingerprints(Fingerprints, MinComplexity,
+                               IgnoredFilesPattern);
+
+  // Every main file gets its own file, named after a hash of its real path,
+  // which later runs on the same file replace.
+  const SourceManager &SM = Mgr.getSourceManager();
+  StringRef MainFile = "main";
+  SmallString<256> RealPath;
+  if (const FileEntry *FE = SM.getFileEntryForID(SM.getMainFileID())) {
+    MainFile = llvm::sys::path::filename(FE->getName());
+    if (llvm::sys::fs::real_path(FE->getName(), RealPath))
+      RealPath = FE->getName();
+  }
+  llvm::MD5 Hash;
+  Hash.update(RealPath);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<256> Path(Directory);
+  llvm::sys::path::append(Path, MainFile + "-" + Result.digest() + ".clones");
+
+  // Write to a temporary file and rename it, so that clang-clone-merge never
+  // reads a partially written file.
+  SmallString<256> TempPath(Path);
+  TempPath += "-%%%%%%%%.tmp";
+  int FD;
+  std::error_code EC = llvm::sys::fs::create_directories(Directory);
+  if (!EC)
+    EC = llvm::sys::fs::createUniqueFile(TempPath, FD, TempPath);
+  if (!EC) {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    writeCloneFingerprints(Fingerprints, OS);
+    OS.close();
+    if (OS.has_error()) {
+      EC = OS.error();
+      OS.clear_error();
+    } else {
+      EC = llvm::sys::fs::rename(TempPath, Path);
+    }
+    if (EC)
+      llvm::sys::fs::remove(TempPath);
+  }
+  if (EC) {
+    DiagnosticsEngine &Diags = Mgr.getDiagnostic();
+    unsigned DiagID =
+        Diags.getCustomDiagID(DiagnosticsEngine::Error,
+                              "cannot write clone fingerprints to '%0': %1");
+    Diags.Report(DiagID) << Path.str() << EC.message();
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // Register CloneChecker
 //===----------------------------------------------------------------------===//
@@ -58,6 +58,8 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -80,6 +82,10 @@ STATISTIC(MaxBugClassSize,
 STATISTIC(MaxValidBugClassSize,
           "The maximum number of bug reports in the same equivalence class "
           "where at least one report is valid (not suppressed)");
+STATISTIC(NumCrosscheckedReports,
+          "The # of bug reports crosschecked with Z3 before path generation");
+STATISTIC(NumRefutedReports,
+          "The # of bug reports refuted by crosschecking with Z3");
 
 BugReporterVisitor::~BugReporterVisitor() = default;
 
@@ -2248,6 +2254,8 @@ void BugReporter::FlushReports() {
   if (BugTypes.isEmpty())
     return;
 
+  crosscheckReports(EQClassesVector);
+
   // We need to flush reports in deterministic order to ensure the order
   // of the reports is consistent between runs.
   for (const auto EQ : EQClassesVector)
@@ -2621,7 +2629,7 @@ std::pair<BugReport*, std::unique_ptr<VisitorsDiagnosticsTy>> findValidReport(
         generateVisitorsDiagnostics(R, ErrorNode, BRC);
 
     if (R->isValid()) {
-      if (Opts.ShouldCrosscheckWithZ3) {
+      if (Opts.ShouldCrosscheckWithZ3 && !Reporter.isCrosschecked(R)) {
         // If crosscheck is enabled, remove all visitors, add the refutation
         // visitor and check again
         R->clearVisitors();
@@ -2937,6 +2945,105 @@ FindReportInEquivalenceClass(BugReportEquivClass& EQ,
   return exampleReport;
 }
 
+namespace {
+
+/// The path constraints of a bug report, checked by the solver.
+struct CrosscheckQuery {
+  BugReport *Report;
+  const LocationContext *LC;
+  SMTSolverRef Solver;
+  Optional<bool> IsSat;
+};
+
+} // namespace
+
+/// The number of candidate reports per equivalence class that are
+/// crosschecked up front. Usually the first one is valid; the reports of
+/// classes with more refuted candidates are checked during path generation.
+static const unsigned MaxCrosscheckedReportsPerClass = 4;
+
+void GRBugReporter::crosscheckReports(
+    ArrayRef<BugReportEquivClass *> EQClasses) {
+  AnalyzerOptions &Opts = getAnalyzerOptions();
+  if (!Opts.ShouldCrosscheckWithZ3)
+    return;
+
+  unsigned NumThreads = Opts.CrosscheckWithZ3Threads
+                            ? Opts.CrosscheckWithZ3Threads
+                            : llvm::hardware_concurrency();
+
+  // Checks the queued queries, one per thread, and frees their solvers once
+  // the results are read, so that at most NumThreads solvers are alive.
+  std::vector<CrosscheckQuery> Queries;
+  std::unique_ptr<llvm::ThreadPool> Pool;
+  auto CheckQueries = [&] {
+    if (Queries.size() > 1) {
+      if (!Pool)
+        Pool = llvm::make_unique<llvm::ThreadPool>(NumThreads);
+      for (CrosscheckQuery &Q : Queries)
+        Pool->async([&Q] { Q.IsSat = Q.Solver->check(); });
+      Pool->wait();
+    } else {
+      for (CrosscheckQuery &Q : Queries)
+        Q.IsSat = Q.Solver->check();
+    }
+
+    // An unknown result, e.g. because the time budget ran out, keeps the
+    // report.
+    for (CrosscheckQuery &Q : Queries) {
+      CrosscheckedReports.insert(Q.Report);
+      ++NumCrosscheckedReports;
+      if (Q.IsSat.hasValue() && !Q.IsSat.getValue()) {
+        Q.Report->markInvalid("Infeasible constraints", Q.LC);
+        ++NumRefutedReports;
+      }
+    }
+    Queries.clear();
+  };
+
+  // Collect the constraints on the paths of the candidate reports and encode
+  // them for the solver. This walks the exploded graph and uses the
+  // ASTContext, so it is done on this thread. Each query gets a solver of
+  // its own, which the pool may then check on any thread.
+  for (BugReportEquivClass *EQ : EQClasses) {
+    SmallVector<BugReport *, 10> bugReports;
+    BugReport *Example = FindReportInEquivalenceClass(*EQ, bugReports);
+    if (!Example || !Example->isPathSensitive() || bugReports.empty())
+      continue;
+
+    // Visit the reports in the order in which path generation tries them,
+    // along the same paths.
+    SmallVector<const ExplodedNode *, 32> errorNodes;
+    for (BugReport *R : bugReports)
+      errorNodes.push_back(R->isValid() ? R->getErrorNode() : nullptr);
+    if (llvm::all_of(errorNodes,
+                     [](const ExplodedNode *N) { return N == nullptr; }))
+      continue;
+
+    TrimmedGraph TrimG(&getGraph(), errorNodes);
+    ReportGraph ErrorGraph;
+    unsigned NumQueued = 0;
+    while (NumQueued < MaxCrosscheckedReportsPerClass &&
+           TrimG.popNextReportGraph(ErrorGraph)) {
+      const ExplodedNode *ErrorNode = ErrorGraph.ErrorNode;
+      // The refutation visitor never checks a path of a single node.
+      if (!ErrorNode->getFirstPred())
+        continue;
+      SMTSolverRef Solver = FalsePositiveRefutationBRVisitor::createSolver(
+          FalsePositiveRefutationBRVisitor::collectConstraints(ErrorNode),
+          getContext());
+      Solver->setTimeout(Opts.CrosscheckWithZ3Timeout);
+      Queries.push_back({bugReports[ErrorGraph.Index],
+                         ErrorNode->getLocationContext(), std::move(Solver),
+                         None});
+      ++NumQueued;
+      if (Queries.size() >= NumThreads)
+        CheckQueries();
+    }
+  }
+  CheckQueries();
+}
+
 void BugReporter::FlushReport(BugReportEquivClass& EQ) {
   SmallVector<BugReport*, 10> bugReports;
   BugReport *report = FindReportInEquivalenceClass(EQ, bugReports);
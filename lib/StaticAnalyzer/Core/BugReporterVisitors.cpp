@@ -2422,26 +2422,10 @@ void FalsePositiveRefutationBRVisitor::finalizeVisitor(
   VisitNode(EndPathNode, BRC, BR);
 
   // Create a refutation manager
-  SMTSolverRef RefutationSolver = CreateZ3Solver();
-  ASTContext &Ctx = BRC.getASTContext();
-
-  // Add constraints to the solver
-  for (const auto &I : Constraints) {
-    const SymbolRef Sym = I.first;
-    auto RangeIt = I.second.begin();
-
-    SMTExprRef Constraints = SMTConv::getRangeExpr(
-        RefutationSolver, Ctx, Sym, RangeIt->From(), RangeIt->To(),
-        /*InRange=*/true);
-    while ((++RangeIt) != I.second.end()) {
-      Constraints = RefutationSolver->mkOr(
-          Constraints, SMTConv::getRangeExpr(RefutationSolver, Ctx, Sym,
-                                             RangeIt->From(), RangeIt->To(),
-                                             /*InRange=*/true));
-    }
-
-    RefutationSolver->addConstraint(Constraints);
-  }
+  SMTSolverRef RefutationSolver =
+      createSolver(Constraints, BRC.getASTContext());
+  RefutationSolver->setTimeout(
+      BRC.getAnalyzerOptions().CrosscheckWithZ3Timeout);
 
   // And check for satisfiability
   Optional<bool> isSat = RefutationSolver->check();
@@ -2456,6 +2440,12 @@ std::shared_ptr<PathDiagnosticPiece>
 FalsePositiveRefutationBRVisitor::VisitNode(const ExplodedNode *N,
                                             BugReporterContext &,
                                             BugReport &) {
+  addConstraints(Constraints, N);
+  return nullptr;
+}
+
+void FalsePositiveRefutationBRVisitor::addConstraints(
+    ConstraintRangeTy &Constraints, const ExplodedNode *N) {
   // Collect new constraints
   const ConstraintRangeTy &NewCs = N->getState()->get<ConstraintRange>();
   ConstraintRangeTy::Factory &CF =
@@ -2468,8 +2458,43 @@ FalsePositiveRefutationBRVisitor::VisitNode(const ExplodedNode *N,
       Constraints = CF.add(Constraints, Sym, C.second);
     }
   }
+}
 
-  return nullptr;
+ConstraintRangeTy FalsePositiveRefutationBRVisitor::collectConstraints(
+    const ExplodedNode *ErrorNode) {
+  ConstraintRangeTy Constraints = ConstraintRangeTy::Factory().getEmptyMap();
+  // Like generateVisitorsDiagnostics(), visit the path from the predecessor of
+  // the error node up to, but excluding, the root, and the error node last.
+  for (const ExplodedNode *N = ErrorNode->getFirstPred();
+       N && N->getFirstPred(); N = N->getFirstPred())
+    addConstraints(Constraints, N);
+  addConstraints(Constraints, ErrorNode);
+  return Constraints;
+}
+
+SMTSolverRef
+FalsePositiveRefutationBRVisitor::createSolver(
+    const ConstraintRangeTy &Constraints, ASTContext &Ctx) {
+  SMTSolverRef RefutationSolver = CreateZ3Solver();
+
+  // Add constraints to the solver
+  for (const auto &I : Constraints) {
+    const SymbolRef Sym = I.first;
+    auto RangeIt = I.second.begin();
+
+    SMTExprRef Constraints = SMTConv::getRangeExpr(
+        RefutationSolver, Ctx, Sym, RangeIt->From(), RangeIt->To(),
+        /*InRange=*/true);
+    while ((++RangeIt) != I.second.end()) {
+      Constraints = RefutationSolver->mkOr(
+          Constraints, SMTConv::getRangeExpr(RefutationSolver, Ctx, Sym,
+                                             RangeIt->From(), RangeIt->To(),
+                                             /*InRange=*/true));
+    }
+
+    RefutationSolver->addConstraint(Constraints);
+  }
+  return RefutationSolver;
 }
 
 void FalsePositiveRefutationBRVisitor::Profile(
@@ -125,6 +125,8 @@ static void expandGraphWithCheckers(CHECK_CTX checkCtx,
     }
 
     NodeBuilder B(*PrevSet, *CurrSet, BldrCtx);
+    SymbolManager::CreatorScope Creator(checkCtx.Eng.getSymbolManager(),
+                                        I->Checker);
     for (const auto &NI : *PrevSet)
       checkCtx.runChecker(*I, B, NI);
 
@@ -658,6 +660,8 @@ void CheckerManager::runCheckersForEvalCall(ExplodedNodeSet &Dst,
       { // CheckerContext generates transitions(populates checkDest) on
         // destruction, so introduce the scope to make sure it gets properly
         // populated.
+        SymbolManager::CreatorScope Creator(Eng.getSymbolManager(),
+                                            EvalCallChecker.Checker);
         CheckerContext C(B, Eng, Pred, L);
         evaluated = EvalCallChecker(CE, C);
       }
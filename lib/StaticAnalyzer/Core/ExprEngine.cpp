@@ -206,6 +206,11 @@ ExprEngine::ExprEngine(cross_tu::CrossTranslationUnitContext &CTU,
     // Enable eager node reclamation when constructing the ExplodedGraph.
     G.enableNodeReclamation(TrimInterval);
   }
+
+  // The symbols created by each checker are only reported with the other
+  // statistics.
+  if (mgr.options.PrintStats)
+    SymMgr.enableSymbolCreatorCounting();
 }
 
 ExprEngine::~ExprEngine() {
@@ -1905,6 +1910,7 @@ void ExprEngine::processCFGBlockEntrance(const BlockEdge &L,
                         (*G.roots_begin())->getLocation().getLocationContext();
     if (RootLC->getStackFrame() != CalleeSF) {
       Engine.FunctionSummaries->markReachedMaxBlockCount(CalleeSF->getDecl());
+      ExceededInliningBudget = true;
 
       // Re-run the call evaluation without inlining it, by storing the
       // no-inlining policy in the state and enqueuing the new work item on
@@ -13,6 +13,7 @@
 
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "PrettyStackTraceLocationContext.h"
+#include "clang/AST/Attr.h"
 #include "clang/AST/CXXInheritance.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/Analysis/Analyses/LiveVariables.h"
@@ -37,6 +38,9 @@ STATISTIC(NumInlinedCalls,
 STATISTIC(NumReachedInlineCountMax,
   "The # of times we reached inline count maximum");
 
+STATISTIC(NumSummarizedCalls,
+  "The # of times we evaluated a call with a side effect summary");
+
 void ExprEngine::processCallEnter(NodeBuilderContext& BC, CallEnter CE,
                                   ExplodedNode *Pred) {
   // Get the entry block in the CFG of the callee.
@@ -655,6 +659,260 @@ void ExprEngine::conservativeEvalCall(const CallEvent &Call, NodeBuilder &Bldr,
   Bldr.generateNode(Call.getProgramPoint(), State, Pred);
 }
 
+static void collectReturnStmts(const Stmt *S,
+                               SmallVectorImpl<const ReturnStmt *> &Returns) {
+  if (!S)
+    return;
+  if (const auto *RS = dyn_cast<ReturnStmt>(S))
+    Returns.push_back(RS);
+  for (const Stmt *Child : S->children())
+    collectReturnStmts(Child, Returns);
+}
+
+/// Returns true if the value of \p P is read but never written or referred to
+/// in \p S.
+static bool isOnlyRead(const ParmVarDecl *P, const Stmt *S) {
+  if (!S)
+    return true;
+  if (const auto *ICE = dyn_cast<ImplicitCastExpr>(S))
+    if (ICE->getCastKind() == CK_LValueToRValue)
+      if (const auto *DRE =
+              dyn_cast<DeclRefExpr>(ICE->getSubExpr()->IgnoreParens()))
+        if (DRE->getDecl() == P)
+          return true;
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(S))
+    if (DRE->getDecl() == P)
+      return false;
+  for (const Stmt *Child : S->children())
+    if (!isOnlyRead(P, Child))
+      return false;
+  return true;
+}
+
+/// Returns the value returned by a call to \p FD, which has no side effects,
+/// if every return statement of \p FD returns the same integer constant or
+/// the same parameter, unchanged.
+static Optional<SVal> getSummarizedReturnValue(const FunctionDecl *FD,
+                                               const CallEvent &Call,
+                                               SValBuilder &SVB) {
+  QualType ResultTy = Call.getResultType();
+  if (!ResultTy->isIntegralOrEnumerationType())
+    return None;
+
+  SmallVector<const ReturnStmt *, 4> Returns;
+  collectReturnStmts(FD->getBody(), Returns);
+  if (Returns.empty())
+    return None;
+
+  Optional<llvm::APSInt> Constant;
+  const ParmVarDecl *Param = nullptr;
+  for (const ReturnStmt *RS : Returns) {
+    const Expr *RetVal = RS->getRetValue();
+    if (!RetVal || RetVal->isValueDependent())
+      return None;
+    Expr::EvalResult Result;
+    if (RetVal->EvaluateAsInt(Result, SVB.getContext())) {
+      if (Param || (Constant && !llvm::APSInt::isSameValue(
+                                    *Constant, Result.Val.getInt())))
+        return None;
+      Constant = Result.Val.getInt();
+      continue;
+    }
+    const auto *DRE = dyn_cast<DeclRefExpr>(RetVal->IgnoreParenImpCasts());
+    const auto *PVD = DRE ? dyn_cast<ParmVarDecl>(DRE->getDecl()) : nullptr;
+    if (!PVD || Constant || (Param && Param != PVD))
+      return None;
+    Param = PVD;
+  }
+
+  if (Constant)
+    return SVal(SVB.makeIntVal(*Constant));
+  unsigned Index = Param->getFunctionScopeIndex();
+  if (!Param->getType()->isIntegralOrEnumerationType() ||
+      Index >= Call.getNumArgs() || !isOnlyRead(Param, FD->getBody()))
+    return None;
+  return SVB.evalCast(Call.getArgSVal(Index), ResultTy, Param->getType());
+}
+
+void ExprEngine::summarizedEvalCall(const CallEvent &Call, const Decl *D,
+                                    NodeBuilder &Bldr, ExplodedNode *Pred,
+                                    ProgramStateRef State) {
+  // The callee cannot have changed any memory the caller can observe, so
+  // there is nothing to invalidate. Nothing protects against a callee that
+  // is wrongly considered free of side effects: the caller keeps the old
+  // values of whatever it changed. This is why stmtMayHaveSideEffects()
+  // treats anything it doesn't understand as a side effect.
+  //
+  // This is unsound: the callee's body is not visited, so checkers see none
+  // of its events and miss the bugs that depend on the caller's values.
+  const LocationContext *LCtx = Pred->getLocationContext();
+  if (Optional<SVal> V = getSummarizedReturnValue(cast<FunctionDecl>(D), Call,
+                                                  svalBuilder))
+    State = State->BindExpr(Call.getOriginExpr(), LCtx, *V);
+  else
+    State = bindReturnValue(Call, LCtx, State);
+  Bldr.generateNode(Call.getProgramPoint(), State, Pred);
+  NumSummarizedCalls++;
+}
+
+/// Returns true if writing to the given lvalue only changes a non-static
+/// variable of the function being examined, which no caller can observe.
+static bool isLocalVariable(const Expr *E) {
+  while (true) {
+    E = E->IgnoreParens();
+    if (const auto *ME = dyn_cast<MemberExpr>(E)) {
+      // Assigning to a reference member writes to the referenced object.
+      if (ME->isArrow() || ME->getMemberDecl()->getType()->isReferenceType())
+        return false;
+      E = ME->getBase();
+    } else if (const auto *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+      // Only subscripts of arrays, not of pointers, stay within the variable.
+      E = ASE->getBase()->IgnoreParenImpCasts();
+      if (!E->getType()->isArrayType())
+        return false;
+    } else {
+      break;
+    }
+  }
+
+  const auto *DRE = dyn_cast<DeclRefExpr>(E);
+  if (!DRE || DRE->refersToEnclosingVariableOrCapture())
+    return false;
+  const auto *VD = dyn_cast<VarDecl>(DRE->getDecl());
+  return VD && VD->hasLocalStorage() && !VD->getType()->isReferenceType() &&
+         !VD->getType().isVolatileQualified();
+}
+
+/// Returns true if executing the statement may have effects visible to the
+/// callers of the function containing it, other than the returned value.
+/// Anything that is not understood counts as a side effect.
+static bool stmtMayHaveSideEffects(
+    const Stmt *S,
+    llvm::function_ref<bool(const FunctionDecl *)> CalleeMayHaveSideEffects) {
+  if (!S)
+    return false;
+
+  switch (S->getStmtClass()) {
+  case Stmt::BinaryOperatorClass:
+  case Stmt::CompoundAssignOperatorClass: {
+    const auto *BO = cast<BinaryOperator>(S);
+    if (BO->isAssignmentOp() && !isLocalVariable(BO->getLHS()))
+      return true;
+    break;
+  }
+  case Stmt::UnaryOperatorClass: {
+    const auto *UO = cast<UnaryOperator>(S);
+    if (UO->isIncrementDecrementOp() && !isLocalVariable(UO->getSubExpr()))
+      return true;
+    break;
+  }
+  case Stmt::DeclRefExprClass:
+    if (cast<DeclRefExpr>(S)->getType().isVolatileQualified())
+      return true;
+    break;
+  // Default arguments and member initializers are not children of the
+  // expressions using them.
+  case Stmt::CXXDefaultArgExprClass:
+    return stmtMayHaveSideEffects(cast<CXXDefaultArgExpr>(S)->getExpr(),
+                                  CalleeMayHaveSideEffects);
+  case Stmt::CXXDefaultInitExprClass:
+    return stmtMayHaveSideEffects(cast<CXXDefaultInitExpr>(S)->getExpr(),
+                                  CalleeMayHaveSideEffects);
+  case Stmt::DeclStmtClass:
+    for (const Decl *D : cast<DeclStmt>(S)->decls()) {
+      const auto *VD = dyn_cast<VarDecl>(D);
+      if (!VD)
+        continue;
+      // Static locals outlive the call, and destructors run implicitly.
+      if (VD->isStaticLocal())
+        return true;
+      if (const CXXRecordDecl *RD = VD->getType()->getAsCXXRecordDecl())
+        if (!RD->hasTrivialDestructor())
+          return true;
+    }
+    break;
+  case Stmt::CallExprClass:
+  case Stmt::CXXMemberCallExprClass:
+  case Stmt::CXXOperatorCallExprClass:
+  case Stmt::CUDAKernelCallExprClass:
+  case Stmt::UserDefinedLiteralClass: {
+    const FunctionDecl *Callee = cast<CallExpr>(S)->getDirectCallee();
+    if (!Callee || CalleeMayHaveSideEffects(Callee))
+      return true;
+    break;
+  }
+  case Stmt::AtomicExprClass:
+  case Stmt::BlockExprClass:
+  case Stmt::CoawaitExprClass:
+  case Stmt::CoreturnStmtClass:
+  case Stmt::CoroutineBodyStmtClass:
+  case Stmt::CoyieldExprClass:
+  case Stmt::CXXBindTemporaryExprClass:
+  case Stmt::CXXConstructExprClass:
+  case Stmt::CXXDeleteExprClass:
+  case Stmt::CXXInheritedCtorInitExprClass:
+  case Stmt::CXXNewExprClass:
+  case Stmt::CXXTemporaryObjectExprClass:
+  case Stmt::CXXThrowExprClass:
+  case Stmt::CXXTryStmtClass:
+  case Stmt::DependentCoawaitExprClass:
+  case Stmt::GCCAsmStmtClass:
+  case Stmt::LambdaExprClass:
+  case Stmt::MSAsmStmtClass:
+  case Stmt::ObjCAtSynchronizedStmtClass:
+  case Stmt::ObjCAtThrowStmtClass:
+  case Stmt::ObjCAtTryStmtClass:
+  case Stmt::ObjCMessageExprClass:
+  case Stmt::PseudoObjectExprClass:
+  case Stmt::SEHTryStmtClass:
+    return true;
+  default:
+    break;
+  }
+
+  for (const Stmt *Child : S->children())
+    if (stmtMayHaveSideEffects(Child, CalleeMayHaveSideEffects))
+      return true;
+  return false;
+}
+
+bool ExprEngine::mayHaveSideEffects(const Decl *D) {
+  Optional<bool> MayHaveSideEffects =
+      Engine.FunctionSummaries->mayHaveSideEffects(D);
+  if (MayHaveSideEffects.hasValue())
+    return MayHaveSideEffects.getValue();
+
+  // Assume side effects while the body is examined, so that recursive calls
+  // are treated conservatively.
+  Engine.FunctionSummaries->markSideEffects(D, true);
+
+  // Methods may be overridden and may change the object they are called on,
+  // so only plain functions are examined.
+  const auto *FD = dyn_cast<FunctionDecl>(D);
+  bool Result =
+      !FD || isa<CXXMethodDecl>(FD) || !FD->hasBody() ||
+      stmtMayHaveSideEffects(FD->getBody(), [this](const FunctionDecl *Callee) {
+        // Functions declared pure or const promise to have no side effects,
+        // even if their bodies are not available.
+        if (Callee->hasAttr<PureAttr>() || Callee->hasAttr<ConstAttr>())
+          return false;
+        const FunctionDecl *Definition;
+        return Callee->getBuiltinID() || !Callee->hasBody(Definition) ||
+               mayHaveSideEffects(Definition);
+      });
+
+  Engine.FunctionSummaries->markSideEffects(D, Result);
+  return Result;
+}
+
+/// Returns true if a conjured value of the given type is as precise as the
+/// value a function may return. A returned pointer may alias one of the
+/// arguments, which a conjured pointer would lose.
+static bool isSummarizableReturnType(QualType T) {
+  return T->isVoidType() || T->isIntegralOrEnumerationType() ||
+         T->isRealFloatingType();
+}
+
 ExprEngine::CallInlinePolicy
 ExprEngine::mayInlineCallKind(const CallEvent &Call, const ExplodedNode *Pred,
                               AnalyzerOptions &Opts,
@@ -890,6 +1148,18 @@ static bool mayInlineDecl(AnalysisManager &AMgr,
   return true;
 }
 
+/// Returns true if the function in \p CalleeADC is not inlined because it is
+/// too large, or because inlining it exceeded the maximum block count before.
+static bool isOverInliningBudget(AnalysisManager &AMgr,
+                                 AnalysisDeclContext *CalleeADC,
+                                 FunctionSummariesTy &FunctionSummaries) {
+  if (FunctionSummaries.hasReachedMaxBlockCount(CalleeADC->getDecl()))
+    return true;
+  const CFG *CalleeCFG = CalleeADC->getCFG();
+  return CalleeCFG &&
+         CalleeCFG->getNumBlockIDs() > AMgr.options.MaxInlinableSize;
+}
+
 bool ExprEngine::shouldInlineCall(const CallEvent &Call, const Decl *D,
                                   const ExplodedNode *Pred,
                                   const EvalCallOptions &CallOpts) {
@@ -913,8 +1183,11 @@ bool ExprEngine::shouldInlineCall(const CallEvent &Call, const Decl *D,
   // Check if this function has been marked as non-inlinable.
   Optional<bool> MayInline = Engine.FunctionSummaries->mayInline(D);
   if (MayInline.hasValue()) {
-    if (!MayInline.getValue())
+    if (!MayInline.getValue()) {
+      if (isOverInliningBudget(AMgr, CalleeADC, *Engine.FunctionSummaries))
+        ExceededInliningBudget = true;
       return false;
+    }
 
   } else {
     // We haven't actually checked the static properties of this function yet.
@@ -923,6 +1196,8 @@ bool ExprEngine::shouldInlineCall(const CallEvent &Call, const Decl *D,
       Engine.FunctionSummaries->markMayInline(D);
     } else {
       Engine.FunctionSummaries->markShouldNotInline(D);
+      if (isOverInliningBudget(AMgr, CalleeADC, *Engine.FunctionSummaries))
+        ExceededInliningBudget = true;
       return false;
     }
   }
@@ -957,6 +1232,7 @@ bool ExprEngine::shouldInlineCall(const CallEvent &Call, const Decl *D,
        CalleeCFG->getNumBlockIDs() >=
        Opts.MinCFGSizeTreatFunctionsAsLarge) {
     NumReachedInlineCountMax++;
+    ExceededInliningBudget = true;
     return false;
   }
 
@@ -1007,6 +1283,16 @@ void ExprEngine::defaultEvalCall(NodeBuilder &Bldr, ExplodedNode *Pred,
   } else {
     RuntimeDefinition RD = Call->getRuntimeDefinition();
     const Decl *D = RD.getDecl();
+
+    // Functions without side effects need not be analyzed at every call site.
+    if (D && getAnalysisManager().options.ShouldUseSideEffectSummaries &&
+        Call->getKind() == CE_Function && !RD.mayHaveOtherDefinitions() &&
+        isSummarizableReturnType(Call->getResultType()) &&
+        !mayHaveSideEffects(D)) {
+      summarizedEvalCall(*Call, D, Bldr, Pred, State);
+      return;
+    }
+
     if (shouldInlineCall(*Call, D, Pred, CallOpts)) {
       if (RD.mayHaveOtherDefinitions()) {
         AnalyzerOptions &Options = getAnalysisManager().options;
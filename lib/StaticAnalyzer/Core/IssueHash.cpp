@@ -16,7 +16,6 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
-#include "llvm/Support/LineIterator.h"
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
 
@@ -121,23 +120,27 @@ static std::string GetEnclosingDeclContextSignature(const Decl *D) {
   return "";
 }
 
-static StringRef GetNthLineOfFile(llvm::MemoryBuffer *Buffer, int Line) {
-  if (!Buffer)
+static StringRef GetNthLineOfFile(const SourceManager &SM, FileID FID,
+                                  unsigned Line) {
+  // Look the line up in the line table of the file, which the SourceManager
+  // computes once and shares among all reports, instead of scanning the
+  // buffer from its start for every report.
+  bool Invalid = false;
+  StringRef Buffer = SM.getBufferData(FID, &Invalid);
+  if (Invalid)
     return "";
 
-  llvm::line_iterator LI(*Buffer, false);
-  for (; !LI.is_at_eof() && LI.line_number() != Line; ++LI)
-    ;
-
-  return *LI;
+  SourceLocation LineStart = SM.translateLineCol(FID, Line, 1);
+  StringRef Rest = Buffer.substr(SM.getFileOffset(LineStart));
+  return Rest.substr(0, Rest.find_first_of("\r\n"));
 }
 
 static std::string NormalizeLine(const SourceManager &SM, FullSourceLoc &L,
                                  const LangOptions &LangOpts) {
   static StringRef Whitespaces = " \t\n";
 
-  StringRef Str = GetNthLineOfFile(SM.getBuffer(L.getFileID(), L),
-                                   L.getExpansionLineNumber());
+  StringRef Str =
+      GetNthLineOfFile(SM, L.getFileID(), L.getExpansionLineNumber());
   StringRef::size_type col = Str.find_first_not_of(Whitespaces);
   if (col == StringRef::npos)
     col = 1; // The line only contains whitespace.
@@ -87,6 +87,10 @@ ProgramStateManager::ProgramStateManager(ASTContext &Ctx,
 
 
 ProgramStateManager::~ProgramStateManager() {
+  // The constraint manager may retain sets created by the GDM factories, which
+  // must be released before the factories are freed below.
+  ConstraintMgr.reset();
+
   for (GDMContextsTy::iterator I=GDMContexts.begin(), E=GDMContexts.end();
        I!=E; ++I)
     I->second.second(I->second.first);
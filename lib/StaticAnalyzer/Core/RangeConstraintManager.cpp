@@ -18,11 +18,19 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/RangedConstraintManager.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "RangeConstraintManager"
+
+STATISTIC(NumUnchangedIntersections,
+          "The # of range set intersections that left the set unchanged");
+STATISTIC(NumDefaultRangesReused,
+          "The # of times the range of an unconstrained symbol was reused");
+
 void RangeSet::IntersectInRange(BasicValueFactory &BV, Factory &F,
                       const llvm::APSInt &Lower, const llvm::APSInt &Upper,
                       PrimRangeSet &newRanges, PrimRangeSet::iterator &i,
@@ -65,6 +73,11 @@ const llvm::APSInt &RangeSet::getMinValue() const {
   return ranges.begin()->From();
 }
 
+const llvm::APSInt &RangeSet::getMaxValue() const {
+  assert(!isEmpty());
+  return ranges.getRootWithoutRetain()->getMaxElement()->getValue().To();
+}
+
 bool RangeSet::pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
   // This function has nine cases, the cartesian product of range-testing
   // both the upper and lower bounds against the symbol's type.
@@ -158,6 +171,14 @@ RangeSet RangeSet::Intersect(BasicValueFactory &BV, Factory &F,
   if (!pin(Lower, Upper))
     return F.getEmptySet();
 
+  // Most assumptions do not refine the set at all. Detect this from the
+  // bounds of the set, instead of rebuilding the same set range by range.
+  if (Lower <= Upper ? Lower <= getMinValue() && getMaxValue() <= Upper
+                     : getMaxValue() <= Upper || Lower <= getMinValue()) {
+    ++NumUnchangedIntersections;
+    return *this;
+  }
+
   PrimRangeSet newRanges = F.getEmptySet();
 
   PrimRangeSet::iterator i = begin(), e = end();
@@ -283,7 +304,12 @@ public:
 private:
   RangeSet::Factory F;
 
+  /// The ranges of unconstrained symbols, which only depend on the symbol.
+  /// Declared after F, because the range sets must be released before it.
+  llvm::DenseMap<SymbolRef, RangeSet> DefaultRanges;
+
   RangeSet getRange(ProgramStateRef State, SymbolRef Sym);
+  RangeSet getDefaultRange(SymbolRef Sym);
   const RangeSet* getRangeForMinusSymbol(ProgramStateRef State,
                                          SymbolRef Sym);
 
@@ -455,20 +481,9 @@ static RangeSet applyBitwiseConstraints(
   return Input;
 }
 
-RangeSet RangeConstraintManager::getRange(ProgramStateRef State,
-                                          SymbolRef Sym) {
-  if (ConstraintRangeTy::data_type *V = State->get<ConstraintRange>(Sym))
-    return *V;
-
-  BasicValueFactory &BV = getBasicVals();
-
-  // If Sym is a difference of symbols A - B, then maybe we have range set
-  // stored for B - A.
-  if (const RangeSet *R = getRangeForMinusSymbol(State, Sym))
-    return R->Negate(BV, F);
-
-  // Lazily generate a new RangeSet representing all possible values for the
-  // given symbol type.
+/// Returns the set of all values an unconstrained symbol may take.
+static RangeSet computeDefaultRange(BasicValueFactory &BV, RangeSet::Factory &F,
+                                    SymbolRef Sym) {
   QualType T = Sym->getType();
 
   RangeSet Result(F, BV.getMinValue(T), BV.getMaxValue(T));
@@ -484,6 +499,33 @@ RangeSet RangeConstraintManager::getRange(ProgramStateRef State,
   return Result;
 }
 
+RangeSet RangeConstraintManager::getRange(ProgramStateRef State,
+                                          SymbolRef Sym) {
+  if (ConstraintRangeTy::data_type *V = State->get<ConstraintRange>(Sym))
+    return *V;
+
+  // If Sym is a difference of symbols A - B, then maybe we have range set
+  // stored for B - A.
+  if (const RangeSet *R = getRangeForMinusSymbol(State, Sym))
+    return R->Negate(getBasicVals(), F);
+
+  return getDefaultRange(Sym);
+}
+
+RangeSet RangeConstraintManager::getDefaultRange(SymbolRef Sym) {
+  // Unlike the ranges above, this one does not depend on the state, so it is
+  // computed once per symbol rather than on every query.
+  auto I = DefaultRanges.find(Sym);
+  if (I != DefaultRanges.end()) {
+    ++NumDefaultRangesReused;
+    return I->second;
+  }
+
+  RangeSet Result = computeDefaultRange(getBasicVals(), F, Sym);
+  DefaultRanges.insert({Sym, Result});
+  return Result;
+}
+
 // FIXME: Once SValBuilder supports unary minus, we should use SValBuilder to
 //        obtain the negated symbolic expression instead of constructing the
 //        symbol manually. This will allow us to support finding ranges of not
@@ -16,9 +16,12 @@
 #include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
 #include "clang/StaticAnalyzer/Core/BugReporter/PathDiagnostic.h"
 #include "clang/StaticAnalyzer/Core/PathDiagnosticConsumers.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/JSON.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 
 using namespace llvm;
@@ -28,10 +31,11 @@ using namespace ento;
 namespace {
 class SarifDiagnostics : public PathDiagnosticConsumer {
   std::string OutputFile;
+  bool AppendRuns;
 
 public:
-  SarifDiagnostics(AnalyzerOptions &, const std::string &Output)
-      : OutputFile(Output) {}
+  SarifDiagnostics(AnalyzerOptions &AnalyzerOpts, const std::string &Output)
+      : OutputFile(Output), AppendRuns(AnalyzerOpts.ShouldAppendSarifRuns) {}
   ~SarifDiagnostics() override = default;
 
   void FlushDiagnosticsImpl(std::vector<const PathDiagnostic *> &Diags,
@@ -107,40 +111,51 @@ static std::string fileNameToURI(StringRef Filename) {
   return Ret.str().str();
 }
 
-static json::Object createFileLocation(const FileEntry &FE) {
-  return json::Object{{"uri", fileNameToURI(getFileName(FE))}};
-}
-
-static json::Object createFile(const FileEntry &FE) {
-  return json::Object{{"fileLocation", createFileLocation(FE)},
+static json::Object createFile(const FileEntry &FE, StringRef FileURI) {
+  return json::Object{{"fileLocation", json::Object{{"uri", FileURI}}},
                       {"roles", json::Array{"resultFile"}},
                       {"length", FE.getSize()},
                       {"mimeType", "text/plain"}};
 }
 
-static json::Object createFileLocation(const FileEntry &FE,
-                                       json::Array &Files) {
-  std::string FileURI = fileNameToURI(getFileName(FE));
-
-  // See if the Files array contains this URI already. If it does not, create
-  // a new file object to add to the array.
-  auto I = llvm::find_if(Files, [&](const json::Value &File) {
-    if (const json::Object *Obj = File.getAsObject()) {
-      if (const json::Object *FileLoc = Obj->getObject("fileLocation")) {
-        Optional<StringRef> URI = FileLoc->getString("uri");
-        return URI && URI->equals(FileURI);
-      }
-    }
-    return false;
-  });
+namespace {
+/// The files referenced by the results of a run, in the order in which they
+/// are first referenced. The URI of each file is computed once, no matter how
+/// many locations of how many reports refer to it.
+class FileTable {
+  llvm::DenseMap<const FileEntry *, unsigned> Indices;
+  llvm::StringMap<unsigned> URIIndices;
+  std::vector<std::pair<const FileEntry *, std::string>> Files;
 
-  // Calculate the index within the file location array so it can be stored in
-  // the JSON object.
-  auto Index = static_cast<unsigned>(std::distance(Files.begin(), I));
-  if (I == Files.end())
-    Files.push_back(createFile(FE));
+public:
+  unsigned getIndex(const FileEntry &FE) {
+    auto I = Indices.find(&FE);
+    if (I != Indices.end())
+      return I->second;
+
+    // Distinct file entries may still refer to the same URI.
+    std::string FileURI = fileNameToURI(getFileName(FE));
+    auto P = URIIndices.insert({FileURI, Files.size()});
+    if (P.second)
+      Files.emplace_back(&FE, std::move(FileURI));
+    Indices[&FE] = P.first->second;
+    return P.first->second;
+  }
+
+  StringRef getURI(unsigned Index) const { return Files[Index].second; }
 
-  return json::Object{{"uri", FileURI}, {"fileIndex", Index}};
+  json::Array createFiles() const {
+    json::Array Ret;
+    for (const auto &File : Files)
+      Ret.push_back(createFile(*File.first, File.second));
+    return Ret;
+  }
+};
+} // end anonymous namespace
+
+static json::Object createFileLocation(const FileEntry &FE, FileTable &Files) {
+  unsigned Index = Files.getIndex(FE);
+  return json::Object{{"uri", Files.getURI(Index)}, {"fileIndex", Index}};
 }
 
 static json::Object createTextRegion(SourceRange R, const SourceManager &SM) {
@@ -153,7 +168,7 @@ static json::Object createTextRegion(SourceRange R, const SourceManager &SM) {
 
 static json::Object createPhysicalLocation(SourceRange R, const FileEntry &FE,
                                            const SourceManager &SMgr,
-                                           json::Array &Files) {
+                                           FileTable &Files) {
   return json::Object{{{"fileLocation", createFileLocation(FE, Files)},
                        {"region", createTextRegion(R, SMgr)}}};
 }
@@ -207,7 +222,7 @@ static Importance calculateImportance(const PathDiagnosticPiece &Piece) {
 }
 
 static json::Object createThreadFlow(const PathPieces &Pieces,
-                                     json::Array &Files) {
+                                     FileTable &Files) {
   const SourceManager &SMgr = Pieces.front()->getLocation().getManager();
   json::Array Locations;
   for (const auto &Piece : Pieces) {
@@ -223,7 +238,7 @@ static json::Object createThreadFlow(const PathPieces &Pieces,
 }
 
 static json::Object createCodeFlow(const PathPieces &Pieces,
-                                   json::Array &Files) {
+                                   FileTable &Files) {
   return json::Object{
       {"threadFlows", json::Array{createThreadFlow(Pieces, Files)}}};
 }
@@ -235,7 +250,7 @@ static json::Object createTool() {
                       {"version", getClangFullVersion()}};
 }
 
-static json::Object createResult(const PathDiagnostic &Diag, json::Array &Files,
+static json::Object createResult(const PathDiagnostic &Diag, FileTable &Files,
                                  const StringMap<unsigned> &RuleMapping) {
   const PathPieces &Path = Diag.path.flatten(false);
   const SourceManager &SMgr = Path.front()->getLocation().getManager();
@@ -312,38 +327,158 @@ static json::Object createResources(std::vector<const PathDiagnostic *> &Diags,
   return json::Object{{"rules", createRules(Diags, RuleMapping)}};
 }
 
-static json::Object createRun(std::vector<const PathDiagnostic *> &Diags) {
-  json::Array Results, Files;
+/// Registers the files referenced by a result in the order in which
+/// createResult() refers to them, so that the file table of the run is
+/// complete before any result is written.
+static void addResultFiles(const PathDiagnostic &Diag, FileTable &Files) {
+  for (const auto &Piece : Diag.path.flatten(false))
+    Files.getIndex(*Piece->getLocation().asLocation().getFileEntry());
+  Files.getIndex(*Diag.getLocation().asLocation().getFileEntry());
+}
+
+/// Writes a pretty-printed JSON value, indenting all of its lines but the
+/// first, so that it nests into the output that is written by hand around it.
+static void writeValue(raw_ostream &OS, json::Value V, unsigned Indent) {
+  std::string Str;
+  llvm::raw_string_ostream SOS(Str);
+  SOS << llvm::formatv("{0:2}", V);
+
+  // Strings in JSON cannot contain line breaks, so every line break of the
+  // output is one inserted by the pretty printer.
+  SmallVector<StringRef, 32> Lines;
+  StringRef(SOS.str()).split(Lines, '\n');
+  for (unsigned I = 0, E = Lines.size(); I != E; ++I) {
+    if (I != 0)
+      OS.indent(Indent);
+    OS << Lines[I];
+    if (I + 1 != E)
+      OS << '\n';
+  }
+}
+
+/// Writes a run as an element of the "runs" array. The results are created
+/// and written one at a time, so a translation unit with many reports never
+/// holds the JSON representation of all of them.
+static void writeRun(raw_ostream &OS,
+                     std::vector<const PathDiagnostic *> &Diags) {
+  FileTable Files;
   StringMap<unsigned> RuleMapping;
   json::Object Resources = createResources(Diags, RuleMapping);
-  
-  llvm::for_each(Diags, [&](const PathDiagnostic *D) {
-    Results.push_back(createResult(*D, Files, RuleMapping));
-  });
+  for (const PathDiagnostic *D : Diags)
+    addResultFiles(*D, Files);
+
+  // The members are written in the order in which json::Object would print
+  // them.
+  OS.indent(4) << "{\n";
+  OS.indent(6) << "\"files\": ";
+  writeValue(OS, Files.createFiles(), 6);
+  OS << ",\n";
+  OS.indent(6) << "\"resources\": ";
+  writeValue(OS, std::move(Resources), 6);
+  OS << ",\n";
+  OS.indent(6) << "\"results\": [";
+  for (auto I = Diags.begin(), E = Diags.end(); I != E; ++I) {
+    OS << (I == Diags.begin() ? "\n" : ",\n");
+    OS.indent(8);
+    writeValue(OS, createResult(**I, Files, RuleMapping), 8);
+  }
+  if (!Diags.empty()) {
+    OS << '\n';
+    OS.indent(6);
+  }
+  OS << "],\n";
+  OS.indent(6) << "\"tool\": ";
+  writeValue(OS, createTool(), 6);
+  OS << '\n';
+  OS.indent(4) << '}';
+}
 
-  return json::Object{{"tool", createTool()},
-                      {"resources", std::move(Resources)},
-                      {"results", std::move(Results)},
-                      {"files", std::move(Files)}};
+static const char SarifSchema[] =
+    "http://json.schemastore.org/sarif-2.0.0-csd.2.beta.2018-11-28";
+static const char SarifVersion[] = "2.0.0-csd.2.beta.2018-11-28";
+
+/// Returns the text that ends every SARIF file written by this consumer.
+static std::string getSarifTrailer() {
+  return (Twine("\n  ],\n  \"version\": \"") + SarifVersion + "\"\n}\n").str();
 }
 
-void SarifDiagnostics::FlushDiagnosticsImpl(
-    std::vector<const PathDiagnostic *> &Diags, FilesMade *) {
-  // We currently overwrite the file if it already exists. However, it may be
-  // useful to add a feature someday that allows the user to append a run to an
-  // existing SARIF file. One danger from that approach is that the size of the
-  // file can become large very quickly, so decoding into JSON to append a run
-  // may be an expensive operation.
+/// Appends a run to a SARIF file previously written by this consumer. The
+/// runs already in the file are neither read nor decoded: the trailer that
+/// closes the "runs" array is overwritten by the new run and written again.
+/// Returns false if the file does not exist or was not written by us, in
+/// which case the caller writes a new file.
+static bool appendRun(StringRef OutputFile,
+                      std::vector<const PathDiagnostic *> &Diags) {
+  std::string Trailer = getSarifTrailer();
+  uint64_t Size;
+  if (llvm::sys::fs::file_size(OutputFile, Size) || Size < Trailer.size())
+    return false;
+
+  uint64_t Offset = Size - Trailer.size();
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Tail =
+      MemoryBuffer::getFileSlice(OutputFile, Trailer.size(), Offset);
+  if (!Tail || (*Tail)->getBuffer() != Trailer)
+    return false;
+
+  int FD;
+  if (std::error_code EC = llvm::sys::fs::openFileForReadWrite(
+          OutputFile, FD, llvm::sys::fs::CD_OpenExisting,
+          llvm::sys::fs::F_None)) {
+    llvm::errs() << "warning: could not open file: " << EC.message() << '\n';
+    return true;
+  }
+
+  llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  OS.seek(Offset);
+  OS << ",\n";
+  writeRun(OS, Diags);
+  OS << Trailer;
+  return true;
+}
+
+static void writeSarif(StringRef OutputFile,
+                       std::vector<const PathDiagnostic *> &Diags) {
+  // The file is written in binary mode, so that appendRun() finds the trailer
+  // exactly as it is written here on every host.
   std::error_code EC;
-  llvm::raw_fd_ostream OS(OutputFile, EC, llvm::sys::fs::F_Text);
+  llvm::raw_fd_ostream OS(OutputFile, EC, llvm::sys::fs::F_None);
   if (EC) {
     llvm::errs() << "warning: could not create file: " << EC.message() << '\n';
     return;
   }
-  json::Object Sarif{
-      {"$schema",
-       "http://json.schemastore.org/sarif-2.0.0-csd.2.beta.2018-11-28"},
-      {"version", "2.0.0-csd.2.beta.2018-11-28"},
-      {"runs", json::Array{createRun(Diags)}}};
-  OS << llvm::formatv("{0:2}", json::Value(std::move(Sarif)));
+
+  OS << "{\n";
+  OS.indent(2) << "\"$schema\": \"" << SarifSchema << "\",\n";
+  OS.indent(2) << "\"runs\": [\n";
+  writeRun(OS, Diags);
+  OS << getSarifTrailer();
+}
+
+void SarifDiagnostics::FlushDiagnosticsImpl(
+    std::vector<const PathDiagnostic *> &Diags, FilesMade *) {
+  // Unless runs are appended, we overwrite the file if it already exists.
+  if (!AppendRuns || OutputFile == "-") {
+    writeSarif(OutputFile, Diags);
+    return;
+  }
+
+  // Several analyzer invocations may append to the same file at once, so the
+  // file is only updated while holding its lock.
+  while (true) {
+    llvm::LockFileManager Lock(OutputFile);
+    switch (Lock) {
+    case llvm::LockFileManager::LFS_Error:
+      // Rather than losing the results, update the file without the lock.
+      Lock.unsafeRemoveLockFile();
+      LLVM_FALLTHROUGH;
+    case llvm::LockFileManager::LFS_Owned:
+      if (!appendRun(OutputFile, Diags))
+        writeSarif(OutputFile, Diags);
+      return;
+    case llvm::LockFileManager::LFS_Shared:
+      if (Lock.waitForUnlock() == llvm::LockFileManager::Res_Timeout)
+        Lock.unsafeRemoveLockFile();
+      continue;
+    }
+  }
 }
@@ -24,6 +24,7 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/SymExpr.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -33,6 +34,15 @@
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "SymbolManager"
+
+STATISTIC(NumSymbolsCreated,
+          "The # of symbols and symbolic expressions created");
+STATISTIC(NumSymbolsReused,
+          "The # of symbol lookups that found an existing symbol");
+STATISTIC(NumSymbolBytes,
+          "The # of bytes allocated for symbols and symbolic expressions");
+
 void SymExpr::anchor() {}
 
 LLVM_DUMP_METHOD void SymExpr::dump() const {
@@ -165,6 +175,18 @@ void SymExpr::symbol_iterator::expand() {
   llvm_unreachable("unhandled expansion case");
 }
 
+template <typename SymExprT, typename... ArgsT>
+SymExpr *SymbolManager::createSymbol(void *InsertPos, ArgsT &&... Args) {
+  SymExpr *SD = new (BPAlloc.Allocate<SymExprT>())
+      SymExprT(std::forward<ArgsT>(Args)...);
+  DataSet.InsertNode(SD, InsertPos);
+  ++NumSymbolsCreated;
+  NumSymbolBytes += sizeof(SymExprT);
+  if (CountSymbolCreators)
+    ++SymbolsCreatedBy[Creator];
+  return SD;
+}
+
 const SymbolRegionValue*
 SymbolManager::getRegionValueSymbol(const TypedValueRegion* R) {
   llvm::FoldingSetNodeID profile;
@@ -172,10 +194,10 @@ SymbolManager::getRegionValueSymbol(const TypedValueRegion* R) {
   void *InsertPos;
   SymExpr *SD = DataSet.FindNodeOrInsertPos(profile, InsertPos);
   if (!SD) {
-    SD = (SymExpr*) BPAlloc.Allocate<SymbolRegionValue>();
-    new (SD) SymbolRegionValue(SymbolCounter, R);
-    DataSet.InsertNode(SD, InsertPos);
+    SD = createSymbol<SymbolRegionValue>(InsertPos, SymbolCounter, R);
     ++SymbolCounter;
+  } else {
+    ++NumSymbolsReused;
   }
 
   return cast<SymbolRegionValue>(SD);
@@ -191,10 +213,11 @@ const SymbolConjured* SymbolManager::conjureSymbol(const Stmt *E,
   void *InsertPos;
   SymExpr *SD = DataSet.FindNodeOrInsertPos(profile, InsertPos);
   if (!SD) {
-    SD = (SymExpr*) BPAlloc.Allocate<SymbolConjured>();
-    new (SD) SymbolConjured(SymbolCounter, E, LCtx, T, Count, SymbolTag);
-    DataSet.InsertNode(SD, InsertPos);
+    SD = createSymbol<SymbolConjured>(InsertPos, SymbolCounter, E, LCtx, T,
+                                      Count, SymbolTag);
     ++SymbolCounter;
+  } else {
+    ++NumSymbolsReused;
   }
 
   return cast<SymbolConjured>(SD);
@@ -208,10 +231,11 @@ SymbolManager::getDerivedSymbol(SymbolRef parentSymbol,
   void *InsertPos;
   SymExpr *SD = DataSet.FindNodeOrInsertPos(profile, InsertPos);
   if (!SD) {
-    SD = (SymExpr*) BPAlloc.Allocate<SymbolDerived>();
-    new (SD) SymbolDerived(SymbolCounter, parentSymbol, R);
-    DataSet.InsertNode(SD, InsertPos);
+    SD = createSymbol<SymbolDerived>(InsertPos, SymbolCounter, parentSymbol,
+                                     R);
     ++SymbolCounter;
+  } else {
+    ++NumSymbolsReused;
   }
 
   return cast<SymbolDerived>(SD);
@@ -224,10 +248,10 @@ SymbolManager::getExtentSymbol(const SubRegion *R) {
   void *InsertPos;
   SymExpr *SD = DataSet.FindNodeOrInsertPos(profile, InsertPos);
   if (!SD) {
-    SD = (SymExpr*) BPAlloc.Allocate<SymbolExtent>();
-    new (SD) SymbolExtent(SymbolCounter, R);
-    DataSet.InsertNode(SD, InsertPos);
+    SD = createSymbol<SymbolExtent>(InsertPos, SymbolCounter, R);
     ++SymbolCounter;
+  } else {
+    ++NumSymbolsReused;
   }
 
   return cast<SymbolExtent>(SD);
@@ -242,10 +266,11 @@ SymbolManager::getMetadataSymbol(const MemRegion* R, const Stmt *S, QualType T,
   void *InsertPos;
   SymExpr *SD = DataSet.FindNodeOrInsertPos(profile, InsertPos);
   if (!SD) {
-    SD = (SymExpr*) BPAlloc.Allocate<SymbolMetadata>();
-    new (SD) SymbolMetadata(SymbolCounter, R, S, T, LCtx, Count, SymbolTag);
-    DataSet.InsertNode(SD, InsertPos);
+    SD = createSymbol<SymbolMetadata>(InsertPos, SymbolCounter, R, S, T, LCtx,
+                                      Count, SymbolTag);
     ++SymbolCounter;
+  } else {
+    ++NumSymbolsReused;
   }
 
   return cast<SymbolMetadata>(SD);
@@ -258,11 +283,10 @@ SymbolManager::getCastSymbol(const SymExpr *Op,
   SymbolCast::Profile(ID, Op, From, To);
   void *InsertPos;
   SymExpr *data = DataSet.FindNodeOrInsertPos(ID, InsertPos);
-  if (!data) {
-    data = (SymbolCast*) BPAlloc.Allocate<SymbolCast>();
-    new (data) SymbolCast(Op, From, To);
-    DataSet.InsertNode(data, InsertPos);
-  }
+  if (!data)
+    data = createSymbol<SymbolCast>(InsertPos, Op, From, To);
+  else
+    ++NumSymbolsReused;
 
   return cast<SymbolCast>(data);
 }
@@ -276,11 +300,10 @@ const SymIntExpr *SymbolManager::getSymIntExpr(const SymExpr *lhs,
   void *InsertPos;
   SymExpr *data = DataSet.FindNodeOrInsertPos(ID, InsertPos);
 
-  if (!data) {
-    data = (SymIntExpr*) BPAlloc.Allocate<SymIntExpr>();
-    new (data) SymIntExpr(lhs, op, v, t);
-    DataSet.InsertNode(data, InsertPos);
-  }
+  if (!data)
+    data = createSymbol<SymIntExpr>(InsertPos, lhs, op, v, t);
+  else
+    ++NumSymbolsReused;
 
   return cast<SymIntExpr>(data);
 }
@@ -294,11 +317,10 @@ const IntSymExpr *SymbolManager::getIntSymExpr(const llvm::APSInt& lhs,
   void *InsertPos;
   SymExpr *data = DataSet.FindNodeOrInsertPos(ID, InsertPos);
 
-  if (!data) {
-    data = (IntSymExpr*) BPAlloc.Allocate<IntSymExpr>();
-    new (data) IntSymExpr(lhs, op, rhs, t);
-    DataSet.InsertNode(data, InsertPos);
-  }
+  if (!data)
+    data = createSymbol<IntSymExpr>(InsertPos, lhs, op, rhs, t);
+  else
+    ++NumSymbolsReused;
 
   return cast<IntSymExpr>(data);
 }
@@ -312,11 +334,10 @@ const SymSymExpr *SymbolManager::getSymSymExpr(const SymExpr *lhs,
   void *InsertPos;
   SymExpr *data = DataSet.FindNodeOrInsertPos(ID, InsertPos);
 
-  if (!data) {
-    data = (SymSymExpr*) BPAlloc.Allocate<SymSymExpr>();
-    new (data) SymSymExpr(lhs, op, rhs, t);
-    DataSet.InsertNode(data, InsertPos);
-  }
+  if (!data)
+    data = createSymbol<SymSymExpr>(InsertPos, lhs, op, rhs, t);
+  else
+    ++NumSymbolsReused;
 
   return cast<SymSymExpr>(data);
 }
@@ -14,6 +14,7 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/SMTConv.h"
 
 #include "clang/Config/config.h"
+#include "llvm/ADT/Statistic.h"
 
 using namespace clang;
 using namespace ento;
@@ -22,6 +23,16 @@ using namespace ento;
 
 #include <z3.h>
 
+#define DEBUG_TYPE "Z3ConstraintManager"
+
+STATISTIC(NumSMTQueries, "The # of queries checked by the SMT solver");
+STATISTIC(NumSMTCachedQueries,
+          "The # of SMT queries answered from the query cache");
+STATISTIC(NumSMTConstraintsAsserted,
+          "The # of constraints asserted on the SMT solver");
+STATISTIC(NumSMTConstraintsReused,
+          "The # of constraints kept asserted between SMT queries");
+
 namespace {
 
 /// Configuration class for Z3
@@ -797,6 +808,16 @@ public:
 
   bool isFPSupported() override { return true; }
 
+  void setTimeout(unsigned Milliseconds) override {
+    Z3_params Params = Z3_mk_params(Context.Context);
+    Z3_params_inc_ref(Context.Context, Params);
+    Z3_params_set_uint(Context.Context, Params,
+                       Z3_mk_string_symbol(Context.Context, "timeout"),
+                       Milliseconds ? Milliseconds : UINT_MAX);
+    Z3_solver_set_params(Context.Context, Solver, Params);
+    Z3_params_dec_ref(Context.Context, Params);
+  }
+
   /// Reset the solver and remove all constraints.
   void reset() override { Z3_solver_reset(Context.Context, Solver); }
 
@@ -810,7 +831,21 @@ class Z3ConstraintManager : public SMTConstraintManager<ConstraintZ3, Z3Expr> {
 
 public:
   Z3ConstraintManager(SubEngine *SE, SValBuilder &SB)
-      : SMTConstraintManager(SE, SB, Solver) {}
+      : SMTConstraintManager(SE, SB, Solver) {
+    if (SE && SE->getAnalysisManager().options.PrintStats)
+      enableSolverTimers();
+  }
+
+  ~Z3ConstraintManager() override {
+    const SMTQueryStats &Stats = getQueryStats();
+    NumSMTQueries += Stats.NumQueries;
+    NumSMTCachedQueries += Stats.NumCachedQueries;
+    NumSMTConstraintsAsserted += Stats.NumConstraintsAsserted;
+    NumSMTConstraintsReused += Stats.NumConstraintsReused;
+
+    // The base class is destroyed after Solver and its Z3 context.
+    releaseSolverExprs();
+  }
 }; // end class Z3ConstraintManager
 
 } // end anonymous namespace
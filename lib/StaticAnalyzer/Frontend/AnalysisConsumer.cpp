@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Frontend/AnalysisConsumer.h"
+#include "AnalysisResultCache.h"
 #include "ModelInjector.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
@@ -37,6 +38,7 @@
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
@@ -60,6 +62,11 @@ STATISTIC(NumVisitedBlocksInAnalyzedFunctions,
           "The # of visited basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(NumResultCacheHits,
+          "The # of functions not analyzed as their results were cached.");
+STATISTIC(NumResultCacheMisses,
+          "The # of functions analyzed as their results were not cached.");
+STATISTIC(PercentResultCacheHits, "The % of functions with cached results.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -197,6 +204,14 @@ public:
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// The number of symbols created on behalf of each checker, summed over the
+  /// analyzed functions. Only collected when statistics are printed.
+  llvm::DenseMap<const ProgramPointTag *, unsigned> SymbolsCreatedBy;
+
+  /// The functions known from earlier runs to produce no reports. Only set
+  /// when a result cache directory is given.
+  std::unique_ptr<AnalysisResultCache> ResultCache;
+
   AnalysisConsumer(CompilerInstance &CI, const std::string &outdir,
                    AnalyzerOptionsRef opts, ArrayRef<std::string> plugins,
                    CodeInjector *injector)
@@ -216,9 +231,32 @@ public:
   ~AnalysisConsumer() override {
     if (Opts->PrintStats) {
       llvm::PrintStatistics();
+      printSymbolCreationStats(llvm::errs());
     }
   }
 
+  void printSymbolCreationStats(raw_ostream &OS) const {
+    if (SymbolsCreatedBy.empty())
+      return;
+
+    std::vector<std::pair<StringRef, unsigned>> Creators;
+    for (const auto &I : SymbolsCreatedBy)
+      Creators.emplace_back(I.first ? I.first->getTagDescription()
+                                    : StringRef("(analyzer core)"),
+                            I.second);
+    llvm::sort(Creators,
+               [](const std::pair<StringRef, unsigned> &LHS,
+                  const std::pair<StringRef, unsigned> &RHS) {
+                 if (LHS.second != RHS.second)
+                   return LHS.second > RHS.second;
+                 return LHS.first < RHS.first;
+               });
+
+    OS << "Symbols created per checker:\n";
+    for (const auto &C : Creators)
+      OS << llvm::format("%10u", C.second) << ' ' << C.first << '\n';
+  }
+
   void DigestAnalyzerOptions() {
     if (Opts->AnalysisDiagOpt != PD_NONE) {
       // Create the PathDiagnosticConsumer.
@@ -299,6 +337,12 @@ public:
     Mgr = llvm::make_unique<AnalysisManager>(
         *Ctx, PP.getDiagnostics(), PathConsumers, CreateStoreMgr,
         CreateConstraintMgr, checkerMgr.get(), *Opts, Injector);
+
+    // With cross translation unit analysis, bodies from other translation
+    // units may be inlined, which the cache knows nothing about.
+    if (!Opts->ResultCacheDir.empty() && !Opts->IsNaiveCTUEnabled)
+      ResultCache = llvm::make_unique<AnalysisResultCache>(Opts->ResultCacheDir,
+                                                           *Opts, *Ctx);
   }
 
   /// Store the top level decls in the set to be processed later on.
@@ -328,7 +372,10 @@ public:
                   ExprEngine::InliningModes IMode = ExprEngine::Inline_Minimal,
                   SetOfConstDecls *VisitedCallees = nullptr);
 
-  void RunPathSensitiveChecks(Decl *D,
+  /// \returns true if the results of the analysis may be cached, i.e. it
+  /// found no bugs and didn't skip inlining a call because of a size or count
+  /// limit.
+  bool RunPathSensitiveChecks(Decl *D,
                               ExprEngine::InliningModes IMode,
                               SetOfConstDecls *VisitedCallees);
 
@@ -595,6 +642,11 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
     PercentReachableBlocks =
       (FunctionSummaries.getTotalNumVisitedBasicBlocks() * 100) /
         NumBlocksInAnalyzedFunctions;
+  if (NumResultCacheHits + NumResultCacheMisses > 0)
+    PercentResultCacheHits = (NumResultCacheHits * 100) /
+                             (NumResultCacheHits + NumResultCacheMisses);
+  if (ResultCache)
+    ResultCache->prune();
 
   // Explicitly destroy the PathDiagnosticConsumer.  This will flush its output.
   // FIXME: This should be replaced with something that doesn't rely on
@@ -713,9 +765,30 @@ void AnalysisConsumer::HandleCode(Decl *D, AnalysisMode Mode,
   if (Mode & AM_Syntax)
     checkerMgr->runCheckersOnASTBody(D, *Mgr, BR);
   if ((Mode & AM_Path) && checkerMgr->hasPathSensitiveCheckers()) {
-    RunPathSensitiveChecks(D, IMode, VisitedCallees);
+    Optional<AnalysisResultCache::Entry> CacheEntry;
+    if (ResultCache && IMode != ExprEngine::Inline_Minimal)
+      CacheEntry = ResultCache->getEntry(D);
+
+    // Skip the function if an earlier run found no bugs in it, but still
+    // consider the functions that run inlined as analyzed.
+    SetOfConstDecls InlinedCallees;
+    if (CacheEntry && ResultCache->lookup(*CacheEntry, InlinedCallees)) {
+      NumResultCacheHits++;
+      if (VisitedCallees)
+        VisitedCallees->insert(InlinedCallees.begin(), InlinedCallees.end());
+      return;
+    }
+
+    bool MayCache = RunPathSensitiveChecks(D, IMode, VisitedCallees);
     if (IMode != ExprEngine::Inline_Minimal)
       NumFunctionsAnalyzed++;
+
+    if (CacheEntry) {
+      NumResultCacheMisses++;
+      if (MayCache)
+        ResultCache->insert(*CacheEntry,
+                            VisitedCallees ? *VisitedCallees : InlinedCallees);
+    }
   }
 }
 
@@ -723,17 +796,17 @@ void AnalysisConsumer::HandleCode(Decl *D, AnalysisMode Mode,
 // Path-sensitive checking.
 //===----------------------------------------------------------------------===//
 
-void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
+bool AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
                                               ExprEngine::InliningModes IMode,
                                               SetOfConstDecls *VisitedCallees) {
   // Construct the analysis engine.  First check if the CFG is valid.
   // FIXME: Inter-procedural analysis will need to handle invalid CFGs.
   if (!Mgr->getCFG(D))
-    return;
+    return false;
 
   // See if the LiveVariables analysis scales.
   if (!Mgr->getAnalysisDeclContext(D)->getAnalysis<RelaxedLiveVariables>())
-    return;
+    return false;
 
   ExprEngine Eng(CTU, *Mgr, VisitedCallees, &FunctionSummaries, IMode);
 
@@ -741,6 +814,10 @@ void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
   Eng.ExecuteWorkList(Mgr->getAnalysisDeclContextManager().getStackFrame(D),
                       Mgr->options.MaxNodesPerTopLevelFunction);
 
+  if (Opts->PrintStats)
+    for (const auto &I : Eng.getSymbolManager().getSymbolsCreatedBy())
+      SymbolsCreatedBy[I.first] += I.second;
+
   if (!Mgr->options.DumpExplodedGraphTo.empty())
     Eng.DumpGraph(Mgr->options.TrimGraph, Mgr->options.DumpExplodedGraphTo);
 
@@ -749,7 +826,13 @@ void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
     Eng.ViewGraph(Mgr->options.TrimGraph);
 
   // Display warnings.
-  Eng.getBugReporter().FlushReports();
+  BugReporter &BR = Eng.getBugReporter();
+  bool FoundBugs = BR.EQClasses_begin() != BR.EQClasses_end();
+  BR.FlushReports();
+
+  // The inlining limits depend on the functions analyzed before this one,
+  // which the cache key doesn't cover.
+  return !FoundBugs && !Eng.hasExceededInliningBudget();
 }
 
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,463 @@
+//===-- AnalysisResultCache.cpp ---------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "AnalysisResultCache.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Attr.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/ExprObjC.h"
+#include "clang/AST/ODRHash.h"
+#include "clang/AST/RecordLayout.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/Version.h"
+#include "clang/CrossTU/CrossTranslationUnit.h"
+#include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+using namespace ento;
+
+namespace {
+
+/// Profiles the code of a single function, and collects the functions it may
+/// call and the global variables it refers to on the way.
+///
+/// The ODR profile of a statement only records the names of the declarations
+/// it refers to. Everything about them that the analyzer may depend on is
+/// added separately: the types and attributes of the called functions, the
+/// values of enumerators, the initializers of globals and the layouts of the
+/// records.
+class FunctionProfiler : public RecursiveASTVisitor<FunctionProfiler> {
+  ASTContext &Ctx;
+  llvm::FoldingSetNodeID ID;
+  ODRHash Hash;
+  llvm::SmallPtrSet<const Decl *, 16> Seen;
+  llvm::SmallPtrSet<const Decl *, 16> Declarations;
+
+public:
+  SmallVector<const FunctionDecl *, 8> Callees;
+  bool HasDynamicCalls = false;
+
+  explicit FunctionProfiler(ASTContext &Ctx) : Ctx(Ctx) {}
+
+  void addString(StringRef S) { ID.AddString(S); }
+
+  void profile(const Stmt *S) {
+    S->ProcessODRHash(ID, Hash);
+    TraverseStmt(const_cast<Stmt *>(S));
+  }
+
+  void profile(const CXXCtorInitializer *Init) {
+    if (const FieldDecl *FD = Init->getAnyMember())
+      ID.AddString(FD->getName());
+    else if (Init->isBaseInitializer())
+      ID.AddString(QualType(Init->getBaseClass(), 0)
+                       .getCanonicalType()
+                       .getAsString());
+    profile(Init->getInit());
+  }
+
+  /// Adds the destructors of the bases and fields of \p RD, which are called
+  /// implicitly by the destructor of \p RD.
+  void addMemberDestructors(const CXXRecordDecl *RD) {
+    for (const CXXBaseSpecifier &Base : RD->bases())
+      addDestructor(Base.getType());
+    for (const FieldDecl *FD : RD->fields())
+      addDestructor(FD->getType());
+  }
+
+  void addAttributes(const Decl *D) {
+    for (const Attr *A : D->attrs()) {
+      ID.AddInteger(A->getKind());
+      SmallString<64> Buf;
+      llvm::raw_svector_ostream OS(Buf);
+      A->printPretty(OS, Ctx.getPrintingPolicy());
+      ID.AddString(OS.str());
+    }
+  }
+
+  /// Adds the type and the attributes of \p FD and its parameters, which
+  /// are used even if the body of \p FD is not available, e.g. 'noreturn'
+  /// or 'nonnull'.
+  void addDeclaration(const FunctionDecl *FD) {
+    // The most recent declaration has inherited the attributes of all the
+    // earlier ones.
+    FD = FD->getMostRecentDecl();
+    if (!Declarations.insert(FD).second)
+      return;
+    ID.AddString(FD->getType().getCanonicalType().getAsString());
+    addAttributes(FD);
+    for (const ParmVarDecl *P : FD->parameters())
+      addAttributes(P);
+  }
+
+  void addCallee(const FunctionDecl *FD, bool IsVirtualCall) {
+    addDeclaration(FD);
+    if (IsVirtualCall)
+      if (const auto *MD = dyn_cast<CXXMethodDecl>(FD))
+        if (MD->isVirtual())
+          HasDynamicCalls = true;
+
+    const FunctionDecl *Def;
+    if (FD->hasBody(Def) && Seen.insert(Def).second)
+      Callees.push_back(Def);
+  }
+
+  void addDestructor(QualType T) {
+    const auto *RD = Ctx.getBaseElementType(T)->getAsCXXRecordDecl();
+    if (RD && RD->hasDefinition())
+      if (const CXXDestructorDecl *DD = RD->getDestructor())
+        addCallee(DD, /*IsVirtualCall=*/false);
+  }
+
+  /// Adds \p T, and the layouts of the records it refers to directly or
+  /// through pointers and arrays, as seen e.g. by 'sizeof' and member
+  /// accesses.
+  void addType(QualType T) {
+    T = T.getCanonicalType();
+    ID.AddString(T.getAsString());
+
+    const Type *Ty = T.getTypePtr();
+    for (const Type *Next = Ty->getPointeeOrArrayElementType(); Next != Ty;
+         Next = Ty->getPointeeOrArrayElementType())
+      Ty = Next;
+    if (const auto *RT = Ty->getAs<RecordType>())
+      addRecordLayout(RT->getDecl());
+  }
+
+  void addRecordLayout(const RecordDecl *RD) {
+    RD = RD->getDefinition();
+    if (!RD || RD->isInvalidDecl() || RD->isDependentType() ||
+        !Seen.insert(RD).second)
+      return;
+
+    const ASTRecordLayout &Layout = Ctx.getASTRecordLayout(RD);
+    ID.AddInteger(Layout.getSize().getQuantity());
+    ID.AddInteger(Layout.getAlignment().getQuantity());
+    for (const FieldDecl *FD : RD->fields()) {
+      ID.AddString(FD->getName());
+      ID.AddInteger(Layout.getFieldOffset(FD->getFieldIndex()));
+      ID.AddString(FD->getType().getCanonicalType().getAsString());
+      // Records embedded by value are part of this layout. Those behind
+      // pointers are added once the code uses them.
+      if (const auto *RT = Ctx.getBaseElementType(FD->getType())
+                               ->getAs<RecordType>())
+        addRecordLayout(RT->getDecl());
+    }
+  }
+
+  void addGlobal(const VarDecl *VD) {
+    // The analyzer reads the initial values of constant globals.
+    if (!VD->hasGlobalStorage() || VD->isStaticLocal() ||
+        !Seen.insert(VD).second)
+      return;
+    if (const Expr *Init = VD->getAnyInitializer())
+      profile(Init);
+  }
+
+  std::string getHash() {
+    ID.AddInteger(Hash.CalculateHash());
+    llvm::BumpPtrAllocator Alloc;
+    llvm::FoldingSetNodeIDRef Data = ID.Intern(Alloc);
+
+    llvm::MD5 MD5;
+    MD5.update(makeArrayRef(reinterpret_cast<const uint8_t *>(Data.getData()),
+                            Data.getSize() * sizeof(unsigned)));
+    llvm::MD5::MD5Result Result;
+    MD5.final(Result);
+    return Result.digest().str();
+  }
+
+  bool VisitExpr(Expr *E) {
+    // The profile only covers the types written in the code. The types of the
+    // expressions also tell e.g. the size of an array behind a member.
+    addType(E->getType());
+    return true;
+  }
+
+  bool VisitUnaryExprOrTypeTraitExpr(UnaryExprOrTypeTraitExpr *E) {
+    if (E->isArgumentType())
+      addType(E->getArgumentType());
+    return true;
+  }
+
+  bool VisitDeclRefExpr(DeclRefExpr *E) {
+    if (const auto *FD = dyn_cast<FunctionDecl>(E->getDecl()))
+      addCallee(FD, /*IsVirtualCall=*/!E->hasQualifier());
+    else if (const auto *VD = dyn_cast<VarDecl>(E->getDecl()))
+      addGlobal(VD);
+    else if (const auto *ECD = dyn_cast<EnumConstantDecl>(E->getDecl()))
+      ID.AddString(ECD->getInitVal().toString(10));
+    return true;
+  }
+
+  bool VisitMemberExpr(MemberExpr *E) {
+    if (const auto *MD = dyn_cast<CXXMethodDecl>(E->getMemberDecl()))
+      addCallee(MD, /*IsVirtualCall=*/!E->hasQualifier());
+    else if (const auto *VD = dyn_cast<VarDecl>(E->getMemberDecl()))
+      addGlobal(VD);
+    return true;
+  }
+
+  bool VisitCXXConstructExpr(CXXConstructExpr *E) {
+    addCallee(E->getConstructor(), /*IsVirtualCall=*/false);
+    return true;
+  }
+
+  bool VisitCXXBindTemporaryExpr(CXXBindTemporaryExpr *E) {
+    if (const CXXDestructorDecl *DD = E->getTemporary()->getDestructor())
+      addCallee(DD, /*IsVirtualCall=*/false);
+    return true;
+  }
+
+  bool VisitCXXNewExpr(CXXNewExpr *E) {
+    if (const FunctionDecl *FD = E->getOperatorNew())
+      addCallee(FD, /*IsVirtualCall=*/false);
+    return true;
+  }
+
+  bool VisitCXXDeleteExpr(CXXDeleteExpr *E) {
+    if (const auto *RD = E->getDestroyedType()->getAsCXXRecordDecl())
+      if (RD->hasDefinition())
+        if (const CXXDestructorDecl *DD = RD->getDestructor())
+          addCallee(DD, /*IsVirtualCall=*/true);
+    if (const FunctionDecl *FD = E->getOperatorDelete())
+      addCallee(FD, /*IsVirtualCall=*/false);
+    return true;
+  }
+
+  bool VisitCXXDefaultArgExpr(CXXDefaultArgExpr *E) {
+    profile(E->getExpr());
+    return true;
+  }
+
+  bool VisitCXXDefaultInitExpr(CXXDefaultInitExpr *E) {
+    profile(E->getExpr());
+    return true;
+  }
+
+  bool VisitObjCMessageExpr(ObjCMessageExpr *E) {
+    HasDynamicCalls = true;
+    return true;
+  }
+
+  bool VisitVarDecl(VarDecl *VD) {
+    addType(VD->getType());
+    if (VD->hasLocalStorage())
+      addDestructor(VD->getType());
+    return true;
+  }
+};
+
+} // end anonymous namespace
+
+/// Writes \p Contents to \p Path through a temporary file, so that concurrent
+/// analyzer runs never observe a partially written entry.
+static void writeFileAtomically(StringRef Path, StringRef Contents) {
+  SmallString<256> TempPath(Path);
+  TempPath += "-%%%%%%%%";
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(TempPath, FD, TempPath))
+    return;
+
+  llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+  Out << Contents;
+  Out.close();
+  if (Out.has_error()) {
+    Out.clear_error();
+    llvm::sys::fs::remove(TempPath);
+    return;
+  }
+
+  if (llvm::sys::fs::rename(TempPath, Path))
+    llvm::sys::fs::remove(TempPath);
+}
+
+AnalysisResultCache::AnalysisResultCache(StringRef Dir,
+                                         const AnalyzerOptions &Opts,
+                                         ASTContext &Ctx)
+    : Dir(Dir), Ctx(Ctx) {
+  // Without a usable directory, every function is analyzed.
+  if (llvm::sys::fs::create_directories(Dir))
+    this->Dir.clear();
+
+  PruningPolicy.Expiration = std::chrono::hours(Opts.ResultCacheMaxAge);
+  PruningPolicy.MaxSizeFiles = Opts.ResultCacheMaxEntries;
+
+  llvm::MD5 Hash;
+  auto Add = [&Hash](StringRef S) {
+    Hash.update(S);
+    Hash.update(StringRef("\0", 1));
+  };
+
+  Add(getClangFullVersion());
+  Add(Ctx.getTargetInfo().getTriple().str());
+
+  const LangOptions &LangOpts = Ctx.getLangOpts();
+#define LANGOPT(Name, Bits, Default, Description)                              \
+  Add(llvm::utostr(LangOpts.Name));
+#define ENUM_LANGOPT(Name, Type, Bits, Default, Description)                   \
+  Add(llvm::utostr(static_cast<unsigned>(LangOpts.get##Name())));
+#define BENIGN_LANGOPT(Name, Bits, Default, Description)
+#define BENIGN_ENUM_LANGOPT(Name, Type, Bits, Default, Description)
+#include "clang/Basic/LangOptions.def"
+
+  for (const auto &Checker : Opts.CheckersControlList) {
+    Add(Checker.first);
+    Add(Checker.second ? "+" : "-");
+  }
+
+  // Sort the configuration, so that the hash doesn't depend on the order of
+  // the string map.
+  std::vector<std::pair<StringRef, StringRef>> Config;
+  for (const auto &Entry : Opts.Config)
+    if (!Entry.getKey().startswith("result-cache-"))
+      Config.emplace_back(Entry.getKey(), Entry.getValue());
+  llvm::sort(Config.begin(), Config.end());
+  for (const auto &Entry : Config) {
+    Add(Entry.first);
+    Add(Entry.second);
+  }
+
+  for (unsigned Value :
+       {unsigned(Opts.AnalysisStoreOpt), unsigned(Opts.AnalysisConstraintsOpt),
+        unsigned(Opts.AnalysisPurgeOpt), Opts.maxBlockVisitOnPath,
+        unsigned(Opts.eagerlyAssumeBinOpBifurcation),
+        unsigned(Opts.UnoptimizedCFG), unsigned(Opts.NoRetryExhausted),
+        Opts.InlineMaxStackDepth, unsigned(Opts.InliningMode)})
+    Add(llvm::utostr(Value));
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  ConfigHash = Result.digest().str();
+}
+
+const AnalysisResultCache::FunctionInfo &
+AnalysisResultCache::getFunctionInfo(const FunctionDecl *FD) {
+  std::unique_ptr<FunctionInfo> &Info = Functions[FD];
+  if (Info)
+    return *Info;
+  Info = llvm::make_unique<FunctionInfo>();
+  Info->LookupName = cross_tu::CrossTranslationUnitContext::getLookupName(FD);
+
+  FunctionProfiler Profiler(Ctx);
+  Profiler.addString(Info->LookupName);
+  Profiler.addDeclaration(FD);
+  if (const auto *CD = dyn_cast<CXXConstructorDecl>(FD))
+    for (const CXXCtorInitializer *Init : CD->inits())
+      Profiler.profile(Init);
+  if (const auto *DD = dyn_cast<CXXDestructorDecl>(FD))
+    Profiler.addMemberDestructors(DD->getParent());
+  if (const Stmt *Body = FD->getBody())
+    Profiler.profile(Body);
+
+  Info->Hash = Profiler.getHash();
+  Info->Callees = std::move(Profiler.Callees);
+  Info->HasDynamicCalls = Profiler.HasDynamicCalls;
+  return *Info;
+}
+
+Optional<AnalysisResultCache::Entry>
+AnalysisResultCache::getEntry(const Decl *D) {
+  // Objective-C methods and blocks are left out, as they mostly send messages
+  // whose receivers can't be known beforehand.
+  const auto *FD = dyn_cast<FunctionDecl>(D);
+  if (Dir.empty() || !FD)
+    return None;
+
+  llvm::MD5 Hash;
+  Hash.update(ConfigHash);
+
+  // Walk all the functions which may be inlined into FD, in a deterministic
+  // order.
+  Entry E;
+  SmallVector<const FunctionDecl *, 16> Worklist(1, FD);
+  llvm::SmallPtrSet<const FunctionDecl *, 16> Seen;
+  Seen.insert(FD);
+  while (!Worklist.empty()) {
+    const FunctionDecl *F = Worklist.pop_back_val();
+    const FunctionInfo &Info = getFunctionInfo(F);
+    if (Info.HasDynamicCalls)
+      return None;
+
+    Hash.update(Info.Hash);
+    if (F != FD)
+      E.Callees[Info.LookupName] = F;
+    for (const FunctionDecl *Callee : Info.Callees)
+      if (Seen.insert(Callee).second)
+        Worklist.push_back(Callee);
+  }
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  // The prefix lets pruneCache() know which files are entries.
+  SmallString<256> Path(Dir);
+  llvm::sys::path::append(Path, "llvmcache-" + Result.digest());
+  E.Path = Path.str();
+  return E;
+}
+
+bool AnalysisResultCache::lookup(const Entry &E,
+                                 SetOfConstDecls &InlinedCallees) const {
+  int FD;
+  if (llvm::sys::fs::openFileForRead(E.Path, FD))
+    return false;
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getOpenFile(FD, E.Path, /*FileSize=*/-1);
+  // Mark the entry as recently used, so that pruning by age keeps it.
+  if (Buffer)
+    llvm::sys::fs::setLastAccessAndModificationTime(
+        FD, std::chrono::system_clock::now());
+  llvm::sys::Process::SafelyCloseFileDescriptor(FD);
+  if (!Buffer)
+    return false;
+
+  SmallVector<StringRef, 16> Names;
+  (*Buffer)->getBuffer().split(Names, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  for (StringRef Name : Names) {
+    auto I = E.Callees.find(Name);
+    if (I != E.Callees.end())
+      InlinedCallees.insert(I->second);
+  }
+  return true;
+}
+
+void AnalysisResultCache::insert(const Entry &E,
+                                 const SetOfConstDecls &InlinedCallees) const {
+  std::vector<std::string> Names;
+  for (const Decl *D : InlinedCallees)
+    if (const auto *ND = dyn_cast<NamedDecl>(D))
+      Names.push_back(cross_tu::CrossTranslationUnitContext::getLookupName(ND));
+  llvm::sort(Names.begin(), Names.end());
+
+  std::string Contents;
+  for (const std::string &Name : Names)
+    Contents += Name + '\n';
+  writeFileAtomically(E.Path, Contents);
+}
+
+void AnalysisResultCache::prune() const {
+  if (!Dir.empty())
+    llvm::pruneCache(Dir, PruningPolicy);
+}
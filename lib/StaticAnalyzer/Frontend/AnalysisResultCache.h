@@ -0,0 +1,124 @@
+//===-- AnalysisResultCache.h -----------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file defines the clang::ento::AnalysisResultCache class, which
+/// remembers across analyzer runs the top-level functions whose path-sensitive
+/// analysis produced no reports.
+///
+/// A function is identified by a hash of its body and of the bodies of all
+/// the functions the analyzer may inline into it, computed with the same
+/// profiling that is used to check the ODR across modules, together with the
+/// analyzer configuration. As long as none of them changes, the function is
+/// not analyzed again. Functions with reports are always analyzed again, so
+/// that their reports are emitted exactly as before.
+///
+/// The hash does not cover the state shared between the top-level functions
+/// of a translation unit. The inlining heuristics of FunctionSummaries stop
+/// inlining functions that turned out to be large or that were inlined too
+/// often, so the result of a function may depend on the functions analyzed
+/// before it. Functions in which a call wasn't inlined because of such a
+/// limit are therefore never recorded.
+///
+/// The entries are removed once they were not used for some time, or when
+/// there are too many of them, as set by the 'result-cache-max-age' and
+/// 'result-cache-max-entries' options.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SA_FRONTEND_ANALYSISRESULTCACHE_H
+#define LLVM_CLANG_SA_FRONTEND_ANALYSISRESULTCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/FunctionSummary.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CachePruning.h"
+#include <memory>
+#include <string>
+
+namespace clang {
+
+class AnalyzerOptions;
+class ASTContext;
+class Decl;
+class FunctionDecl;
+
+namespace ento {
+
+class AnalysisResultCache {
+public:
+  /// The cache entry of a top-level function.
+  struct Entry {
+    /// The path of the entry in the cache directory.
+    std::string Path;
+
+    /// The functions that may be inlined into the top-level function, by
+    /// their lookup name.
+    llvm::StringMap<const Decl *> Callees;
+  };
+
+  AnalysisResultCache(StringRef Dir, const AnalyzerOptions &Opts,
+                      ASTContext &Ctx);
+
+  /// Returns the entry of \p D, or None if the results of \p D can't be
+  /// cached, e.g. because the analyzer may inline a function into it which
+  /// isn't known without running the analysis.
+  Optional<Entry> getEntry(const Decl *D);
+
+  /// Returns true if an earlier run recorded that the function of \p E
+  /// produced no reports. The functions that run inlined are added to
+  /// \p InlinedCallees.
+  bool lookup(const Entry &E, SetOfConstDecls &InlinedCallees) const;
+
+  /// Records that the function of \p E produced no reports, and inlined
+  /// \p InlinedCallees.
+  void insert(const Entry &E, const SetOfConstDecls &InlinedCallees) const;
+
+  /// Removes the entries that the pruning policy considers stale.
+  void prune() const;
+
+private:
+  /// What is known about a single function, independently of its callers.
+  struct FunctionInfo {
+    /// The hash of the signature and the body of the function and of the
+    /// initializers of the global variables it refers to.
+    std::string Hash;
+
+    /// The lookup name of the function.
+    std::string LookupName;
+
+    /// The functions with a body which may be called by the function.
+    SmallVector<const FunctionDecl *, 8> Callees;
+
+    /// Whether the analyzer may inline a function into this one which isn't
+    /// known statically, as for virtual calls and Objective-C messages.
+    bool HasDynamicCalls = false;
+  };
+
+  const FunctionInfo &getFunctionInfo(const FunctionDecl *FD);
+
+  std::string Dir;
+  ASTContext &Ctx;
+  llvm::CachePruningPolicy PruningPolicy;
+
+  /// The hash of the analyzer configuration, which affects the results of
+  /// every function.
+  std::string ConfigHash;
+
+  llvm::DenseMap<const FunctionDecl *, std::unique_ptr<FunctionInfo>>
+      Functions;
+};
+
+} // end namespace ento
+} // end namespace clang
+
+#endif
@@ -15,10 +15,13 @@
 
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/Lex/Lexer.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/PriorityQueue.h"
 
 #include <limits>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace llvm;
@@ -80,6 +83,16 @@ private:
   // Returns true if the two subtrees are identical.
   bool identical(NodeId Id1, NodeId Id2) const;
 
+  // Computes the hashes of all subtrees of a tree from their node kinds,
+  // values and the hashes of their children.
+  static std::vector<size_t> computeSubtreeHashes(const SyntaxTree::Impl &Tree);
+
+  // Maps the identical subtrees among the nodes H1 and H2, which have the same
+  // height. Each node in H1 is mapped to the first unmapped identical node in
+  // H2.
+  void matchIdenticalSubtrees(Mapping &M, ArrayRef<NodeId> H1,
+                              ArrayRef<NodeId> H2) const;
+
   // Returns false if the nodes must not be mached.
   bool isMatchingPossible(NodeId Id1, NodeId Id2) const;
 
@@ -105,6 +118,9 @@ private:
 
   const ComparisonOptions &Options;
 
+  // The subtree hashes of both trees, if Options.UseSubtreeHashes is set.
+  std::vector<size_t> Hashes1, Hashes2;
+
   friend class ZhangShashaMatcher;
 };
 
@@ -769,6 +785,59 @@ bool ASTDiff::Impl::identical(NodeId Id1, NodeId Id2) const {
   return true;
 }
 
+std::vector<size_t>
+ASTDiff::Impl::computeSubtreeHashes(const SyntaxTree::Impl &Tree) {
+  std::vector<size_t> Hashes(Tree.getSize());
+  // Children have greater preorder ids than their parents.
+  SmallVector<size_t, 8> ChildHashes;
+  for (int Id = Tree.getSize() - 1; Id >= 0; --Id) {
+    const Node &N = Tree.getNode(Id);
+    ChildHashes.clear();
+    for (NodeId Child : N.Children)
+      ChildHashes.push_back(Hashes[Child]);
+    Hashes[Id] = hash_combine(
+        N.getTypeLabel(), Tree.getNodeValue(N),
+        hash_combine_range(ChildHashes.begin(), ChildHashes.end()));
+  }
+  return Hashes;
+}
+
+void ASTDiff::Impl::matchIdenticalSubtrees(Mapping &M, ArrayRef<NodeId> H1,
+                                           ArrayRef<NodeId> H2) const {
+  auto LinkSubtrees = [&](NodeId Id1, NodeId Id2) {
+    for (int I = 0, E = T1.getNumberOfDescendants(Id1); I < E; ++I)
+      M.link(Id1 + I, Id2 + I);
+  };
+
+  if (!Options.UseSubtreeHashes) {
+    for (NodeId Id1 : H1)
+      for (NodeId Id2 : H2)
+        if (identical(Id1, Id2) && !M.hasSrc(Id1) && !M.hasDst(Id2))
+          LinkSubtrees(Id1, Id2);
+    return;
+  }
+
+  // H2 is sorted, so each bucket lists its nodes in the order in which they
+  // would be tried by the pairwise comparison above.
+  std::unordered_map<size_t, SmallVector<NodeId, 2>> Buckets;
+  for (NodeId Id2 : H2)
+    Buckets[Hashes2[Id2]].push_back(Id2);
+  for (NodeId Id1 : H1) {
+    if (M.hasSrc(Id1))
+      continue;
+    auto It = Buckets.find(Hashes1[Id1]);
+    if (It == Buckets.end())
+      continue;
+    // Different subtrees may still share a hash.
+    for (NodeId Id2 : It->second) {
+      if (!M.hasDst(Id2) && identical(Id1, Id2)) {
+        LinkSubtrees(Id1, Id2);
+        break;
+      }
+    }
+  }
+}
+
 bool ASTDiff::Impl::isMatchingPossible(NodeId Id1, NodeId Id2) const {
   return Options.isMatchingAllowed(T1.getNode(Id1), T2.getNode(Id2));
 }
@@ -783,8 +852,12 @@ bool ASTDiff::Impl::haveSameParents(const Mapping &M, NodeId Id1,
 
 void ASTDiff::Impl::addOptimalMapping(Mapping &M, NodeId Id1,
                                       NodeId Id2) const {
-  if (std::max(T1.getNumberOfDescendants(Id1), T2.getNumberOfDescendants(Id2)) >
-      Options.MaxSize)
+  int Size1 = T1.getNumberOfDescendants(Id1);
+  int Size2 = T2.getNumberOfDescendants(Id2);
+  if (std::max(Size1, Size2) > Options.MaxSize)
+    return;
+  if (Options.MaxMatrixSize > 0 &&
+      int64_t(Size1) * int64_t(Size2) > Options.MaxMatrixSize)
     return;
   ZhangShashaMatcher Matcher(*this, T1, T2, Id1, Id2);
   std::vector<std::pair<NodeId, NodeId>> R = Matcher.getMatchingNodes();
@@ -816,9 +889,25 @@ double ASTDiff::Impl::getJaccardSimilarity(const Mapping &M, NodeId Id1,
 }
 
 NodeId ASTDiff::Impl::findCandidate(const Mapping &M, NodeId Id1) const {
+  // Only the nodes containing a node that is mapped to a descendant of Id1
+  // have a positive similarity, so there is no need to look at all of T2.
+  std::vector<NodeId> Candidates;
+  llvm::DenseSet<int> Visited;
+  const Node &N1 = T1.getNode(Id1);
+  for (NodeId Src = Id1 + 1; Src <= N1.RightMostDescendant; ++Src) {
+    for (NodeId Dst = M.getDst(Src); Dst.isValid();
+         Dst = T2.getNode(Dst).Parent) {
+      if (!Visited.insert(Dst).second)
+        break;
+      Candidates.push_back(Dst);
+    }
+  }
+  // Visit the candidates in preorder to break ties as before.
+  llvm::sort(Candidates);
+
   NodeId Candidate;
   double HighestSimilarity = 0.0;
-  for (NodeId Id2 : T2) {
+  for (NodeId Id2 : Candidates) {
     if (!isMatchingPossible(Id1, Id2))
       continue;
     if (M.hasDst(Id2))
@@ -882,14 +971,7 @@ Mapping ASTDiff::Impl::matchTopDown() const {
     std::vector<NodeId> H1, H2;
     H1 = L1.pop();
     H2 = L2.pop();
-    for (NodeId Id1 : H1) {
-      for (NodeId Id2 : H2) {
-        if (identical(Id1, Id2) && !M.hasSrc(Id1) && !M.hasDst(Id2)) {
-          for (int I = 0, E = T1.getNumberOfDescendants(Id1); I < E; ++I)
-            M.link(Id1 + I, Id2 + I);
-        }
-      }
-    }
+    matchIdenticalSubtrees(M, H1, H2);
     for (NodeId Id1 : H1) {
       if (!M.hasSrc(Id1))
         L1.open(Id1);
@@ -910,6 +992,10 @@ ASTDiff::Impl::Impl(SyntaxTree::Impl &T1, SyntaxTree::Impl &T2,
 }
 
 void ASTDiff::Impl::computeMapping() {
+  if (Options.UseSubtreeHashes) {
+    Hashes1 = computeSubtreeHashes(T1);
+    Hashes2 = computeSubtreeHashes(T2);
+  }
   TheMapping = matchTopDown();
   if (Options.StopAfterTopDown)
     return;
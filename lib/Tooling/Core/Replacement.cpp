@@ -23,6 +23,7 @@
 #include "clang/Rewrite/Core/RewriteBuffer.h"
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Error.h"
@@ -342,6 +343,34 @@ llvm::Error Replacements::add(const Replacement &R) {
   return llvm::Error::success();
 }
 
+llvm::Error Replacements::addAll(ArrayRef<Replacement> Rs) {
+  std::vector<Replacement> Sorted(Rs.begin(), Rs.end());
+  llvm::sort(Sorted);
+
+  for (const Replacement &R : Sorted) {
+    // Replacements that start at or after the end of the last existing
+    // replacement can be appended without looking at any other replacement,
+    // since the existing replacements do not overlap. The exceptions are a
+    // second insertion at the same offset, which may conflict, and header
+    // insertions, which are always added by add().
+    if (!Replaces.empty()) {
+      const Replacement &Last = *Replaces.rbegin();
+      unsigned LastEnd = Last.getOffset() + Last.getLength();
+      if (R.getFilePath() != Last.getFilePath() ||
+          Last.getOffset() == std::numeric_limits<unsigned>::max() ||
+          R.getOffset() < LastEnd ||
+          (R.getOffset() == Last.getOffset() && R.getLength() == 0) ||
+          !(Last < R)) {
+        if (llvm::Error Err = add(R))
+          return Err;
+        continue;
+      }
+    }
+    Replaces.insert(Replaces.end(), R);
+  }
+  return llvm::Error::success();
+}
+
 namespace {
 
 // Represents a merged replacement, i.e. a replacement consisting of multiple
@@ -474,9 +503,10 @@ Replacements Replacements::merge(const Replacements &ReplacesToMerge) const {
       ++I;
     }
     Delta -= Merged.deltaFirst();
-    Result.insert(Merged.asReplacement());
+    // Merged replacements are produced in order of increasing offsets.
+    Result.insert(Result.end(), Merged.asReplacement());
   }
-  return Replacements(Result.begin(), Result.end());
+  return Replacements(std::move(Result));
 }
 
 // Combines overlapping ranges in \p Ranges and sorts the combined ranges.
@@ -567,44 +597,55 @@ namespace clang {
 namespace tooling {
 
 bool applyAllReplacements(const Replacements &Replaces, Rewriter &Rewrite) {
+  // All replacements of a set refer to the same file, so they can be applied
+  // to its rewrite buffer in a single batch.
   bool Result = true;
-  for (auto I = Replaces.rbegin(), E = Replaces.rend(); I != E; ++I) {
-    if (I->isApplicable()) {
-      Result = I->apply(Rewrite) && Result;
-    } else {
+  RewriteBuffer *Buffer = nullptr;
+  SmallVector<RewriteBuffer::Edit, 64> Edits;
+  for (const Replacement &R : Replaces) {
+    if (!R.isApplicable()) {
       Result = false;
+      continue;
     }
+    if (!Buffer) {
+      SourceManager &SM = Rewrite.getSourceMgr();
+      const FileEntry *Entry = SM.getFileManager().getFile(R.getFilePath());
+      if (!Entry)
+        return false;
+      Buffer = &Rewrite.getEditBuffer(
+          SM.getOrCreateFileID(Entry, SrcMgr::C_User));
+    }
+    Edits.push_back(RewriteBuffer::Edit{R.getOffset(), R.getLength(),
+                                        R.getReplacementText()});
   }
+  if (Buffer)
+    Buffer->ApplyEdits(Edits);
   return Result;
 }
 
+llvm::Error applyAllReplacements(StringRef Code, const Replacements &Replaces,
+                                 raw_ostream &OS) {
+  unsigned Pos = 0;
+  for (const Replacement &R : Replaces) {
+    if (R.getOffset() < Pos || R.getOffset() + R.getLength() > Code.size())
+      return llvm::make_error<ReplacementError>(
+          replacement_error::fail_to_apply, R);
+    OS << Code.slice(Pos, R.getOffset()) << R.getReplacementText();
+    Pos = R.getOffset() + R.getLength();
+  }
+  OS << Code.substr(Pos);
+  return llvm::Error::success();
+}
+
 llvm::Expected<std::string> applyAllReplacements(StringRef Code,
                                                 const Replacements &Replaces) {
   if (Replaces.empty())
     return Code.str();
 
-  IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> InMemoryFileSystem(
-      new llvm::vfs::InMemoryFileSystem);
-  FileManager Files(FileSystemOptions(), InMemoryFileSystem);
-  DiagnosticsEngine Diagnostics(
-      IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs),
-      new DiagnosticOptions);
-  SourceManager SourceMgr(Diagnostics, Files);
-  Rewriter Rewrite(SourceMgr, LangOptions());
-  InMemoryFileSystem->addFile(
-      "<stdin>", 0, llvm::MemoryBuffer::getMemBuffer(Code, "<stdin>"));
-  FileID ID = SourceMgr.createFileID(Files.getFile("<stdin>"), SourceLocation(),
-                                     clang::SrcMgr::C_User);
-  for (auto I = Replaces.rbegin(), E = Replaces.rend(); I != E; ++I) {
-    Replacement Replace("<stdin>", I->getOffset(), I->getLength(),
-                        I->getReplacementText());
-    if (!Replace.apply(Rewrite))
-      return llvm::make_error<ReplacementError>(
-          replacement_error::fail_to_apply, Replace);
-  }
   std::string Result;
   llvm::raw_string_ostream OS(Result);
-  Rewrite.getEditBuffer(ID).write(OS);
+  if (llvm::Error Err = applyAllReplacements(Code, Replaces, OS))
+    return std::move(Err);
   OS.flush();
   return Result;
 }
@@ -15,26 +15,30 @@
 #include "clang/Basic/LLVM.h"
 #include "clang/Tooling/CompilationDatabase.h"
 #include "clang/Tooling/CompilationDatabasePluginRegistry.h"
-#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ConvertUTF.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/StringSaver.h"
 #include "llvm/Support/YAMLParser.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <cassert>
 #include <memory>
 #include <string>
 #include <system_error>
-#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -157,15 +161,200 @@ std::vector<std::string> unescapeCommandLine(JSONCommandLineSyntax Syntax,
   return parser.parse();
 }
 
+/// A scanner for the JSON text of a compilation database.
+///
+/// It checks the structure of the values and returns their raw text without
+/// decoding or copying them. Like the YAML parser that was used before, it
+/// accepts '#' comments between tokens.
+class JSONScanner {
+public:
+  explicit JSONScanner(StringRef Input) : Input(Input) {}
+
+  /// Consumes the next token if it is the character \p C.
+  bool consume(char C) {
+    skipWhitespace();
+    if (Position == Input.size() || Input[Position] != C)
+      return false;
+    ++Position;
+    return true;
+  }
+
+  bool atEnd() {
+    skipWhitespace();
+    return Position == Input.size();
+  }
+
+  /// Scans a string and returns its raw text including the quotes.
+  bool scanString(StringRef &Token) {
+    skipWhitespace();
+    if (Position == Input.size() || Input[Position] != '"')
+      return false;
+    size_t Begin = Position++;
+    while (Position < Input.size()) {
+      char C = Input[Position++];
+      if (C == '"') {
+        Token = Input.slice(Begin, Position);
+        return true;
+      }
+      if (C == '\\')
+        ++Position;
+    }
+    return false;
+  }
+
+  /// Scans an array of strings and returns its raw text including the
+  /// brackets.
+  bool scanStringArray(StringRef &Token) {
+    skipWhitespace();
+    size_t Begin = Position;
+    if (!consume('['))
+      return false;
+    StringRef Element;
+    if (!consume(']')) {
+      do {
+        if (!scanString(Element))
+          return false;
+      } while (consume(','));
+      if (!consume(']'))
+        return false;
+    }
+    Token = Input.slice(Begin, Position);
+    return true;
+  }
+
+  /// Returns true if the next token starts an array.
+  bool atArray() {
+    skipWhitespace();
+    return Position < Input.size() && Input[Position] == '[';
+  }
+
+private:
+  void skipWhitespace() {
+    while (Position < Input.size()) {
+      char C = Input[Position];
+      if (C == '#') {
+        Position = Input.find('\n', Position);
+        if (Position == StringRef::npos)
+          Position = Input.size();
+      } else if (C == ' ' || C == '\t' || C == '\n' || C == '\r') {
+        ++Position;
+      } else {
+        break;
+      }
+    }
+  }
+
+  StringRef Input;
+  size_t Position = 0;
+};
+
+/// Decodes the escape sequences of the raw JSON string \p Token, which
+/// includes the quotes.
+///
+/// Returns a reference into \p Token if the string has no escape sequences,
+/// and into \p Storage otherwise.
+StringRef decodeString(StringRef Token, SmallVectorImpl<char> &Storage) {
+  if (Token.size() < 2)
+    return StringRef();
+  StringRef Value = Token.drop_front().drop_back();
+  if (Value.find('\\') == StringRef::npos)
+    return Value;
+
+  Storage.clear();
+  for (size_t I = 0, E = Value.size(); I != E; ++I) {
+    if (Value[I] != '\\' || I + 1 == E) {
+      Storage.push_back(Value[I]);
+      continue;
+    }
+    switch (char C = Value[++I]) {
+    case 'b': Storage.push_back('\b'); break;
+    case 'f': Storage.push_back('\f'); break;
+    case 'n': Storage.push_back('\n'); break;
+    case 'r': Storage.push_back('\r'); break;
+    case 't': Storage.push_back('\t'); break;
+    case 'u': {
+      unsigned CodePoint;
+      if (I + 4 >= E || Value.substr(I + 1, 4).getAsInteger(16, CodePoint)) {
+        Storage.push_back(C);
+        break;
+      }
+      I += 4;
+      // Combine UTF-16 surrogate pairs.
+      unsigned Low;
+      if (CodePoint >= 0xD800 && CodePoint < 0xDC00 && I + 6 < E &&
+          Value.substr(I + 1, 2) == "\\u" &&
+          !Value.substr(I + 3, 4).getAsInteger(16, Low) && Low >= 0xDC00 &&
+          Low < 0xE000) {
+        CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+        I += 6;
+      }
+      char Buffer[UNI_MAX_UTF8_BYTES_PER_CODE_POINT];
+      char *End = Buffer;
+      if (llvm::ConvertCodePointToUTF8(CodePoint, End))
+        Storage.append(Buffer, End);
+      break;
+    }
+    default:
+      // '"', '\\' and '/' stand for themselves.
+      Storage.push_back(C);
+      break;
+    }
+  }
+  return StringRef(Storage.data(), Storage.size());
+}
+
+/// Encodes \p Value as a raw JSON string, including the quotes, that
+/// decodeString() turns back into \p Value.
+StringRef encodeString(StringRef Value, llvm::StringSaver &Saver) {
+  std::string Token = "\"";
+  for (char C : Value) {
+    if (C == '"' || C == '\\') {
+      Token += '\\';
+      Token += C;
+    } else if (static_cast<unsigned char>(C) < 0x20) {
+      Token += "\\u00";
+      Token += llvm::hexdigit(static_cast<unsigned char>(C) >> 4);
+      Token += llvm::hexdigit(C & 0xF);
+    } else {
+      Token += C;
+    }
+  }
+  Token += '"';
+  return Saver.save(Token);
+}
+
+/// Returns the native absolute path of the file \p FileName of a compile
+/// command run in \p Directory.
+void getNativeFilePath(StringRef Directory, StringRef FileName,
+                       SmallVectorImpl<char> &NativeFilePath) {
+  if (llvm::sys::path::is_relative(FileName)) {
+    SmallString<128> AbsolutePath(Directory);
+    llvm::sys::path::append(AbsolutePath, FileName);
+    llvm::sys::path::native(AbsolutePath, NativeFilePath);
+  } else {
+    llvm::sys::path::native(FileName, NativeFilePath);
+  }
+}
+
 // This plugin locates a nearby compile_command.json file, and also infers
 // compile commands for files not present in the database.
 class JSONCompilationDatabasePlugin : public CompilationDatabasePlugin {
+  /// Databases of at least this size are indexed, so that later tools don't
+  /// have to parse them again.
+  static const uint64_t MinIndexedDatabaseSize = 16 * 1024 * 1024;
+
   std::unique_ptr<CompilationDatabase>
   loadFromDirectory(StringRef Directory, std::string &ErrorMessage) override {
     SmallString<1024> JSONDatabasePath(Directory);
     llvm::sys::path::append(JSONDatabasePath, "compile_commands.json");
+    SmallString<1024> IndexPath;
+    uint64_t Size;
+    if (!llvm::sys::fs::file_size(JSONDatabasePath, Size) &&
+        Size >= MinIndexedDatabaseSize)
+      IndexPath = (JSONDatabasePath + ".index").str();
     auto Base = JSONCompilationDatabase::loadFromFile(
-        JSONDatabasePath, ErrorMessage, JSONCommandLineSyntax::AutoDetect);
+        JSONDatabasePath, ErrorMessage, JSONCommandLineSyntax::AutoDetect,
+        IndexPath);
     return Base ? inferMissingCompileCommands(std::move(Base)) : nullptr;
   }
 };
@@ -190,17 +379,26 @@ volatile int JSONAnchorSource = 0;
 std::unique_ptr<JSONCompilationDatabase>
 JSONCompilationDatabase::loadFromFile(StringRef FilePath,
                                       std::string &ErrorMessage,
-                                      JSONCommandLineSyntax Syntax) {
+                                      JSONCommandLineSyntax Syntax,
+                                      StringRef IndexPath) {
+  // The database isn't null-terminated so that it can always be mapped.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> DatabaseBuffer =
-      llvm::MemoryBuffer::getFile(FilePath);
+      llvm::MemoryBuffer::getFile(FilePath, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
   if (std::error_code Result = DatabaseBuffer.getError()) {
     ErrorMessage = "Error while opening JSON database: " + Result.message();
     return nullptr;
   }
   std::unique_ptr<JSONCompilationDatabase> Database(
       new JSONCompilationDatabase(std::move(*DatabaseBuffer), Syntax));
+
+  if (!IndexPath.empty() && Database->readIndex(IndexPath))
+    return Database;
+
   if (!Database->parse(ErrorMessage))
     return nullptr;
+  if (!IndexPath.empty() && !Database->ParsedAsYAML)
+    Database->writeIndex(IndexPath);
   return Database;
 }
 
@@ -231,7 +429,8 @@ JSONCompilationDatabase::getCompileCommands(StringRef FilePath) const {
   if (CommandsRefI == IndexByFile.end())
     return {};
   std::vector<CompileCommand> Commands;
-  getCommands(CommandsRefI->getValue(), Commands);
+  for (unsigned Index : CommandsRefI->getValue())
+    Commands.push_back(getCommand(AllCommands[Index]));
   return Commands;
 }
 
@@ -246,39 +445,174 @@ JSONCompilationDatabase::getAllFiles() const {
 std::vector<CompileCommand>
 JSONCompilationDatabase::getAllCompileCommands() const {
   std::vector<CompileCommand> Commands;
-  getCommands(AllCommands, Commands);
+  Commands.reserve(AllCommands.size());
+  for (const CompileCommandRef &CommandRef : AllCommands)
+    Commands.push_back(getCommand(CommandRef));
   return Commands;
 }
 
 static std::vector<std::string>
-nodeToCommandLine(JSONCommandLineSyntax Syntax,
-                  const std::vector<llvm::yaml::ScalarNode *> &Nodes) {
+tokenizeCommandLine(JSONCommandLineSyntax Syntax, StringRef Command,
+                    StringRef Arguments) {
   SmallString<1024> Storage;
-  if (Nodes.size() == 1)
-    return unescapeCommandLine(Syntax, Nodes[0]->getValue(Storage));
-  std::vector<std::string> Arguments;
-  for (const auto *Node : Nodes)
-    Arguments.push_back(Node->getValue(Storage));
-  return Arguments;
-}
+  if (Arguments.empty())
+    return unescapeCommandLine(Syntax, decodeString(Command, Storage));
 
-void JSONCompilationDatabase::getCommands(
-    ArrayRef<CompileCommandRef> CommandsRef,
-    std::vector<CompileCommand> &Commands) const {
-  for (const auto &CommandRef : CommandsRef) {
-    SmallString<8> DirectoryStorage;
-    SmallString<32> FilenameStorage;
-    SmallString<32> OutputStorage;
-    auto Output = std::get<3>(CommandRef);
-    Commands.emplace_back(
-        std::get<0>(CommandRef)->getValue(DirectoryStorage),
-        std::get<1>(CommandRef)->getValue(FilenameStorage),
-        nodeToCommandLine(Syntax, std::get<2>(CommandRef)),
-        Output ? Output->getValue(OutputStorage) : "");
+  // The arguments were checked when the database was parsed.
+  std::vector<std::string> Result;
+  JSONScanner Scanner(Arguments);
+  StringRef Argument;
+  if (Scanner.consume('[') && !Scanner.consume(']')) {
+    do {
+      if (!Scanner.scanString(Argument))
+        break;
+      Result.push_back(decodeString(Argument, Storage).str());
+    } while (Scanner.consume(','));
   }
+  // A single argument is a shell-escaped command line, like 'command'.
+  if (Result.size() == 1)
+    return unescapeCommandLine(Syntax, Result[0]);
+  return Result;
+}
+
+CompileCommand
+JSONCompilationDatabase::getCommand(const CompileCommandRef &CommandRef) const {
+  SmallString<128> DirectoryStorage;
+  SmallString<128> FilenameStorage;
+  SmallString<128> OutputStorage;
+  return CompileCommand(
+      decodeString(CommandRef.Directory, DirectoryStorage),
+      decodeString(CommandRef.Filename, FilenameStorage),
+      tokenizeCommandLine(Syntax, CommandRef.Command, CommandRef.Arguments),
+      decodeString(CommandRef.Output, OutputStorage));
+}
+
+void JSONCompilationDatabase::addCommand(const CompileCommandRef &Command,
+                                         StringRef NativeFilePath) {
+  auto &Entry = *IndexByFile.try_emplace(NativeFilePath).first;
+  Entry.second.push_back(AllCommands.size());
+  AllCommands.push_back(Command);
+  CommandFiles.push_back(Entry.first());
+  MatchTrie.insert(NativeFilePath);
 }
 
 bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
+  if (parseJSON(ErrorMessage))
+    return true;
+  // Databases used to be read with the YAML parser, which accepts more than
+  // JSON, and reports its own errors.
+  return parseYAML(ErrorMessage);
+}
+
+bool JSONCompilationDatabase::parseJSON(std::string &ErrorMessage) {
+  // The commands are only added once the whole database was scanned, so that
+  // a failed scan leaves nothing behind for the YAML parser.
+  std::vector<CompileCommandRef> Commands;
+  JSONScanner Scanner(Database->getBuffer());
+  if (Scanner.atEnd()) {
+    ErrorMessage = "Error while parsing JSON.";
+    return false;
+  }
+  if (!Scanner.consume('[')) {
+    ErrorMessage = "Expected array.";
+    return false;
+  }
+  bool HasMoreObjects = !Scanner.consume(']');
+  while (HasMoreObjects) {
+    if (!Scanner.consume('{')) {
+      ErrorMessage = "Expected object.";
+      return false;
+    }
+    CompileCommandRef Command;
+    bool HasMoreKeys = !Scanner.consume('}');
+    while (HasMoreKeys) {
+      StringRef KeyToken;
+      if (!Scanner.scanString(KeyToken)) {
+        ErrorMessage = "Expected strings as key.";
+        return false;
+      }
+      if (!Scanner.consume(':')) {
+        ErrorMessage = "Expected value.";
+        return false;
+      }
+      SmallString<16> KeyStorage;
+      StringRef KeyValue = decodeString(KeyToken, KeyStorage);
+      StringRef Value;
+      if (KeyValue == "arguments") {
+        if (!Scanner.atArray()) {
+          ErrorMessage = "Expected sequence as value.";
+          return false;
+        }
+        if (!Scanner.scanStringArray(Value)) {
+          ErrorMessage = "Only strings are allowed in 'arguments'.";
+          return false;
+        }
+      } else if (!Scanner.scanString(Value)) {
+        ErrorMessage = "Expected string as value.";
+        return false;
+      }
+
+      if (KeyValue == "directory") {
+        Command.Directory = Value;
+      } else if (KeyValue == "arguments") {
+        Command.Arguments = Value;
+      } else if (KeyValue == "command") {
+        Command.Command = Value;
+      } else if (KeyValue == "file") {
+        Command.Filename = Value;
+      } else if (KeyValue == "output") {
+        Command.Output = Value;
+      } else {
+        ErrorMessage = ("Unknown key: \"" + KeyValue + "\"").str();
+        return false;
+      }
+
+      HasMoreKeys = Scanner.consume(',');
+      if (!HasMoreKeys && !Scanner.consume('}')) {
+        ErrorMessage = "Expected ',' or '}'.";
+        return false;
+      }
+    }
+    if (Command.Filename.empty()) {
+      ErrorMessage = "Missing key: \"file\".";
+      return false;
+    }
+    if (Command.Command.empty() && Command.Arguments.empty()) {
+      ErrorMessage = "Missing key: \"command\" or \"arguments\".";
+      return false;
+    }
+    if (Command.Directory.empty()) {
+      ErrorMessage = "Missing key: \"directory\".";
+      return false;
+    }
+    Commands.push_back(Command);
+
+    HasMoreObjects = Scanner.consume(',');
+    if (!HasMoreObjects && !Scanner.consume(']')) {
+      ErrorMessage = "Expected ',' or ']'.";
+      return false;
+    }
+  }
+  if (!Scanner.atEnd()) {
+    ErrorMessage = "Expected end of database.";
+    return false;
+  }
+
+  AllCommands.reserve(Commands.size());
+  CommandFiles.reserve(Commands.size());
+  for (const CompileCommandRef &Command : Commands) {
+    SmallString<128> DirectoryStorage, FileStorage, NativeFilePath;
+    getNativeFilePath(decodeString(Command.Directory, DirectoryStorage),
+                      decodeString(Command.Filename, FileStorage),
+                      NativeFilePath);
+    addCommand(Command, NativeFilePath);
+  }
+  return true;
+}
+
+bool JSONCompilationDatabase::parseYAML(std::string &ErrorMessage) {
+  llvm::SourceMgr SM;
+  llvm::yaml::Stream YAMLStream(Database->getBuffer(), SM);
   llvm::yaml::document_iterator I = YAMLStream.begin();
   if (I == YAMLStream.end()) {
     ErrorMessage = "Error while parsing YAML.";
@@ -294,17 +628,18 @@ bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
     ErrorMessage = "Expected array.";
     return false;
   }
+
+  llvm::StringSaver Saver(YAMLValues);
+  std::vector<std::pair<CompileCommandRef, std::string>> Commands;
   for (auto &NextObject : *Array) {
     auto *Object = dyn_cast<llvm::yaml::MappingNode>(&NextObject);
     if (!Object) {
       ErrorMessage = "Expected object.";
       return false;
     }
-    llvm::yaml::ScalarNode *Directory = nullptr;
-    llvm::Optional<std::vector<llvm::yaml::ScalarNode *>> Command;
-    llvm::yaml::ScalarNode *File = nullptr;
-    llvm::yaml::ScalarNode *Output = nullptr;
-    for (auto& NextKeyValue : *Object) {
+    CompileCommandRef Command;
+    StringRef Directory, File;
+    for (auto &NextKeyValue : *Object) {
       auto *KeyString = dyn_cast<llvm::yaml::ScalarNode>(NextKeyValue.getKey());
       if (!KeyString) {
         ErrorMessage = "Expected strings as key.";
@@ -326,59 +661,201 @@ bool JSONCompilationDatabase::parse(std::string &ErrorMessage) {
         ErrorMessage = "Expected string as value.";
         return false;
       }
+      SmallString<128> ValueStorage;
+      StringRef Scalar = ValueString ? ValueString->getValue(ValueStorage) : "";
       if (KeyValue == "directory") {
-        Directory = ValueString;
+        Directory = Saver.save(Scalar);
+        Command.Directory = encodeString(Scalar, Saver);
       } else if (KeyValue == "arguments") {
-        Command = std::vector<llvm::yaml::ScalarNode *>();
+        std::string Arguments = "[";
         for (auto &Argument : *SequenceString) {
-          auto *Scalar = dyn_cast<llvm::yaml::ScalarNode>(&Argument);
-          if (!Scalar) {
+          auto *ArgumentString = dyn_cast<llvm::yaml::ScalarNode>(&Argument);
+          if (!ArgumentString) {
             ErrorMessage = "Only strings are allowed in 'arguments'.";
             return false;
           }
-          Command->push_back(Scalar);
+          if (Arguments.size() > 1)
+            Arguments += ',';
+          SmallString<128> ArgumentStorage;
+          Arguments +=
+              encodeString(ArgumentString->getValue(ArgumentStorage), Saver);
         }
+        Arguments += ']';
+        Command.Arguments = Saver.save(Arguments);
       } else if (KeyValue == "command") {
-        if (!Command)
-          Command = std::vector<llvm::yaml::ScalarNode *>(1, ValueString);
+        Command.Command = encodeString(Scalar, Saver);
       } else if (KeyValue == "file") {
-        File = ValueString;
+        File = Saver.save(Scalar);
+        Command.Filename = encodeString(Scalar, Saver);
       } else if (KeyValue == "output") {
-        Output = ValueString;
+        Command.Output = encodeString(Scalar, Saver);
       } else {
         ErrorMessage = ("Unknown key: \"" +
                         KeyString->getRawValue() + "\"").str();
         return false;
       }
     }
-    if (!File) {
+    if (Command.Filename.empty()) {
       ErrorMessage = "Missing key: \"file\".";
       return false;
     }
-    if (!Command) {
+    if (Command.Command.empty() && Command.Arguments.empty()) {
       ErrorMessage = "Missing key: \"command\" or \"arguments\".";
       return false;
     }
-    if (!Directory) {
+    if (Command.Directory.empty()) {
       ErrorMessage = "Missing key: \"directory\".";
       return false;
     }
-    SmallString<8> FileStorage;
-    StringRef FileName = File->getValue(FileStorage);
     SmallString<128> NativeFilePath;
-    if (llvm::sys::path::is_relative(FileName)) {
-      SmallString<8> DirectoryStorage;
-      SmallString<128> AbsolutePath(
-          Directory->getValue(DirectoryStorage));
-      llvm::sys::path::append(AbsolutePath, FileName);
-      llvm::sys::path::native(AbsolutePath, NativeFilePath);
-    } else {
-      llvm::sys::path::native(FileName, NativeFilePath);
-    }
-    auto Cmd = CompileCommandRef(Directory, File, *Command, Output);
-    IndexByFile[NativeFilePath].push_back(Cmd);
-    AllCommands.push_back(Cmd);
-    MatchTrie.insert(NativeFilePath);
+    getNativeFilePath(Directory, File, NativeFilePath);
+    Commands.emplace_back(Command, NativeFilePath.str());
   }
+
+  for (const auto &Command : Commands)
+    addCommand(Command.first, Command.second);
+  ParsedAsYAML = true;
   return true;
 }
+
+// The index file starts with a magic number, a version and the size and
+// the xxHash64 of the contents of the database it was written for. Then, for
+// each
+// compile command, it holds the offset and length of its five raw values in
+// the database, followed by the length and the text of its native file path.
+// All integers are little-endian.
+static const char IndexMagic[] = "CLANGCDB";
+static const uint32_t IndexVersion = 2;
+
+namespace {
+/// Reads the integers and strings of an index file.
+class IndexReader {
+public:
+  explicit IndexReader(StringRef Buffer) : Buffer(Buffer) {}
+
+  template <typename T> bool read(T &Value) {
+    if (Buffer.size() < sizeof(T))
+      return false;
+    Value = llvm::support::endian::read<T, llvm::support::little,
+                                        llvm::support::unaligned>(
+        Buffer.data());
+    Buffer = Buffer.drop_front(sizeof(T));
+    return true;
+  }
+
+  bool readBytes(size_t Length, StringRef &Bytes) {
+    if (Buffer.size() < Length)
+      return false;
+    Bytes = Buffer.take_front(Length);
+    Buffer = Buffer.drop_front(Length);
+    return true;
+  }
+
+  /// Reads the offset and length of a value in \p Database.
+  bool readValue(StringRef Database, StringRef &Value) {
+    uint64_t Offset;
+    uint32_t Length;
+    if (!read(Offset) || !read(Length) || Offset > Database.size() ||
+        Length > Database.size() - Offset)
+      return false;
+    Value = Length ? Database.substr(Offset, Length) : StringRef();
+    return true;
+  }
+
+  bool atEnd() const { return Buffer.empty(); }
+
+private:
+  StringRef Buffer;
+};
+} // namespace
+
+bool JSONCompilationDatabase::readIndex(StringRef IndexPath) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> IndexBuffer =
+      llvm::MemoryBuffer::getFile(IndexPath, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
+  if (!IndexBuffer)
+    return false;
+
+  IndexReader Reader((*IndexBuffer)->getBuffer());
+  StringRef Magic;
+  uint32_t Version, NumCommands;
+  uint64_t Size, Hash;
+  StringRef Buffer = Database->getBuffer();
+  // Hashing the database is much cheaper than parsing it, and catches the
+  // changes that keep its size and modification time.
+  if (!Reader.readBytes(sizeof(IndexMagic) - 1, Magic) ||
+      Magic != IndexMagic || !Reader.read(Version) ||
+      Version != IndexVersion || !Reader.read(Size) ||
+      Size != Buffer.size() || !Reader.read(Hash) ||
+      Hash != llvm::xxHash64(Buffer) || !Reader.read(NumCommands))
+    return false;
+
+  // Only add the commands once the whole index was read successfully.
+  std::vector<std::pair<CompileCommandRef, StringRef>> Commands;
+  for (uint32_t I = 0; I < NumCommands; ++I) {
+    CompileCommandRef Command;
+    uint32_t PathLength;
+    StringRef Path;
+    if (!Reader.readValue(Buffer, Command.Directory) ||
+        !Reader.readValue(Buffer, Command.Filename) ||
+        !Reader.readValue(Buffer, Command.Command) ||
+        !Reader.readValue(Buffer, Command.Arguments) ||
+        !Reader.readValue(Buffer, Command.Output) ||
+        !Reader.read(PathLength) || !Reader.readBytes(PathLength, Path))
+      return false;
+    Commands.emplace_back(Command, Path);
+  }
+  if (!Reader.atEnd())
+    return false;
+
+  AllCommands.reserve(Commands.size());
+  CommandFiles.reserve(Commands.size());
+  for (const auto &Command : Commands)
+    addCommand(Command.first, Command.second);
+  LoadedFromIndex = true;
+  return true;
+}
+
+void JSONCompilationDatabase::writeIndex(StringRef IndexPath) const {
+  SmallString<128> TempPath(IndexPath);
+  TempPath += "-%%%%%%%%";
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(TempPath, FD, TempPath))
+    return;
+
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    llvm::support::endian::Writer Writer(OS, llvm::support::little);
+    const char *BufferStart = Database->getBufferStart();
+    auto WriteValue = [&](StringRef Value) {
+      Writer.write<uint64_t>(Value.empty() ? 0 : Value.data() - BufferStart);
+      Writer.write<uint32_t>(Value.size());
+    };
+
+    OS << IndexMagic;
+    Writer.write<uint32_t>(IndexVersion);
+    Writer.write<uint64_t>(Database->getBufferSize());
+    Writer.write<uint64_t>(llvm::xxHash64(Database->getBuffer()));
+    Writer.write<uint32_t>(AllCommands.size());
+    for (unsigned I = 0, E = AllCommands.size(); I != E; ++I) {
+      const CompileCommandRef &Command = AllCommands[I];
+      WriteValue(Command.Directory);
+      WriteValue(Command.Filename);
+      WriteValue(Command.Command);
+      WriteValue(Command.Arguments);
+      WriteValue(Command.Output);
+      Writer.write<uint32_t>(CommandFiles[I].size());
+      OS << CommandFiles[I];
+    }
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+
+  // Concurrent readers see either the old or the new index.
+  if (llvm::sys::fs::rename(TempPath, IndexPath))
+    llvm::sys::fs::remove(TempPath);
+}
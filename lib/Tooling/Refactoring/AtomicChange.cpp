@@ -9,6 +9,9 @@
 
 #include "clang/Tooling/Refactoring/AtomicChange.h"
 #include "clang/Tooling/ReplacementsYaml.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/YAMLTraits.h"
 #include <string>
 
@@ -183,12 +186,14 @@ createReplacementsForHeaders(llvm::StringRef FilePath, llvm::StringRef Code,
 llvm::Expected<Replacements>
 combineReplacementsInChanges(llvm::StringRef FilePath,
                              llvm::ArrayRef<AtomicChange> Changes) {
-  Replacements Replaces;
+  std::vector<Replacement> AllReplaces;
   for (const auto &Change : Changes)
     for (const auto &R : Change.getReplacements())
-      if (auto Err = Replaces.add(Replacement(
-              FilePath, R.getOffset(), R.getLength(), R.getReplacementText())))
-        return std::move(Err);
+      AllReplaces.emplace_back(FilePath, R.getOffset(), R.getLength(),
+                               R.getReplacementText());
+  Replacements Replaces;
+  if (auto Err = Replaces.addAll(AllReplaces))
+    return std::move(Err);
   return Replaces;
 }
 
@@ -361,5 +366,63 @@ applyAtomicChanges(llvm::StringRef FilePath, llvm::StringRef Code,
   return ChangedCode;
 }
 
+llvm::Expected<std::map<std::string, std::string>>
+applyAtomicChangesInFiles(llvm::ArrayRef<AtomicChange> Changes,
+                          llvm::vfs::FileSystem &FS,
+                          const ApplyChangesSpec &Spec, unsigned NumThreads) {
+  std::map<std::string, std::vector<AtomicChange>> FileToChanges;
+  for (const auto &Change : Changes)
+    FileToChanges[Change.getFilePath()].push_back(Change);
+
+  // Each file is processed by a single task that only writes its own result,
+  // so the results can be collected in the order of the file paths.
+  struct FileResult {
+    std::string ChangedCode;
+    std::string Error;
+  };
+  std::vector<FileResult> Results(FileToChanges.size());
+  {
+    llvm::ThreadPool Pool(NumThreads ? NumThreads
+                                     : llvm::hardware_concurrency());
+    unsigned Index = 0;
+    for (const auto &FileAndChanges : FileToChanges) {
+      FileResult &Result = Results[Index++];
+      Pool.async([&FileAndChanges, &Result, &FS, &Spec] {
+        const std::string &FilePath = FileAndChanges.first;
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+            FS.getBufferForFile(FilePath);
+        if (!Buffer) {
+          Result.Error = "Failed to open " + FilePath + " for rewriting: " +
+                         Buffer.getError().message();
+          return;
+        }
+        llvm::Expected<std::string> ChangedCode = applyAtomicChanges(
+            FilePath, (*Buffer)->getBuffer(), FileAndChanges.second, Spec);
+        if (!ChangedCode) {
+          Result.Error =
+              FilePath + ": " + llvm::toString(ChangedCode.takeError());
+          return;
+        }
+        Result.ChangedCode = std::move(*ChangedCode);
+      });
+    }
+    Pool.wait();
+  }
+
+  std::map<std::string, std::string> ChangedFiles;
+  llvm::Error Err = llvm::Error::success();
+  unsigned Index = 0;
+  for (const auto &FileAndChanges : FileToChanges) {
+    FileResult &Result = Results[Index++];
+    if (!Result.Error.empty())
+      Err = llvm::joinErrors(std::move(Err), make_string_error(Result.Error));
+    else
+      ChangedFiles[FileAndChanges.first] = std::move(Result.ChangedCode);
+  }
+  if (Err)
+    return std::move(Err);
+  return ChangedFiles;
+}
+
 } // end namespace tooling
 } // end namespace clang
@@ -0,0 +1,18 @@
+// The body of otherMax is a clone of max and maxClone in cross-tu.cpp. The
+// body of otherMin uses a different variable pattern.
+
+void log();
+
+int otherMax(int u, int v) {
+  log();
+  if (u > v)
+    return u;
+  return v;
+}
+
+int otherMin(int u, int v) {
+  log();
+  if (u > v)
+    return v;
+  return u;
+}
@@ -0,0 +1,34 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_analyze_cc1 -std=c++11 -analyzer-checker=alpha.clone.CloneChecker -analyzer-config alpha.clone.CloneChecker:MinimumCloneComplexity=10 -analyzer-config alpha.clone.CloneChecker:FingerprintDirectory=%t -verify %s
+// RUN: %clang_analyze_cc1 -std=c++11 -analyzer-checker=alpha.clone.CloneChecker -analyzer-config alpha.clone.CloneChecker:MinimumCloneComplexity=10 -analyzer-config alpha.clone.CloneChecker:FingerprintDirectory=%t -verify %s
+// RUN: %clang_analyze_cc1 -std=c++11 -analyzer-checker=alpha.clone.CloneChecker -analyzer-config alpha.clone.CloneChecker:MinimumCloneComplexity=10 -analyzer-config alpha.clone.CloneChecker:FingerprintDirectory=%t %S/Inputs/cross-tu-other.cpp
+// RUN: ls %t | count 2
+// RUN: clang-clone-merge %t | FileCheck %s
+
+// Tests that clones in different translation units are found by merging their
+// fingerprints. The clones in this file are not reported by the checker.
+// Analyzing a file again replaces its fingerprints.
+
+// expected-no-diagnostics
+
+void log();
+
+int max(int a, int b) {
+  log();
+  if (a > b)
+    return a;
+  return b;
+}
+
+int maxClone(int x, int y) {
+  log();
+  if (x > y)
+    return x;
+  return y;
+}
+
+// CHECK: clone group 1 with 3 clones:
+// CHECK-NEXT: {{.*}}Inputs{{/|\\}}cross-tu-other.cpp:6:28-11:1
+// CHECK-NEXT: {{.*}}cross-tu.cpp:13:23-18:1
+// CHECK-NEXT: {{.*}}cross-tu.cpp:20:28-25:1
+// CHECK-NOT: clone group
@@ -0,0 +1,44 @@
+// RUN: rm -f %t.sarif
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=sarif \
+// RUN:   -analyzer-config sarif-append-runs=true %s -o %t.sarif
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=sarif \
+// RUN:   -analyzer-config sarif-append-runs=true %s -o %t.sarif -DSECOND
+// RUN: FileCheck -input-file=%t.sarif %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=sarif \
+// RUN:   %s -o %t.sarif -DSECOND
+// RUN: FileCheck -input-file=%t.sarif -check-prefix=OVERWRITE %s
+//
+// Each invocation appends its results as a new run to the existing file,
+// unless sarif-append-runs is off.
+
+#ifndef SECOND
+int f(int i) {
+  if (i == 0)
+    return 1 / i;
+  return 0;
+}
+#else
+int g(int *p) {
+  if (!p)
+    return *p;
+  return 0;
+}
+#endif
+
+// CHECK: "runs": [
+// CHECK-NEXT: {
+// CHECK: "ruleId": "core.DivideZero"
+// CHECK: "tool": {
+// CHECK: },
+// CHECK-NEXT: {
+// CHECK: "ruleId": "core.NullDereference"
+// CHECK: "tool": {
+// CHECK: ],
+// CHECK-NEXT: "version":
+
+// OVERWRITE: "runs": [
+// OVERWRITE-NOT: "ruleId": "core.DivideZero"
+// OVERWRITE: "ruleId": "core.NullDereference"
+// OVERWRITE: "tool": {
+// OVERWRITE: ],
+// OVERWRITE-NEXT: "version":
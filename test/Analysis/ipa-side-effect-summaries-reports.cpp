@@ -0,0 +1,72 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config ipa-side-effect-summaries=true -DSUMMARIES -verify %s
+//
+// Reports in the caller are kept when the callee writes to memory the caller
+// can see, or when it returns a constant or one of its arguments. Bugs in the
+// callee that depend on the caller's arguments are missed with summaries.
+
+int g;
+
+struct RefHolder {
+  int &Ref;
+};
+
+int resetThroughMember(int &x) {
+  RefHolder h{x};
+  h.Ref = 0;
+  return 1;
+}
+
+void test_reference_member() {
+  int x = 1;
+  resetThroughMember(x);
+  (void)(1 / x); // expected-warning{{Division by zero}}
+}
+
+int add(int a, int b) { return a + b; }
+
+void test_side_effect_free() {
+  g = 0;
+  add(1, 2);
+  (void)(1 / g); // expected-warning{{Division by zero}}
+}
+
+int zero() { return 0; }
+
+void test_constant_result() {
+  (void)(1 / zero()); // expected-warning{{Division by zero}}
+}
+
+int first(int a, int b) {
+  if (b > 0)
+    return a;
+  return a;
+}
+
+void test_argument_result() {
+  (void)(1 / first(0, 1)); // expected-warning{{Division by zero}}
+}
+
+int reassigned(int a) {
+  a = 1;
+  return a;
+}
+
+void test_reassigned_argument() {
+  // The parameter is not the argument anymore.
+  (void)(1 / reassigned(0)); // no-warning
+}
+
+int divide(int a, int b) {
+  return a / b;
+#ifndef SUMMARIES
+  // expected-warning@-2{{Division by zero}}
+#endif
+}
+
+void test_callee_bug() {
+  // With summaries the callee is not visited, so the division by zero in it
+  // is missed.
+  divide(1, 0);
+}
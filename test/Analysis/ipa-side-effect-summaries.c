@@ -0,0 +1,74 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection \
+// RUN:   -analyzer-config eagerly-assume=false -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection \
+// RUN:   -analyzer-config eagerly-assume=false \
+// RUN:   -analyzer-config ipa-side-effect-summaries=true -DSUMMARIES -verify %s
+//
+// Calls to functions without side effects are evaluated without inlining
+// them. The summary keeps everything the caller can observe. The return value
+// is only known when the function always returns the same constant or
+// parameter.
+
+void clang_analyzer_eval(int);
+
+int g;
+
+int add(int a, int b) {
+  int s[2] = {a, b};
+  s[0] += s[1];
+  return s[0];
+}
+
+int twice(int a) { return add(a, a); }
+
+int square(int) __attribute__((const));
+
+int sumOfSquares(int a, int b) { return square(a) + square(b); }
+
+void setG(int v) { g = v; }
+
+int incG(void) { return ++g; }
+
+int *identity(int *p) { return p; }
+
+int zero(void) { return 0; }
+
+int pick(int a, int b) {
+  if (b)
+    return a;
+  return a;
+}
+
+void test_no_invalidation(int x) {
+  g = 0;
+  int r = twice(x);
+  clang_analyzer_eval(g == 0); // expected-warning{{TRUE}}
+#ifdef SUMMARIES
+  clang_analyzer_eval(r == x + x); // expected-warning{{UNKNOWN}}
+#else
+  clang_analyzer_eval(r == x + x); // expected-warning{{TRUE}}
+#endif
+}
+
+void test_const_callees(int x) {
+  g = 0;
+  sumOfSquares(x, x);
+  clang_analyzer_eval(g == 0); // expected-warning{{TRUE}}
+}
+
+void test_known_results(int x) {
+  clang_analyzer_eval(zero() == 0); // expected-warning{{TRUE}}
+  clang_analyzer_eval(pick(x, 1) == x); // expected-warning{{TRUE}}
+}
+
+void test_side_effects(void) {
+  // Functions with side effects are still inlined.
+  setG(1);
+  clang_analyzer_eval(g == 1); // expected-warning{{TRUE}}
+  clang_analyzer_eval(incG() == 2); // expected-warning{{TRUE}}
+}
+
+void test_pointer_result(int *p) {
+  // A conjured pointer would not alias the argument.
+  clang_analyzer_eval(identity(p) == p); // expected-warning{{TRUE}}
+}
@@ -0,0 +1,37 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection \
+// RUN:   -analyzer-config eagerly-assume=false -verify %s
+//
+// Intersections that do not refine a range set return it unchanged, and the
+// ranges of unconstrained symbols are shared between states. Neither may
+// change the results of the constraint manager.
+
+void clang_analyzer_eval(int);
+
+void unchanged(int x) {
+  if (x > 10) {
+    // [11, INT_MAX] is contained in [0, INT_MAX].
+    clang_analyzer_eval(x >= 0); // expected-warning{{TRUE}}
+    // The wrapping range of x != 5 does not cut into [11, INT_MAX].
+    clang_analyzer_eval(x != 5); // expected-warning{{TRUE}}
+    clang_analyzer_eval(x != 11); // expected-warning{{UNKNOWN}}
+  }
+}
+
+void wrapping(unsigned u) {
+  if (u == 0)
+    return;
+  // The range [1, UINT_MAX] lies above the removed value 0.
+  clang_analyzer_eval(u != 0); // expected-warning{{TRUE}}
+  clang_analyzer_eval(u + 1 != 0); // expected-warning{{UNKNOWN}}
+}
+
+void shared_default_range(int a, int b) {
+  clang_analyzer_eval(a - b == -3); // expected-warning{{UNKNOWN}}
+  if (b - a == 3) {
+    // The range of a - b is derived from the one of b - a in this state...
+    clang_analyzer_eval(a - b == -3); // expected-warning{{TRUE}}
+  } else {
+    // ... and must not leak into the other one.
+    clang_analyzer_eval(a - b == -3); // expected-warning{{FALSE}}
+  }
+}
@@ -0,0 +1,45 @@
+// REQUIRES: asserts
+// RUN: rm -rf %t && mkdir %t
+//
+// A function in which a call wasn't inlined because the callee was already
+// inlined too often is not recorded, as that depends on the functions analyzed
+// before it. Once the other caller is skipped, the call is inlined again.
+// RUN: %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config result-cache-dir=%t/budget \
+// RUN:   -analyzer-config max-times-inline-large=0 \
+// RUN:   -analyzer-config min-cfg-size-treat-functions-as-large=0 \
+// RUN:   -analyzer-stats %s 2>&1 | FileCheck %s -check-prefix=BUDGET-FIRST
+// RUN: %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config result-cache-dir=%t/budget \
+// RUN:   -analyzer-config max-times-inline-large=0 \
+// RUN:   -analyzer-config min-cfg-size-treat-functions-as-large=0 \
+// RUN:   -analyzer-stats %s 2>&1 | FileCheck %s -check-prefix=BUDGET-SECOND
+//
+// The least recently used entries are removed once there are too many.
+// RUN: %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config result-cache-dir=%t/evict \
+// RUN:   -analyzer-config result-cache-max-entries=1 %s
+// RUN: ls %t/evict | FileCheck %s -check-prefix=EVICT
+
+static int shared(int *p) {
+  return *p;
+}
+
+int first(int *p) {
+  return shared(p);
+}
+
+int second(int *p) {
+  return shared(p);
+}
+
+// BUDGET-FIRST: ... Statistics Collected ...
+// BUDGET-FIRST-DAG: {{^ *2 AnalysisConsumer *- }}The # of functions analyzed as their results were not cached.
+// BUDGET-FIRST-DAG: {{^ *1 ExprEngine *- }}The # of times we reached inline count maximum
+
+// BUDGET-SECOND: ... Statistics Collected ...
+// BUDGET-SECOND-DAG: {{^ *1 AnalysisConsumer *- }}The # of functions analyzed as their results were not cached.
+// BUDGET-SECOND-DAG: {{^ *1 AnalysisConsumer *- }}The # of functions not analyzed as their results were cached.
+
+// EVICT: llvmcache-
+// EVICT-NOT: llvmcache-
@@ -0,0 +1,62 @@
+// REQUIRES: asserts
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config result-cache-dir=%t/cache \
+// RUN:   -analyzer-stats %s 2>&1 | FileCheck %s -check-prefix=FIRST
+// RUN: %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config result-cache-dir=%t/cache \
+// RUN:   -analyzer-stats %s 2>&1 | FileCheck %s -check-prefix=SECOND
+// RUN: %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config result-cache-dir=%t/cache -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config result-cache-dir=%t/cache -verify -DCHANGED %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core \
+// RUN:   -analyzer-config result-cache-dir=%t/cache -verify -DFATAL_RETURNS %s
+//
+// Functions without bugs are not analyzed again, and neither are the functions
+// that were inlined into them. A change to an inlined function, or to the
+// declaration of a called function, invalidates the results of its callers.
+
+static int helper(int *p) {
+#ifdef CHANGED
+  p = 0;
+  return *p; // expected-warning{{Dereference of null pointer}}
+#else
+  return *p;
+#endif
+}
+
+int clean(int *p) {
+  return helper(p);
+}
+
+#ifdef FATAL_RETURNS
+void fatal(void);
+#else
+void fatal(void) __attribute__((noreturn));
+#endif
+
+int guarded(int *p) {
+  if (!p)
+    fatal();
+#ifdef FATAL_RETURNS
+  return *p; // expected-warning{{Dereference of null pointer}}
+#else
+  return *p;
+#endif
+}
+
+int buggy(void) {
+  int *p = 0;
+  return *p; // expected-warning{{Dereference of null pointer}}
+}
+
+// FIRST: ... Statistics Collected ...
+// FIRST-DAG: {{^ *3 AnalysisConsumer *- }}The # of functions and blocks analyzed
+// FIRST-DAG: {{^ *3 AnalysisConsumer *- }}The # of functions analyzed as their results were not cached.
+
+// SECOND: ... Statistics Collected ...
+// SECOND-DAG: {{^ *1 AnalysisConsumer *- }}The # of functions and blocks analyzed
+// SECOND-DAG: {{^ *1 AnalysisConsumer *- }}The # of functions analyzed as their results were not cached.
+// SECOND-DAG: {{^ *2 AnalysisConsumer *- }}The # of functions not analyzed as their results were cached.
+// SECOND-DAG: {{^ *66 AnalysisConsumer *- }}The % of functions with cached results.
@@ -0,0 +1,28 @@
+// REQUIRES: asserts
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,unix.Malloc \
+// RUN:   -analyzer-stats %s 2>&1 | FileCheck %s
+//
+// Symbols are counted when they are created or found again in the symbol
+// table, and attributed to the checker that was running at the time.
+
+typedef __typeof(sizeof(int)) size_t;
+void *malloc(size_t);
+void free(void *);
+
+int foo(int x) {
+  int *p = malloc(sizeof(int));
+  if (!p)
+    return x;
+  *p = x + 1;
+  int y = *p;
+  free(p);
+  return y;
+}
+
+// CHECK: ... Statistics Collected ...
+// CHECK-DAG: SymbolManager - The # of bytes allocated for symbols and symbolic expressions
+// CHECK-DAG: SymbolManager - The # of symbol lookups that found an existing symbol
+// CHECK-DAG: SymbolManager - The # of symbols and symbolic expressions created
+// CHECK: Symbols created per checker:
+// CHECK-DAG: {{^ +[1-9][0-9]* unix.Malloc$}}
+// CHECK-DAG: {{^ +[1-9][0-9]* \(analyzer core\)$}}
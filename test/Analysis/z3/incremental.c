@@ -0,0 +1,35 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection \
+// RUN:   -analyzer-constraints=z3 -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection \
+// RUN:   -analyzer-constraints=z3 -analyzer-stats %s 2>&1 | FileCheck %s
+// REQUIRES: z3, asserts
+//
+// Queries along a path keep the constraints of their common prefix asserted,
+// and must still see exactly the constraints of the queried state.
+
+void clang_analyzer_eval(int);
+
+void nested(int x, int y, int z) {
+  if (x > 0) {
+    if (y > x) {
+      if (z > y)
+        clang_analyzer_eval(z > 1); // expected-warning{{TRUE}}
+      else
+        clang_analyzer_eval(z > 1); // expected-warning{{UNKNOWN}}
+    }
+    clang_analyzer_eval(y > 0); // expected-warning{{TRUE}} expected-warning{{UNKNOWN}}
+  } else {
+    // None of the constraints of the other branch may leak into this one.
+    clang_analyzer_eval(y > x); // expected-warning{{UNKNOWN}}
+    clang_analyzer_eval(x > 0); // expected-warning{{FALSE}}
+  }
+}
+
+// CHECK: ... Statistics Collected ...
+// CHECK-DAG: {{[0-9]+}} Z3ConstraintManager - The # of SMT queries answered from the query cache
+// CHECK-DAG: {{[0-9]+}} Z3ConstraintManager - The # of constraints asserted on the SMT solver
+// CHECK-DAG: {{[0-9]+}} Z3ConstraintManager - The # of constraints kept asserted between SMT queries
+// CHECK-DAG: {{[0-9]+}} Z3ConstraintManager - The # of queries checked by the SMT solver
+// CHECK: SMT solver timers
+// CHECK-DAG: Asserting constraints
+// CHECK-DAG: Checking satisfiability
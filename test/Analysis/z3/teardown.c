@@ -0,0 +1,26 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection \
+// RUN:   -analyzer-constraints=z3 -verify %s
+// REQUIRES: z3
+//
+// Every top-level function gets its own constraint manager. The expressions
+// it keeps asserted and cached must be released before its Z3 context, which
+// sanitizer builds check once per analyzed function.
+
+void clang_analyzer_eval(int);
+
+void first(int x, int y) {
+  if (x > 0 && y > x)
+    clang_analyzer_eval(y > 1); // expected-warning{{TRUE}}
+}
+
+void second(int x) {
+  if (x == 3)
+    clang_analyzer_eval(x * 2 == 6); // expected-warning{{TRUE}}
+}
+
+void third(int x, int y) {
+  if (x < y)
+    clang_analyzer_eval(y > x); // expected-warning{{TRUE}}
+  else
+    clang_analyzer_eval(y > x); // expected-warning{{FALSE}}
+}
@@ -1,8 +1,10 @@
 // RUNNOT: %cheri_purecap_cc1 -std=c11 %s -emit-llvm -o - -O2 -verify
-// RUN: %cheri_purecap_cc1 -std=c11 %s -emit-llvm -o - -O2 -verify | FileCheck %s -implicit-check-not llvm.memcpy
+// RUN: %cheri_purecap_cc1 -std=c11 %s -emit-llvm -o - -O2 -verify | FileCheck %s -implicit-check-not llvm.memcpy -check-prefixes=CHECK,OFFSET
+// RUN: %cheri_purecap_cc1 -cheri-uintcap=addr -std=c11 %s -emit-llvm -o - -O2 -verify | FileCheck %s -implicit-check-not llvm.memcpy -check-prefixes=CHECK,ADDR
 // Check that we can generate assembly without crashing
 // RUN: %cheri_purecap_cc1 -mllvm -cheri-cap-table-abi=legacy -std=c11 %s -S -o /dev/null -verify
 // RUN: %cheri_purecap_cc1 -mllvm -cheri-cap-table-abi=pcrel -std=c11 %s -S -o /dev/null -verify
+// expected-no-diagnostics
 
 // CHECK-LABEL: @main(
 int main(void) {
@@ -15,12 +17,22 @@ int main(void) {
   // CHECK: [[P_AS_I8_PTRPTR:%.+]] = bitcast i32 addrspace(200)* addrspace(200)* %p to i8 addrspace(200)* addrspace(200)*
   // CHECK: store i8 addrspace(200)* [[INITVAL]], i8 addrspace(200)* addrspace(200)* [[P_AS_I8_PTRPTR]], align
 
-  __c11_atomic_fetch_add(&p, 1, __ATOMIC_SEQ_CST); // expected-warning {{misaligned atomic operation may incur significant performance penalty}}
-  // CHECK: [[INC:%.+]] = tail call i8 addrspace(200)* @llvm.cheri.cap.offset.increment(i8 addrspace(200)* null, i64 4)
-  // CHECK: call i8 addrspace(200)* @__atomic_fetch_add_cap(i8 addrspace(200)* nonnull [[P_AS_I8]], i8 addrspace(200)* [[INC]], i32 signext 5)
-  __c11_atomic_fetch_sub(&p, 2, __ATOMIC_SEQ_CST); // expected-warning {{misaligned atomic operation may incur significant performance penalty}}
-  // CHECK: [[INC2:%.+]] = call i8 addrspace(200)* @llvm.cheri.cap.offset.increment(i8 addrspace(200)* null, i64 8)
-  // CHECK: call i8 addrspace(200)* @__atomic_fetch_sub_cap(i8 addrspace(200)* nonnull [[P_AS_I8]], i8 addrspace(200)* [[INC2]], i32 signext 5)
+  // fetch_add/fetch_sub are emitted inline as a cmpxchg loop on the capability.
+  // The increment is scaled by the size of the pointee.
+  __c11_atomic_fetch_add(&p, 1, __ATOMIC_SEQ_CST);
+  // CHECK: [[INITIAL:%.+]] = load atomic i32 addrspace(200)*, i32 addrspace(200)* addrspace(200)* %p monotonic, align
+  // CHECK: atomicrmw.cap.loop:
+  // CHECK-NEXT: [[OLD:%.+]] = phi i32 addrspace(200)* [ [[INITIAL]], %{{.+}} ], [ [[PREV:%.+]], %atomicrmw.cap.loop ]
+  // CHECK-NEXT: [[OLD_I8:%.+]] = bitcast i32 addrspace(200)* [[OLD]] to i8 addrspace(200)*
+  // CHECK-NEXT: [[NEW_I8:%.+]] = getelementptr i8, i8 addrspace(200)* [[OLD_I8]], i64 4
+  // CHECK-NEXT: [[NEW:%.+]] = bitcast i8 addrspace(200)* [[NEW_I8]] to i32 addrspace(200)*
+  // CHECK-NEXT: [[PAIR:%.+]] = cmpxchg weak i32 addrspace(200)* addrspace(200)* %p, i32 addrspace(200)* [[OLD]], i32 addrspace(200)* [[NEW]] seq_cst seq_cst
+  // CHECK-NEXT: [[PREV]] = extractvalue { i32 addrspace(200)*, i1 } [[PAIR]], 0
+  // CHECK-NEXT: [[SUCCESS:%.+]] = extractvalue { i32 addrspace(200)*, i1 } [[PAIR]], 1
+  // CHECK-NEXT: br i1 [[SUCCESS]], label %atomicrmw.cap.cont, label %atomicrmw.cap.loop
+  __c11_atomic_fetch_sub(&p, 2, __ATOMIC_SEQ_CST);
+  // CHECK: getelementptr i8, i8 addrspace(200)* {{%.+}}, i64 -8
+  // CHECK: cmpxchg weak i32 addrspace(200)* addrspace(200)* %p
   int *c = __c11_atomic_load(&p, __ATOMIC_SEQ_CST);
   // CHECK: [[C_VALUE:%.+]] = load atomic i32 addrspace(200)*, i32 addrspace(200)* addrspace(200)* %p seq_cst, align
   __c11_atomic_store(&p, 0, __ATOMIC_SEQ_CST);
@@ -36,13 +48,6 @@ int main(void) {
   return *old;
 }
 
-// These should really take an i64 argument but fixing the atomic codegen is annoying
-// CHECK: declare i8 addrspace(200)* @__atomic_fetch_add_cap(i8 addrspace(200)*, i8 addrspace(200)*, i32) local_unnamed_addr
-// TODO-CHECK: declare i8 addrspace(200)* @__atomic_fetch_add_cap(i8 addrspace(200)*, i64, i32) local_unnamed_addr
-// CHECK: declare i8 addrspace(200)* @__atomic_fetch_sub_cap(i8 addrspace(200)*, i8 addrspace(200)*, i32) local_unnamed_addr
-// TODO-CHECK: declare i8 addrspace(200)* @__atomic_fetch_sub_cap(i8 addrspace(200)*, i64, i32) local_unnamed_addr
-
-
 // Also check the GCC __atomic builtins: https://gcc.gnu.org/onlinedocs/gcc/_005f_005fatomic-Builtins.html
 int __atomic_stuff(int** p, int* expected, int* newval) {
   int* x1 = __atomic_load_n(p, __ATOMIC_SEQ_CST);
@@ -71,8 +76,44 @@ int __atomic_stuff(int** p, int* expected, int* newval) {
   __atomic_compare_exchange_n(p, &expected, newval, 1, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
   // CHECK: cmpxchg weak i32 addrspace(200)* addrspace(200)* %p, i32 addrspace(200)* %9, i32 addrspace(200)* %newval seq_cst seq_cst
 
-  // TODO: fetch_add/add_fetch
-  return 0;
+  int* x5 = __atomic_fetch_add(p, 16, __ATOMIC_RELAXED);
+  // CHECK: getelementptr i8, i8 addrspace(200)* {{%.+}}, i64 16
+  // CHECK: cmpxchg weak i32 addrspace(200)* addrspace(200)* %p, {{.+}} monotonic monotonic
+  int* x6 = __atomic_sub_fetch(p, 32, __ATOMIC_ACQUIRE);
+  // CHECK: getelementptr i8, i8 addrspace(200)* {{%.+}}, i64 -32
+  // CHECK: cmpxchg weak i32 addrspace(200)* addrspace(200)* %p, {{.+}} acquire acquire
+  return x5 == x6;
+}
+
+// __intcap_t increments are capabilities. Like ordinary __intcap_t arithmetic,
+// their integer value is added, not the address of the temporary holding them.
+// CHECK-LABEL: @intcap(
+__intcap_t intcap(_Atomic(__intcap_t) *p, __intcap_t inc, __intcap_t dec) {
+  __c11_atomic_fetch_add(p, inc, __ATOMIC_SEQ_CST);
+  // OFFSET: [[INC:%.+]] = {{(tail )?}}call i64 @llvm.cheri.cap.offset.get(i8 addrspace(200)* %inc)
+  // ADDR: [[INC:%.+]] = {{(tail )?}}call i64 @llvm.cheri.cap.address.get(i8 addrspace(200)* %inc)
+  // CHECK: atomicrmw.cap.loop:
+  // CHECK-NEXT: [[OLD:%.+]] = phi i8 addrspace(200)*
+  // CHECK-NEXT: [[NEW:%.+]] = getelementptr i8, i8 addrspace(200)* [[OLD]], i64 [[INC]]
+  // CHECK-NEXT: cmpxchg weak i8 addrspace(200)* addrspace(200)* %p, i8 addrspace(200)* [[OLD]], i8 addrspace(200)* [[NEW]] seq_cst seq_cst
+  return __c11_atomic_fetch_sub(p, dec, __ATOMIC_SEQ_CST);
+  // OFFSET: [[DEC:%.+]] = {{(tail )?}}call i64 @llvm.cheri.cap.offset.get(i8 addrspace(200)* %dec)
+  // ADDR: [[DEC:%.+]] = {{(tail )?}}call i64 @llvm.cheri.cap.address.get(i8 addrspace(200)* %dec)
+  // CHECK: [[NEG:%.+]] = sub i64 0, [[DEC]]
+  // CHECK: atomicrmw.cap.loop{{[0-9]+}}:
+  // CHECK-NEXT: [[OLD2:%.+]] = phi i8 addrspace(200)*
+  // CHECK-NEXT: [[NEW2:%.+]] = getelementptr i8, i8 addrspace(200)* [[OLD2]], i64 [[NEG]]
+  // CHECK-NEXT: cmpxchg weak i8 addrspace(200)* addrspace(200)* %p, i8 addrspace(200)* [[OLD2]], i8 addrspace(200)* [[NEW2]] seq_cst seq_cst
+}
+
+// CHECK-LABEL: @uintcap(
+__uintcap_t uintcap(_Atomic(__uintcap_t) *p, __uintcap_t inc) {
+  return __atomic_add_fetch(p, inc, __ATOMIC_RELAXED);
+  // OFFSET: [[INC:%.+]] = {{(tail )?}}call i64 @llvm.cheri.cap.offset.get(i8 addrspace(200)* %inc)
+  // ADDR: [[INC:%.+]] = {{(tail )?}}call i64 @llvm.cheri.cap.address.get(i8 addrspace(200)* %inc)
+  // CHECK: [[OLD:%.+]] = phi i8 addrspace(200)*
+  // CHECK-NEXT: [[NEW:%.+]] = getelementptr i8, i8 addrspace(200)* [[OLD]], i64 [[INC]]
+  // CHECK-NEXT: cmpxchg weak i8 addrspace(200)* addrspace(200)* %p, i8 addrspace(200)* [[OLD]], i8 addrspace(200)* [[NEW]] monotonic monotonic
 }
 
 // CHECK-LABEL: @uint128(
@@ -90,3 +131,7 @@ int uint128(void) {
   // CHECK: cmpxchg i128 addrspace(200)* %p, i128 0, i128 %{{.+}} seq_cst seq_cst
   return 0;
 }
+
+// Capability fetch_add/fetch_sub no longer need a libcall
+// CHECK-NOT: @__atomic_fetch_add_cap
+// CHECK-NOT: @__atomic_fetch_sub_cap
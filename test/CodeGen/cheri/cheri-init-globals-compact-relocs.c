@@ -0,0 +1,25 @@
+// RUN: %cheri_purecap_cc1 %s -mllvm -cheri-cap-table-abi=legacy -x c -emit-llvm -O2 -o - | FileCheck %s -check-prefix=LEGACY
+// RUN: %cheri_purecap_cc1 %s -mllvm -cheri-cap-table-abi=legacy -x c -emit-llvm -O2 -o - \
+// RUN:   -DCHERI_INIT_GLOBALS_USE_COMPACT_RELOCS | FileCheck %s -check-prefix=COMPACT
+// RUN: %cheri_purecap_cc1 %s -mllvm -cheri-cap-table-abi=plt -x c -S -O2 -o - \
+// RUN:   -DCHERI_INIT_GLOBALS_USE_COMPACT_RELOCS | FileCheck %s -check-prefix=COMPACT-ASM
+
+#include <cheri_init_globals.h>
+
+void init(void) {
+  cheri_init_globals();
+}
+
+// LEGACY: @__start___cap_relocs = extern_weak
+// LEGACY: @__stop___cap_relocs = extern_weak
+// LEGACY-NOT: __cap_relocs_compact
+
+// COMPACT: @__start___cap_relocs_compact = extern_weak
+// COMPACT: @__stop___cap_relocs_compact = extern_weak
+// COMPACT-LABEL: define void @init()
+// COMPACT: call i64 @llvm.cttz.i64
+// COMPACT: call i8 addrspace(200)* @llvm.cheri.cap.bounds.set
+
+// COMPACT-ASM-LABEL: init:
+// COMPACT-ASM: dla $[[START:[0-9]+]], __start___cap_relocs_compact
+// COMPACT-ASM: dla $[[STOP:[0-9]+]], __stop___cap_relocs_compact
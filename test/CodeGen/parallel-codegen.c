@@ -0,0 +1,40 @@
+// REQUIRES: x86-registered-target
+
+// RUN: %clang_cc1 -triple x86_64-unknown-linux -emit-obj -O1 \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t.1.o -o %t.0.o %s
+// RUN: llvm-nm --defined-only -P %t.0.o > %t.syms
+// RUN: llvm-nm --defined-only -P %t.1.o >> %t.syms
+// RUN: sort %t.syms | FileCheck %s
+
+// Every definition is emitted into exactly one partition and local symbols
+// keep their names.
+// CHECK: {{^}}counter D
+// CHECK-NEXT: {{^}}global_a T
+// CHECK-NEXT: {{^}}global_b T
+// CHECK-NEXT: {{^}}local_helper t
+// CHECK-NOT: {{.}}
+
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux -emit-obj \
+// RUN:   -parallel-codegen-output %t.1.o -split-dwarf-file %t.dwo \
+// RUN:   -o %t.0.o %s 2>&1 | FileCheck -check-prefix=CHECK-DWARF %s
+// CHECK-DWARF: invalid argument '-parallel-codegen-output' not allowed with '-split-dwarf-file'
+
+// Backend diagnostics of the worker threads are reported by clang.
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux -emit-obj -DBAD_ASM \
+// RUN:   -fparallel-codegen=2 -parallel-codegen-output %t.1.o -o %t.0.o %s \
+// RUN:   2>&1 | FileCheck -check-prefix=CHECK-ASM %s
+// CHECK-ASM: parallel-codegen.c:[[@LINE+3]]:{{[0-9]+}}: error: invalid instruction mnemonic 'not_an_instruction'
+
+#ifdef BAD_ASM
+void bad_asm(void) { __asm__("not_an_instruction"); }
+#endif
+
+int counter = 1;
+
+static __attribute__((noinline)) int local_helper(int x) {
+  return x * counter;
+}
+
+int global_a(int x) { return local_helper(x) + 1; }
+
+int global_b(int x) { return global_a(x) * 2; }
@@ -0,0 +1,30 @@
+// Check that -fparallel-codegen=N compiles to N partition objects and
+// combines them with a relocatable link.
+
+// RUN: %clang -target x86_64-unknown-linux -### -c %s -o %t.o \
+// RUN:   -fparallel-codegen=3 2>&1 | FileCheck -check-prefix=CHECK-PARALLEL %s
+//
+// CHECK-PARALLEL: "-cc1"
+// CHECK-PARALLEL-SAME: "-fparallel-codegen=3"
+// CHECK-PARALLEL-SAME: "-parallel-codegen-output" "[[PART1:[^"]*parallel-codegen-[^"]*.o]]"
+// CHECK-PARALLEL-SAME: "-parallel-codegen-output" "[[PART2:[^"]*parallel-codegen-[^"]*.o]]"
+// CHECK-PARALLEL-SAME: "-o" "[[PART0:[^"]*parallel-codegen-[^"]*.o]]"
+// CHECK-PARALLEL: "-r" "-o" "{{.*}}.o" "[[PART0]]" "[[PART1]]" "[[PART2]]"
+
+// A single thread, non-object outputs and split DWARF use the normal path.
+// RUN: %clang -target x86_64-unknown-linux -### -c %s -o %t.o \
+// RUN:   -fparallel-codegen=1 2>&1 | FileCheck -check-prefix=CHECK-SERIAL %s
+// RUN: %clang -target x86_64-unknown-linux -### -S %s -o %t.s \
+// RUN:   -fparallel-codegen=2 2>&1 | FileCheck -check-prefix=CHECK-SERIAL %s
+// RUN: %clang -target x86_64-unknown-linux -### -c %s -o %t.o -gsplit-dwarf \
+// RUN:   -fparallel-codegen=2 2>&1 | FileCheck -check-prefix=CHECK-SERIAL %s
+//
+// CHECK-SERIAL-NOT: "-parallel-codegen-output"
+// CHECK-SERIAL-NOT: "-r"
+
+// RUN: %clang -target x86_64-unknown-linux -### -c %s -fparallel-codegen=0 \
+// RUN:   2>&1 | FileCheck -check-prefix=CHECK-INVALID %s
+//
+// CHECK-INVALID: invalid integral value '0' in '-fparallel-codegen=0'
+
+int f(void) { return 0; }
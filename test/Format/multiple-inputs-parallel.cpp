@@ -0,0 +1,16 @@
+// RUN: cp %s %t-1.cpp
+// RUN: cp %s %t-2.cpp
+// RUN: cp %s %t-3.cpp
+// RUN: clang-format -style=LLVM -j=2 %t-1.cpp %t-2.cpp %t-3.cpp | FileCheck -strict-whitespace %s
+// RUN: clang-format -style=LLVM -j=2 -verbose %t-1.cpp %t-2.cpp %t-3.cpp 2>&1 >/dev/null | FileCheck %s -check-prefix=VERBOSE
+// RUN: clang-format -style=LLVM -j=0 -i %t-1.cpp %t-2.cpp %t-3.cpp
+// RUN: FileCheck -strict-whitespace -input-file=%t-1.cpp %s
+// RUN: FileCheck -strict-whitespace -input-file=%t-3.cpp %s
+
+// CHECK: {{^int\ \*i;}}
+// CHECK: {{^int\ \*i;}}
+// VERBOSE: Formatting {{.*}}-1.cpp
+// VERBOSE-NEXT: Formatting {{.*}}-2.cpp
+// VERBOSE-NEXT: Formatting {{.*}}-3.cpp
+ int   *  i  ;
+ int   *  i  ;
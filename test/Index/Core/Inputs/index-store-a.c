@@ -0,0 +1,3 @@
+#include "index-store.h"
+
+int first(void) { return shared(); }
@@ -0,0 +1,3 @@
+#include "index-store.h"
+
+int broken(void) { return undeclared; }
@@ -0,0 +1,4 @@
+#define SHARED_CONFIG 1
+#include "index-store.h"
+
+int third(void) { return shared(); }
@@ -0,0 +1,4 @@
+#include "index-store.h"
+#include "index-store.h"
+
+int twice(void) { return shared(); }
@@ -0,0 +1,35 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: sed -e "s|INPUT_DIR|%/S/Inputs|g" %S/Inputs/index-store-compile-db.json > %t/compile_commands.json
+// RUN: c-index-test core -index-compile-db -compile-db %t/compile_commands.json -index-store-path %t/store -skip-indexed-headers -j 1 | FileCheck %s
+// RUN: cat %t/store/records/index-store.h-* | FileCheck -check-prefix=RECORD %s
+// RUN: cat %t/store/units/index-store-b.c-* | FileCheck -check-prefix=UNIT %s
+
+// RUN: sed -e "s|INPUT_DIR|%/S/Inputs|g" %S/Inputs/index-store-macro-compile-db.json > %t/macro_compile_commands.json
+// RUN: c-index-test core -index-compile-db -compile-db %t/macro_compile_commands.json -index-store-path %t/macro-store -skip-indexed-headers -j 1 | FileCheck -check-prefix=MACRO %s
+
+// RUN: sed -e "s|INPUT_DIR|%/S/Inputs|g" %S/Inputs/index-store-error-compile-db.json > %t/error_compile_commands.json
+// RUN: c-index-test core -index-compile-db -compile-db %t/error_compile_commands.json -index-store-path %t/error-store -skip-indexed-headers -j 1 | FileCheck -check-prefix=ERROR %s
+
+// The declarations of the shared header are only visited by the first
+// translation unit that includes it.
+// CHECK: headers indexed: 1
+// CHECK-NEXT: headers skipped: 1
+// CHECK-NEXT: top-level decls visited: 3
+// CHECK-NEXT: top-level decls skipped: 1
+
+// RECORD: record {{.*}}index-store.h
+// RECORD-NEXT: 1:5 | function/C | shared | c:@F@shared | Decl
+
+// The unit of the translation unit that skipped the header still depends on
+// its record.
+// UNIT: unit {{.*}}index-store-b.c
+// UNIT-NEXT: index-store-b.c-{{.*}} | {{.*}}index-store-b.c
+// UNIT-NEXT: index-store.h-{{.*}} | {{.*}}index-store.h
+
+// A header included with different macros defined is indexed again.
+// MACRO: headers indexed: 3
+// MACRO-NEXT: headers skipped: 0
+
+// A header claimed by a translation unit with errors is indexed again.
+// ERROR: headers indexed: 2
+// ERROR-NEXT: headers skipped: 0
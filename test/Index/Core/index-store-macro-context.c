@@ -0,0 +1,12 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: sed -e "s|INPUT_DIR|%/S/Inputs|g" %S/Inputs/index-store-macro-compile-db.json > %t/compile_commands.json
+// RUN: c-index-test core -index-compile-db -compile-db %t/compile_commands.json -index-store-path %t/store -j 1 | FileCheck %s
+// RUN: ls %t/store/records | count 6
+// RUN: ls %t/store/records/index-store.h-* | count 3
+
+// The shared header gets a record for each set of macros it is included with:
+// none, one defined on the command line and one defined before the #include.
+// CHECK: translation units: 3 (0 failed)
+// CHECK-NEXT: units written: 3
+// CHECK-NEXT: records written: 6
+// CHECK-NEXT: records reused: 0
@@ -0,0 +1,19 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: sed -e "s|INPUT_DIR|%/S/Inputs|g" %S/Inputs/index-store-twice-compile-db.json > %t/compile_commands.json
+// RUN: c-index-test core -index-compile-db -compile-db %t/compile_commands.json -index-store-path %t/store -j 1 | FileCheck %s
+// RUN: ls %t/store/records | count 2
+// RUN: cat %t/store/units/* | FileCheck -check-prefix=UNIT %s
+// RUN: cat %t/store/records/index-store.h-* | FileCheck -check-prefix=RECORD %s
+
+// A header included twice with the same macros gets a single record.
+// CHECK: translation units: 1 (0 failed)
+// CHECK-NEXT: units written: 1
+// CHECK-NEXT: records written: 2
+// CHECK-NEXT: records reused: 0
+
+// UNIT: index-store.h-{{.*}} | {{.*}}index-store.h
+// UNIT-NOT: index-store.h
+
+// RECORD: record {{.*}}index-store.h
+// RECORD-NEXT: 1:5 | function/C | shared | c:@F@shared | Decl
+// RECORD-NOT: 1:5
@@ -0,0 +1,23 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: sed -e "s|INPUT_DIR|%/S/Inputs|g" %S/Inputs/index-store-compile-db.json > %t/compile_commands.json
+// RUN: c-index-test core -index-compile-db -compile-db %t/compile_commands.json -index-store-path %t/store -j 1 | FileCheck -check-prefix=FIRST %s
+// RUN: ls %t/store/records | count 3
+// RUN: ls %t/store/units | count 2
+// RUN: cat %t/store/records/index-store.h-* | FileCheck -check-prefix=RECORD %s
+// RUN: c-index-test core -index-compile-db -compile-db %t/compile_commands.json -index-store-path %t/store -j 2 | FileCheck -check-prefix=SECOND %s
+// RUN: ls %t/store/records | count 3
+
+// The shared header is recorded once.
+// FIRST: translation units: 2 (0 failed)
+// FIRST-NEXT: units written: 2
+// FIRST-NEXT: records written: 3
+// FIRST-NEXT: records reused: 1
+// FIRST-NEXT: time: {{.*}}s ({{.*}} translation units/s)
+
+// RECORD: record {{.*}}index-store.h
+// RECORD-NEXT: 1:5 | function/C | shared | c:@F@shared | Decl
+
+// SECOND: translation units: 2 (0 failed)
+// SECOND-NEXT: units written: 2
+// SECOND-NEXT: records written: 0
+// SECOND-NEXT: records reused: 4
@@ -0,0 +1,15 @@
+#include "complete-cached-globals-prefix.h"
+void f(void) {
+  wib
+}
+
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_COMPLETION_CACHING=1 c-index-test -code-completion-at=%s:3:6 %s | FileCheck -check-prefix=CHECK-ALL %s
+// CHECK-ALL: FunctionDecl:{ResultType int}{TypedText wibble_one}{LeftParen (}{RightParen )} (50)
+// CHECK-ALL: FunctionDecl:{ResultType int}{TypedText wibble_two}{LeftParen (}{RightParen )} (50)
+// CHECK-ALL: FunctionDecl:{ResultType int}{TypedText wobble}{LeftParen (}{RightParen )} (50)
+
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_COMPLETION_CACHING=1 CINDEXTEST_COMPLETION_FILTER_BY_PREFIX=1 c-index-test -code-completion-at=%s:3:6 %s | FileCheck -check-prefix=CHECK-PREFIX %s
+// CHECK-PREFIX-NOT: WIBBLE_MACRO
+// CHECK-PREFIX: FunctionDecl:{ResultType int}{TypedText wibble_one}{LeftParen (}{RightParen )} (50)
+// CHECK-PREFIX: FunctionDecl:{ResultType int}{TypedText wibble_two}{LeftParen (}{RightParen )} (50)
+// CHECK-PREFIX-NOT: wobble
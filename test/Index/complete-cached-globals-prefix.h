@@ -0,0 +1,4 @@
+int wibble_one(void);
+int wibble_two(void);
+int wobble(void);
+#define WIBBLE_MACRO 1
@@ -0,0 +1,31 @@
+// RUN: %clang_cc1 -fsyntax-only -Wuninitialized -Wsometimes-uninitialized -print-stats %s 2>&1 | FileCheck -check-prefixes=CHECK,CHECK-C %s
+// RUN: %clang_cc1 -fsyntax-only -Wuninitialized -Wsometimes-uninitialized -print-stats -x c++ %s 2>&1 | FileCheck -check-prefixes=CHECK,CHECK-CXX %s
+
+// The uninitialized values analysis only tracks the variables that may be
+// reported. Variables that are never used are not tracked, and in C++ neither
+// are variables with an initializer, since no jump can bypass it.
+
+#define VARS4(n) int n##0 = 0, n##1 = 1, n##2 = 2, n##3 = 3;
+#define VARS16(n) VARS4(n##0) VARS4(n##1) VARS4(n##2) VARS4(n##3)
+#define USE4(n) n##0 + n##1 + n##2 + n##3
+#define USE16(n) USE4(n##0) + USE4(n##1) + USE4(n##2) + USE4(n##3)
+
+int state_machine(int state) {
+  VARS16(a)
+  int result;
+  int unused;
+  if (state == 0)
+    result = USE16(a);
+  return result;
+}
+// CHECK: :[[@LINE-4]]:7: warning: variable 'result' is used uninitialized whenever 'if' condition is false
+
+int self_init() {
+  int x = x + 1;
+  return x;
+}
+// CHECK: :[[@LINE-3]]:11: warning: variable 'x' is uninitialized when used within its own initialization
+
+// CHECK: 2 functions analyzed for uninitialiazed variables
+// CHECK-C-NEXT: 18 variables analyzed.
+// CHECK-CXX-NEXT: 2 variables analyzed.
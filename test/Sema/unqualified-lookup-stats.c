@@ -0,0 +1,34 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+// CHECK: *** Semantic Analysis Stats:
+// CHECK: {{[1-9][0-9]*}} unqualified lookups.
+// CHECK: {{[0-9]+}} identifier chain entries at lookup (max chain length {{[1-9][0-9]*}}, average {{[0-9]+\.[0-9]+}}).
+// CHECK: {{[0-9]+\.[0-9]+}} ms spent in unqualified lookup.
+
+// expected-no-diagnostics
+
+int x;
+char *p;
+
+int repeated(void) {
+  return x + x + x + x;
+}
+
+// Shadowing declarations lengthen the identifier chain of 'x'.
+void shadowed(void) {
+  x = 1;
+  char x;
+  _Static_assert(sizeof(x) == 1, "local 'x' should shadow the global one");
+  {
+    p = &x;
+    double x;
+    _Static_assert(sizeof(x) == sizeof(double), "inner 'x' should be found");
+  }
+  _Static_assert(sizeof(x) == 1, "local 'x' should be found again");
+}
+
+int x;
+int after(void) {
+  return x + x;
+}
@@ -0,0 +1,29 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+// CHECK: *** Semantic Analysis Stats:
+// CHECK: 6 overload resolutions, 15 candidates, 3 candidates with the wrong number of arguments.
+// CHECK-NEXT: 6 overloaded calls, 2 with the same callees and argument types as an earlier call.
+
+// expected-no-diagnostics
+
+double f(double);
+float f(float);
+int f(int, int);
+
+// The second call repeats the first one. The two-argument overload is ruled
+// out by its arity in every call.
+void calls(double d, float x) {
+  f(d);
+  f(d);
+  f(x);
+}
+
+struct S {};
+S &operator<<(S &, int);
+S &operator<<(S &, double);
+
+// The second operator<< has the same operand types as the first one.
+void operators(S &s) {
+  s << 1 << 2 << 3.0;
+}
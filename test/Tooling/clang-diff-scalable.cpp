@@ -0,0 +1,49 @@
+// RUN: %clang_cc1 -E %s > %t.src.cpp
+// RUN: %clang_cc1 -E %s > %t.dst.cpp -DDEST
+// RUN: clang-diff -dump-matches -stats %t.src.cpp %t.dst.cpp -- \
+// RUN:   > %t.hashes 2> %t.stats
+// RUN: FileCheck %s < %t.hashes
+// RUN: FileCheck -check-prefix=STATS %s < %t.stats
+// RUN: clang-diff -dump-matches -subtree-hashes=false %t.src.cpp %t.dst.cpp -- \
+// RUN:   > %t.pairwise
+// RUN: diff %t.hashes %t.pairwise
+// RUN: clang-diff -dump-matches -stats -max-matrix-size=29 %t.src.cpp \
+// RUN:   %t.dst.cpp -- 2>&1 | FileCheck -check-prefix=BOUNDED %s
+//
+// Finding identical subtrees by their hashes yields the same mapping as
+// comparing them pairwise. Limiting the size of the edit distance matrices
+// skips the optimal matching of the function bodies, which have 6 and 5 nodes.
+
+#ifndef DEST
+
+void f1() { {;} {{;}} }
+
+#else
+
+void f1() {
+  ; {{;}}
+}
+
+#endif
+
+// CHECK: Match CompoundStmt(2) to CompoundStmt(2)
+// CHECK-NEXT: Match NullStmt(4) to NullStmt(3)
+// CHECK: Delete CompoundStmt(3)
+
+// STATS: source nodes: 8
+// STATS-NEXT: destination nodes: 7
+// STATS-NEXT: matched nodes: 7
+// STATS: inserted nodes: 0
+// STATS-NEXT: deleted nodes: 1
+// STATS-NEXT: matching time: {{[0-9.]+}}s
+
+// BOUNDED: source nodes: 8
+// BOUNDED-NEXT: destination nodes: 7
+// BOUNDED-NEXT: matched nodes: 6
+// BOUNDED: inserted nodes: 1
+// BOUNDED-NEXT: deleted nodes: 2
+// BOUNDED: Match CompoundStmt(2) to CompoundStmt(2)
+// BOUNDED-NOT: Match NullStmt(4)
+// BOUNDED: Insert NullStmt(3)
+// BOUNDED: Delete CompoundStmt(3)
+// BOUNDED: Delete NullStmt(4)
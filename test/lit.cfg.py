@@ -64,6 +64,7 @@ tool_dirs = [config.clang_tools_dir, config.llvm_tools_dir]
 tools = [
     'llvm-readobj', 'llvm-objdump', 'llvm-dwarfdump', # XXXAR: needed by some CHERI tests
     'c-index-test', 'clang-check', 'clang-diff', 'clang-format', 'clang-tblgen',
+    ToolSubst('clang-clone-merge', unresolved='ignore'),
     'opt',
     ToolSubst('%clang_func_map', command=FindTool(
         'clang-func-mapping'), unresolved='ignore'),
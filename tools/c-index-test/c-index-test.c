@@ -1261,6 +1261,10 @@ void PrintMemoryUsage(CXTranslationUnit TU) {
   for (i = 0 ; i != usage.numEntries; ++i) {
     const char *name = clang_getTUResourceUsageName(usage.entries[i].kind);
     unsigned long amount = usage.entries[i].amount;
+    if (usage.entries[i].kind > CXTUResourceUsage_MEMORY_IN_BYTES_END) {
+      fprintf(stderr, "  %s : %ld\n", name, amount);
+      continue;
+    }
     total += amount;
     fprintf(stderr, "  %s : %ld bytes (%f MBytes)\n", name, amount,
             ((double) amount)/(1024*1024));
@@ -2588,6 +2592,8 @@ int perform_code_completion(int argc, const char **argv, int timing_only) {
     completionOptions |= CXCodeComplete_SkipPreamble;
   if (getenv("CINDEXTEST_COMPLETION_INCLUDE_FIXITS"))
     completionOptions |= CXCodeComplete_IncludeCompletionsWithFixIts;
+  if (getenv("CINDEXTEST_COMPLETION_FILTER_BY_PREFIX"))
+    completionOptions |= CXCodeComplete_FilterByTypedPrefix;
   
   if (timing_only)
     input += strlen("-code-completion-timing=");
@@ -3764,6 +3770,8 @@ static unsigned getIndexOptions(void) {
     index_opts |= CXIndexOpt_SkipParsedBodiesInSession;
   if (getenv("CINDEXTEST_INDEXIMPLICITTEMPLATEINSTANTIATIONS"))
     index_opts |= CXIndexOpt_IndexImplicitTemplateInstantiations;
+  if (getenv("CINDEXTEST_SKIP_INDEXED_HEADERS"))
+    index_opts |= CXIndexOpt_SkipIndexedHeadersInSession;
 
   return index_opts;
 }
@@ -15,15 +15,22 @@
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Index/IndexingAction.h"
 #include "clang/Index/IndexDataConsumer.h"
+#include "clang/Index/IndexStore.h"
+#include "clang/Index/IndexedHeaderRegistry.h"
 #include "clang/Index/USRGeneration.h"
 #include "clang/Index/CodegenNameGenerator.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Serialization/ASTReader.h"
+#include "clang/Tooling/JSONCompilationDatabase.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include <chrono>
 
 using namespace clang;
 using namespace clang::index;
@@ -36,6 +43,7 @@ namespace {
 enum class ActionType {
   None,
   PrintSourceSymbols,
+  IndexCompileDB,
 };
 
 namespace options {
@@ -46,7 +54,9 @@ static cl::opt<ActionType>
 Action(cl::desc("Action:"), cl::init(ActionType::None),
        cl::values(
           clEnumValN(ActionType::PrintSourceSymbols,
-                     "print-source-symbols", "Print symbols from source")),
+                     "print-source-symbols", "Print symbols from source"),
+          clEnumValN(ActionType::IndexCompileDB, "index-compile-db",
+                     "Index a compilation database into an index store")),
        cl::cat(IndexTestCoreCategory));
 
 static cl::extrahelp MoreHelp(
@@ -68,6 +78,21 @@ static cl::opt<std::string>
   ModuleFormat("fmodule-format", cl::init("raw"),
         cl::desc("Container format for clang modules and PCH, 'raw' or 'obj'"));
 
+static cl::opt<std::string>
+CompileDBPath("compile-db",
+              cl::desc("Path to the compilation database to index"));
+static cl::opt<std::string>
+IndexStorePath("index-store-path",
+               cl::desc("Directory of the index store to write"));
+static cl::opt<bool>
+SkipIndexedHeaders("skip-indexed-headers",
+                   cl::desc("Index each header only in the first translation "
+                            "unit that includes it"));
+static cl::opt<unsigned>
+NumThreads("j", cl::init(0),
+           cl::desc("Number of translation units to index in parallel "
+                    "(0 = number of hardware threads)"));
+
 }
 } // anonymous namespace
 
@@ -280,6 +305,82 @@ static bool printSourceSymbolsFromModule(StringRef modulePath,
   return false;
 }
 
+//===----------------------------------------------------------------------===//
+// Index Compilation Database
+//===----------------------------------------------------------------------===//
+
+static bool
+indexCompileCommand(const tooling::CompileCommand &Command, StringRef StorePath,
+                    IndexStoreStats &Stats,
+                    std::shared_ptr<IndexedHeaderRegistry> HeaderRegistry) {
+  std::vector<const char *> Args;
+  for (const std::string &Arg : Command.CommandLine)
+    Args.push_back(Arg.c_str());
+  IntrusiveRefCntPtr<DiagnosticsEngine> Diags(
+      CompilerInstance::createDiagnostics(new DiagnosticOptions,
+                                          new IgnoringDiagConsumer()));
+  std::shared_ptr<CompilerInvocation> CInvok =
+      createInvocationFromCommandLine(Args, Diags);
+  if (!CInvok)
+    return true;
+  CInvok->getFileSystemOpts().WorkingDir = Command.Directory;
+
+  auto DataConsumer = createIndexStoreDataConsumer(StorePath, &Stats);
+  IndexingOptions IndexOpts;
+  IndexOpts.HeaderRegistry = std::move(HeaderRegistry);
+  std::unique_ptr<FrontendAction> IndexAction = createIndexingAction(
+      DataConsumer, IndexOpts, /*WrappedAction=*/nullptr);
+  auto PCHContainerOps = std::make_shared<PCHContainerOperations>();
+  std::unique_ptr<ASTUnit> Unit(ASTUnit::LoadFromCompilerInvocationAction(
+      std::move(CInvok), PCHContainerOps, Diags, IndexAction.get()));
+  return !Unit;
+}
+
+static bool indexCompileDB(StringRef DBPath, StringRef StorePath,
+                           bool SkipIndexedHeaders, unsigned NumThreads) {
+  std::string ErrorMessage;
+  std::unique_ptr<tooling::JSONCompilationDatabase> DB =
+      tooling::JSONCompilationDatabase::loadFromFile(
+          DBPath, ErrorMessage, tooling::JSONCommandLineSyntax::AutoDetect);
+  if (!DB) {
+    errs() << "error: " << ErrorMessage << '\n';
+    return true;
+  }
+
+  std::vector<tooling::CompileCommand> Commands = DB->getAllCompileCommands();
+  IndexStoreStats Stats;
+  std::shared_ptr<IndexedHeaderRegistry> HeaderRegistry;
+  if (SkipIndexedHeaders)
+    HeaderRegistry = std::make_shared<IndexedHeaderRegistry>();
+  std::atomic<unsigned> NumFailed(0);
+  auto Start = std::chrono::steady_clock::now();
+  {
+    ThreadPool Pool(NumThreads ? NumThreads
+                               : llvm::heavyweight_hardware_concurrency());
+    for (const tooling::CompileCommand &Command : Commands)
+      Pool.async([&Command, StorePath, &Stats, HeaderRegistry, &NumFailed] {
+        if (indexCompileCommand(Command, StorePath, Stats, HeaderRegistry))
+          ++NumFailed;
+      });
+    Pool.wait();
+  }
+  std::chrono::duration<double> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+
+  raw_ostream &OS = outs();
+  OS << "translation units: " << Commands.size() << " (" << NumFailed.load()
+     << " failed)\n";
+  OS << "units written: " << Stats.NumUnitsWritten.load() << '\n';
+  OS << "records written: " << Stats.NumRecordsWritten.load() << '\n';
+  OS << "records reused: " << Stats.NumRecordsReused.load() << '\n';
+  if (HeaderRegistry)
+    HeaderRegistry->printStats(OS);
+  OS << "time: " << format("%.3f", Elapsed.count()) << "s ("
+     << format("%.1f", Commands.size() / std::max(Elapsed.count(), 1e-9))
+     << " translation units/s)\n";
+  return NumFailed != 0;
+}
+
 //===----------------------------------------------------------------------===//
 // Helper Utils
 //===----------------------------------------------------------------------===//
@@ -360,5 +461,15 @@ int indextest_core_main(int argc, const char **argv) {
                               options::IncludeLocals);
   }
 
+  if (options::Action == ActionType::IndexCompileDB) {
+    if (options::CompileDBPath.empty() || options::IndexStorePath.empty()) {
+      errs() << "error: -index-compile-db requires -compile-db and "
+                "-index-store-path\n";
+      return 1;
+    }
+    return indexCompileDB(options::CompileDBPath, options::IndexStorePath,
+                          options::SkipIndexedHeaders, options::NumThreads);
+  }
+
   return 0;
 }
@@ -0,0 +1,111 @@
+//===- ClangCloneMerge.cpp - Find clones across translation units ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Clang tool which merges the clone fingerprints written by the CloneChecker
+// for many translation units and prints the clones in the whole code base.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Analysis/CloneDetection.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace clang;
+
+static cl::list<std::string>
+    InputPaths(cl::Positional, cl::OneOrMore,
+               cl::desc("<fingerprint file or directory> ..."));
+
+static cl::opt<bool> PrintStats(
+    "stats", cl::desc("Print the number of fingerprints and clone groups"));
+
+/// Adds \p Path to \p Files if it is a file, or all fingerprint files in it if
+/// it is a directory.
+static std::error_code collectFiles(StringRef Path,
+                                    std::vector<std::string> &Files) {
+  if (!sys::fs::is_directory(Path)) {
+    Files.push_back(Path);
+    return std::error_code();
+  }
+
+  std::error_code EC;
+  std::vector<std::string> DirectoryFiles;
+  for (sys::fs::directory_iterator I(Path, EC), E; I != E && !EC;
+       I.increment(EC)) {
+    if (sys::path::extension(I->path()) == ".clones")
+      DirectoryFiles.push_back(I->path());
+  }
+  // The order of the directory entries doesn't matter for the result, but
+  // sorting them makes the reading order reproducible.
+  llvm::sort(DirectoryFiles);
+  Files.insert(Files.end(), DirectoryFiles.begin(), DirectoryFiles.end());
+  return EC;
+}
+
+int main(int argc, const char **argv) {
+  // Print a stack trace if we signal out.
+  sys::PrintStackTraceOnErrorSignal(argv[0], false);
+  PrettyStackTraceProgram X(argc, argv);
+
+  const char *Overview =
+      "\nThis tool finds the code clones in the fingerprint files written by "
+      "the\nalpha.clone.CloneChecker with its FingerprintDirectory option.\n";
+  cl::ParseCommandLineOptions(argc, argv, Overview);
+
+  std::vector<std::string> Files;
+  for (const std::string &Path : InputPaths) {
+    if (std::error_code EC = collectFiles(Path, Files)) {
+      errs() << "error: cannot read '" << Path << "': " << EC.message() << '\n';
+      return 1;
+    }
+  }
+
+  std::vector<CloneFingerprint> Fingerprints;
+  for (const std::string &File : Files) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer = MemoryBuffer::getFile(File);
+    if (!Buffer) {
+      errs() << "error: cannot read '" << File
+             << "': " << Buffer.getError().message() << '\n';
+      return 1;
+    }
+    if (Error Err =
+            readCloneFingerprints((*Buffer)->getBuffer(), Fingerprints)) {
+      errs() << "error: " << File << ": " << toString(std::move(Err)) << '\n';
+      return 1;
+    }
+  }
+
+  size_t NumFingerprints = Fingerprints.size();
+  std::vector<std::vector<CloneFingerprint>> CloneGroups =
+      findClonesInFingerprints(std::move(Fingerprints));
+
+  for (unsigned I = 0; I < CloneGroups.size(); ++I) {
+    outs() << "clone group " << (I + 1) << " with " << CloneGroups[I].size()
+           << " clones:\n";
+    for (const CloneFingerprint &F : CloneGroups[I])
+      outs() << "  " << F.Filename << ':' << F.BeginLine << ':'
+             << F.BeginColumn << '-' << F.EndLine << ':' << F.EndColumn
+             << '\n';
+  }
+
+  if (PrintStats)
+    errs() << "files read: " << Files.size() << '\n'
+           << "fingerprints read: " << NumFingerprints << '\n'
+           << "clone groups: " << CloneGroups.size() << '\n';
+  return 0;
+}
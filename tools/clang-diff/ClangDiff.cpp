@@ -16,6 +16,8 @@
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Timer.h"
 
 using namespace llvm;
 using namespace clang;
@@ -58,6 +60,24 @@ static cl::opt<std::string> StopAfter("stop-diff-after",
 static cl::opt<int> MaxSize("s", cl::desc("<maxsize>"), cl::Optional,
                             cl::init(-1), cl::cat(ClangDiffCategory));
 
+static cl::opt<unsigned long long>
+    MaxMatrixSize("max-matrix-size",
+                  cl::desc("Skip the optimal matching of subtrees whose sizes "
+                           "multiply to more than this (0 = no limit)."),
+                  cl::Optional, cl::init(0), cl::cat(ClangDiffCategory));
+
+static cl::opt<bool> SubtreeHashes(
+    "subtree-hashes",
+    cl::desc("Find identical subtrees by their hashes during top-down "
+             "matching."),
+    cl::init(true), cl::cat(ClangDiffCategory));
+
+static cl::opt<bool>
+    PrintStats("stats",
+               cl::desc("Print the tree sizes, the number of matched and "
+                        "changed nodes and the matching time to stderr."),
+               cl::init(false), cl::cat(ClangDiffCategory));
+
 static cl::opt<std::string> BuildPath("p", cl::desc("Build path"), cl::init(""),
                                       cl::Optional, cl::cat(ClangDiffCategory));
 
@@ -441,6 +461,33 @@ static void printDstChange(raw_ostream &OS, diff::ASTDiff &Diff,
   }
 }
 
+static void printStats(raw_ostream &OS, diff::ASTDiff &Diff,
+                       diff::SyntaxTree &SrcTree, diff::SyntaxTree &DstTree,
+                       const TimeRecord &Elapsed) {
+  unsigned Matched = 0, Updated = 0, Moved = 0, Inserted = 0, Deleted = 0;
+  for (diff::NodeId Dst : DstTree) {
+    const diff::Node &DstNode = DstTree.getNode(Dst);
+    if (Diff.getMapped(DstTree, Dst).isValid())
+      ++Matched;
+    Updated += DstNode.Change == diff::Update ||
+               DstNode.Change == diff::UpdateMove;
+    Moved += DstNode.Change == diff::Move || DstNode.Change == diff::UpdateMove;
+    Inserted += DstNode.Change == diff::Insert;
+  }
+  for (diff::NodeId Src : SrcTree)
+    Deleted += Diff.getMapped(SrcTree, Src).isInvalid();
+
+  OS << "source nodes: " << SrcTree.getSize() << "\n";
+  OS << "destination nodes: " << DstTree.getSize() << "\n";
+  OS << "matched nodes: " << Matched << "\n";
+  OS << "updated nodes: " << Updated << "\n";
+  OS << "moved nodes: " << Moved << "\n";
+  OS << "inserted nodes: " << Inserted << "\n";
+  OS << "deleted nodes: " << Deleted << "\n";
+  OS << "matching time: ";
+  OS << format("%.4f", Elapsed.getWallTime()) << "s\n";
+}
+
 int main(int argc, const char **argv) {
   std::string ErrorMessage;
   std::unique_ptr<CompilationDatabase> CommonCompilations =
@@ -489,6 +536,8 @@ int main(int argc, const char **argv) {
   diff::ComparisonOptions Options;
   if (MaxSize != -1)
     Options.MaxSize = MaxSize;
+  Options.MaxMatrixSize = MaxMatrixSize;
+  Options.UseSubtreeHashes = SubtreeHashes;
   if (!StopAfter.empty()) {
     if (StopAfter == "topdown")
       Options.StopAfterTopDown = true;
@@ -499,7 +548,13 @@ int main(int argc, const char **argv) {
   }
   diff::SyntaxTree SrcTree(Src->getASTContext());
   diff::SyntaxTree DstTree(Dst->getASTContext());
+  TimeRecord StartTime = TimeRecord::getCurrentTime(/*Start=*/true);
   diff::ASTDiff Diff(SrcTree, DstTree, Options);
+  if (PrintStats) {
+    TimeRecord Elapsed = TimeRecord::getCurrentTime(/*Start=*/false);
+    Elapsed -= StartTime;
+    printStats(llvm::errs(), Diff, SrcTree, DstTree, Elapsed);
+  }
 
   if (HtmlDiff) {
     llvm::outs() << HtmlDiffHeader << "<pre>";
@@ -24,6 +24,8 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/Process.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 
 using namespace llvm;
 using clang::tooling::Replacements;
@@ -108,6 +110,14 @@ static cl::opt<bool>
     Verbose("verbose", cl::desc("If set, shows the list of processed files"),
             cl::cat(ClangFormatCategory));
 
+static cl::opt<unsigned>
+    NumThreads("j",
+               cl::desc("Number of files to format concurrently.\n"
+                        "-j=0 uses one thread per hardware core.\n"
+                        "Output and diagnostics are still reported in the\n"
+                        "order of the input files."),
+               cl::init(1), cl::cat(ClangFormatCategory));
+
 static cl::list<std::string> FileNames(cl::Positional, cl::desc("[<file> ...]"),
                                        cl::cat(ClangFormatCategory));
 
@@ -131,8 +141,9 @@ static bool parseLineRange(StringRef Input, unsigned &FromLine,
          LineRange.second.getAsInteger(0, ToLine);
 }
 
-static bool fillRanges(MemoryBuffer *Code,
-                       std::vector<tooling::Range> &Ranges) {
+// Errors are written to \p Err. Returns true on error.
+static bool fillRanges(MemoryBuffer *Code, std::vector<tooling::Range> &Ranges,
+                       raw_ostream &Err) {
   IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> InMemoryFileSystem(
       new llvm::vfs::InMemoryFileSystem);
   FileManager Files(FileSystemOptions(), InMemoryFileSystem);
@@ -144,18 +155,18 @@ static bool fillRanges(MemoryBuffer *Code,
                                  InMemoryFileSystem.get());
   if (!LineRanges.empty()) {
     if (!Offsets.empty() || !Lengths.empty()) {
-      errs() << "error: cannot use -lines with -offset/-length\n";
+      Err << "error: cannot use -lines with -offset/-length\n";
       return true;
     }
 
     for (unsigned i = 0, e = LineRanges.size(); i < e; ++i) {
       unsigned FromLine, ToLine;
       if (parseLineRange(LineRanges[i], FromLine, ToLine)) {
-        errs() << "error: invalid <start line>:<end line> pair\n";
+        Err << "error: invalid <start line>:<end line> pair\n";
         return true;
       }
       if (FromLine > ToLine) {
-        errs() << "error: start line should be less than end line\n";
+        Err << "error: start line should be less than end line\n";
         return true;
       }
       SourceLocation Start = Sources.translateLineCol(ID, FromLine, 1);
@@ -169,16 +180,20 @@ static bool fillRanges(MemoryBuffer *Code,
     return false;
   }
 
-  if (Offsets.empty())
-    Offsets.push_back(0);
   if (Offsets.size() != Lengths.size() &&
-      !(Offsets.size() == 1 && Lengths.empty())) {
-    errs() << "error: number of -offset and -length arguments must match.\n";
+      !(Offsets.size() <= 1 && Lengths.empty())) {
+    Err << "error: number of -offset and -length arguments must match.\n";
     return true;
   }
+  // Without -offset, format the whole file. Don't record this in Offsets, as
+  // files may be processed concurrently with -j.
+  if (Offsets.empty()) {
+    Ranges.push_back(tooling::Range(0, Code->getBufferSize()));
+    return false;
+  }
   for (unsigned i = 0, e = Offsets.size(); i != e; ++i) {
     if (Offsets[i] >= Code->getBufferSize()) {
-      errs() << "error: offset " << Offsets[i] << " is outside the file\n";
+      Err << "error: offset " << Offsets[i] << " is outside the file\n";
       return true;
     }
     SourceLocation Start =
@@ -186,7 +201,7 @@ static bool fillRanges(MemoryBuffer *Code,
     SourceLocation End;
     if (i < Lengths.size()) {
       if (Offsets[i] + Lengths[i] > Code->getBufferSize()) {
-        errs() << "error: invalid length " << Lengths[i]
+        Err << "error: invalid length " << Lengths[i]
                << ", offset + length (" << Offsets[i] + Lengths[i]
                << ") is outside the file.\n";
         return true;
@@ -202,48 +217,50 @@ static bool fillRanges(MemoryBuffer *Code,
   return false;
 }
 
-static void outputReplacementXML(StringRef Text) {
+static void outputReplacementXML(raw_ostream &OS, StringRef Text) {
   // FIXME: When we sort includes, we need to make sure the stream is correct
   // utf-8.
   size_t From = 0;
   size_t Index;
   while ((Index = Text.find_first_of("\n\r<&", From)) != StringRef::npos) {
-    outs() << Text.substr(From, Index - From);
+    OS << Text.substr(From, Index - From);
     switch (Text[Index]) {
     case '\n':
-      outs() << "&#10;";
+      OS << "&#10;";
       break;
     case '\r':
-      outs() << "&#13;";
+      OS << "&#13;";
       break;
     case '<':
-      outs() << "&lt;";
+      OS << "&lt;";
       break;
     case '&':
-      outs() << "&amp;";
+      OS << "&amp;";
       break;
     default:
       llvm_unreachable("Unexpected character encountered!");
     }
     From = Index + 1;
   }
-  outs() << Text.substr(From);
+  OS << Text.substr(From);
 }
 
-static void outputReplacementsXML(const Replacements &Replaces) {
+static void outputReplacementsXML(raw_ostream &OS,
+                                  const Replacements &Replaces) {
   for (const auto &R : Replaces) {
-    outs() << "<replacement "
+    OS << "<replacement "
            << "offset='" << R.getOffset() << "' "
            << "length='" << R.getLength() << "'>";
-    outputReplacementXML(R.getReplacementText());
-    outs() << "</replacement>\n";
+    outputReplacementXML(OS, R.getReplacementText());
+    OS << "</replacement>\n";
   }
 }
 
+// Formats \p FileName, writing the result to \p OS and any errors to \p Err.
 // Returns true on error.
-static bool format(StringRef FileName) {
+static bool format(StringRef FileName, raw_ostream &OS, raw_ostream &Err) {
   if (!OutputXML && Inplace && FileName == "-") {
-    errs() << "error: cannot use -i when reading from stdin.\n";
+    Err << "error: cannot use -i when reading from stdin.\n";
     return false;
   }
   // On Windows, overwriting a file with an open file mapping doesn't work,
@@ -252,21 +269,21 @@ static bool format(StringRef FileName) {
       !OutputXML && Inplace ? MemoryBuffer::getFileAsStream(FileName) :
                               MemoryBuffer::getFileOrSTDIN(FileName);
   if (std::error_code EC = CodeOrErr.getError()) {
-    errs() << EC.message() << "\n";
+    Err << EC.message() << "\n";
     return true;
   }
   std::unique_ptr<llvm::MemoryBuffer> Code = std::move(CodeOrErr.get());
   if (Code->getBufferSize() == 0)
     return false; // Empty files are formatted correctly.
   std::vector<tooling::Range> Ranges;
-  if (fillRanges(Code.get(), Ranges))
+  if (fillRanges(Code.get(), Ranges, Err))
     return true;
   StringRef AssumedFileName = (FileName == "-") ? AssumeFileName : FileName;
 
   llvm::Expected<FormatStyle> FormatStyle =
       getStyle(Style, AssumedFileName, FallbackStyle, Code->getBuffer());
   if (!FormatStyle) {
-    llvm::errs() << llvm::toString(FormatStyle.takeError()) << "\n";
+    Err << llvm::toString(FormatStyle.takeError()) << "\n";
     return true;
   }
 
@@ -277,7 +294,7 @@ static bool format(StringRef FileName) {
                                        AssumedFileName, &CursorPosition);
   auto ChangedCode = tooling::applyAllReplacements(Code->getBuffer(), Replaces);
   if (!ChangedCode) {
-    llvm::errs() << llvm::toString(ChangedCode.takeError()) << "\n";
+    Err << llvm::toString(ChangedCode.takeError()) << "\n";
     return true;
   }
   // Get new affected ranges after sorting `#includes`.
@@ -287,19 +304,18 @@ static bool format(StringRef FileName) {
                                         AssumedFileName, &Status);
   Replaces = Replaces.merge(FormatChanges);
   if (OutputXML) {
-    outs() << "<?xml version='1.0'?>\n<replacements "
-              "xml:space='preserve' incomplete_format='"
-           << (Status.FormatComplete ? "false" : "true") << "'";
+    OS << "<?xml version='1.0'?>\n<replacements "
+          "xml:space='preserve' incomplete_format='"
+       << (Status.FormatComplete ? "false" : "true") << "'";
     if (!Status.FormatComplete)
-      outs() << " line='" << Status.Line << "'";
-    outs() << ">\n";
+      OS << " line='" << Status.Line << "'";
+    OS << ">\n";
     if (Cursor.getNumOccurrences() != 0)
-      outs() << "<cursor>"
-             << FormatChanges.getShiftedCodePosition(CursorPosition)
-             << "</cursor>\n";
+      OS << "<cursor>" << FormatChanges.getShiftedCodePosition(CursorPosition)
+         << "</cursor>\n";
 
-    outputReplacementsXML(Replaces);
-    outs() << "</replacements>\n";
+    outputReplacementsXML(OS, Replaces);
+    OS << "</replacements>\n";
   } else {
     IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> InMemoryFileSystem(
         new llvm::vfs::InMemoryFileSystem);
@@ -317,15 +333,15 @@ static bool format(StringRef FileName) {
         return true;
     } else {
       if (Cursor.getNumOccurrences() != 0) {
-        outs() << "{ \"Cursor\": "
-               << FormatChanges.getShiftedCodePosition(CursorPosition)
-               << ", \"IncompleteFormat\": "
-               << (Status.FormatComplete ? "false" : "true");
+        OS << "{ \"Cursor\": "
+           << FormatChanges.getShiftedCodePosition(CursorPosition)
+           << ", \"IncompleteFormat\": "
+           << (Status.FormatComplete ? "false" : "true");
         if (!Status.FormatComplete)
-          outs() << ", \"Line\": " << Status.Line;
-        outs() << " }\n";
+          OS << ", \"Line\": " << Status.Line;
+        OS << " }\n";
       }
-      Rewrite.getEditBuffer(ID).write(outs());
+      Rewrite.getEditBuffer(ID).write(OS);
     }
   }
   return false;
@@ -391,7 +407,7 @@ int main(int argc, const char **argv) {
 
   bool Error = false;
   if (FileNames.empty()) {
-    Error = clang::format::format("-");
+    Error = clang::format::format("-", outs(), errs());
     return Error ? 1 : 0;
   }
   if (FileNames.size() != 1 && (!Offsets.empty() || !Lengths.empty() || !LineRanges.empty())) {
@@ -399,10 +415,38 @@ int main(int argc, const char **argv) {
               "single file.\n";
     return 1;
   }
-  for (const auto &FileName : FileNames) {
+  if (NumThreads == 1 || FileNames.size() == 1) {
+    for (const auto &FileName : FileNames) {
+      if (Verbose)
+        errs() << "Formatting " << FileName << "\n";
+      Error |= clang::format::format(FileName, outs(), errs());
+    }
+    return Error ? 1 : 0;
+  }
+
+  // Format the files concurrently, buffering the output and errors for each
+  // file so that they are written in the order the files were given.
+  std::vector<std::string> Outputs(FileNames.size());
+  std::vector<std::string> Errors(FileNames.size());
+  std::vector<char> Failed(FileNames.size());
+  {
+    ThreadPool Pool(NumThreads ? NumThreads
+                               : llvm::heavyweight_hardware_concurrency());
+    for (unsigned I = 0, E = FileNames.size(); I != E; ++I) {
+      Pool.async([&, I] {
+        raw_string_ostream OS(Outputs[I]);
+        raw_string_ostream Err(Errors[I]);
+        Failed[I] = clang::format::format(FileNames[I], OS, Err);
+      });
+    }
+    Pool.wait();
+  }
+  for (unsigned I = 0, E = FileNames.size(); I != E; ++I) {
     if (Verbose)
-      errs() << "Formatting " << FileName << "\n";
-    Error |= clang::format::format(FileName);
+      errs() << "Formatting " << FileNames[I] << "\n";
+    errs() << Errors[I];
+    outs() << Outputs[I];
+    Error |= Failed[I];
   }
   return Error ? 1 : 0;
 }
@@ -46,6 +46,13 @@ static cl::opt<bool> Inplace("i", cl::desc("Inplace edit <file>s"),
                              cl::cat(cl::GeneralCategory),
                              cl::sub(*cl::AllSubCommands));
 
+static cl::opt<unsigned>
+    NumThreads("j",
+               cl::desc("Number of threads used to apply the changes to the "
+                        "files (0 = number of hardware threads)"),
+               cl::init(0), cl::cat(cl::GeneralCategory),
+               cl::sub(*cl::AllSubCommands));
+
 } // end namespace opts
 
 namespace {
@@ -472,42 +479,31 @@ public:
         [this](ASTContext &AST) { return callback(AST); });
   }
 
-  // FIXME(ioeric): this seems to only works for changes in a single file at
-  // this point.
   bool applySourceChanges() {
-    std::set<std::string> Files;
-    for (const auto &Change : Changes)
-      Files.insert(Change.getFilePath());
     // FIXME: Add automatic formatting support as well.
     tooling::ApplyChangesSpec Spec;
     // FIXME: We should probably cleanup the result by default as well.
     Spec.Cleanup = false;
-    for (const auto &File : Files) {
-      llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> BufferErr =
-          llvm::MemoryBuffer::getFile(File);
-      if (!BufferErr) {
-        llvm::errs() << "error: failed to open " << File << " for rewriting\n";
-        return true;
-      }
-      auto Result = tooling::applyAtomicChanges(File, (*BufferErr)->getBuffer(),
-                                                Changes, Spec);
-      if (!Result) {
-        llvm::errs() << toString(Result.takeError());
-        return true;
-      }
+    auto ChangedFiles = tooling::applyAtomicChangesInFiles(
+        Changes, *llvm::vfs::getRealFileSystem(), Spec, opts::NumThreads);
+    if (!ChangedFiles) {
+      llvm::errs() << toString(ChangedFiles.takeError()) << "\n";
+      return true;
+    }
 
+    for (const auto &File : *ChangedFiles) {
       if (opts::Inplace) {
         std::error_code EC;
-        llvm::raw_fd_ostream OS(File, EC, llvm::sys::fs::F_Text);
+        llvm::raw_fd_ostream OS(File.first, EC, llvm::sys::fs::F_Text);
         if (EC) {
           llvm::errs() << EC.message() << "\n";
           return true;
         }
-        OS << *Result;
+        OS << File.second;
         continue;
       }
 
-      llvm::outs() << *Result;
+      llvm::outs() << File.second;
     }
     return false;
   }
@@ -3494,7 +3494,10 @@ clang_parseTranslationUnit_Impl(CXIndex CIdx, const char *source_filename,
       /*AllowPCHWithCompilerErrors=*/true, SkipFunctionBodies, SingleFileParse,
       /*UserFilesAreVolatile=*/true, ForSerialization,
       CXXIdx->getPCHContainerOperations()->getRawReader().getFormat(),
-      &ErrUnit));
+      &ErrUnit, /*VFS=*/nullptr,
+      CXXIdx->isOptEnabled(CXGlobalOpt_SharePreambles)
+          ? CXXIdx->getPreambleCache()
+          : nullptr));
 
   // Early failures in LoadFromCommandLine may return with ErrUnit unset.
   if (!Unit && !ErrUnit)
@@ -8487,6 +8490,9 @@ const char *clang_getTUResourceUsageName(CXTUResourceUsageKind kind) {
     case CXTUResourceUsage_Preprocessor_HeaderSearch:
       str = "Preprocessor: header search tables";
       break;
+    case CXTUResourceUsage_PreambleShareCount:
+      str = "Preamble: translation units sharing the preamble";
+      break;
   }
   return str;
 }
@@ -8577,6 +8583,13 @@ CXTUResourceUsage clang_getCXTUResourceUsage(CXTranslationUnit TU) {
                                CXTUResourceUsage_Preprocessor_HeaderSearch,
                                pp.getHeaderSearchInfo().getTotalMemory());
 
+  // How many translation units share the precompiled preamble?  Its memory
+  // is already counted as a memory-mapped buffer of the AST source.
+  if (unsigned shareCount = astUnit->getPreambleShareCount())
+    createCXTUResourceUsageEntry(*entries,
+                                 CXTUResourceUsage_PreambleShareCount,
+                                 shareCount);
+
   CXTUResourceUsage usage = { (void*) entries.get(),
                             (unsigned) entries->size(),
                             !entries->empty() ? &(*entries)[0] : nullptr };
@@ -698,6 +698,7 @@ clang_codeCompleteAt_Impl(CXTranslationUnit TU, const char *complete_filename,
   bool IncludeBriefComments = options & CXCodeComplete_IncludeBriefComments;
   bool SkipPreamble = options & CXCodeComplete_SkipPreamble;
   bool IncludeFixIts = options & CXCodeComplete_IncludeCompletionsWithFixIts;
+  bool FilterByTypedPrefix = options & CXCodeComplete_FilterByTypedPrefix;
 
 #ifdef UDP_CODE_COMPLETION_LOGGER
 #ifdef UDP_CODE_COMPLETION_LOGGER_PORT
@@ -745,6 +746,7 @@ clang_codeCompleteAt_Impl(CXTranslationUnit TU, const char *complete_filename,
   Opts.IncludeBriefComments = IncludeBriefComments;
   Opts.LoadExternal = !SkipPreamble;
   Opts.IncludeFixIts = IncludeFixIts;
+  Opts.FilterByTypedPrefix = FilterByTypedPrefix;
   CaptureCompletionResults Capture(Opts, *Results, &TU);
 
   // Perform completion.
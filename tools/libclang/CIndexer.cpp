@@ -15,6 +15,7 @@
 #include "CXString.h"
 #include "clang/Basic/LLVM.h"
 #include "clang/Basic/Version.h"
+#include "clang/Frontend/ASTUnit.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/MD5.h"
@@ -38,6 +39,13 @@
 
 using namespace clang;
 
+CIndexer::CIndexer(std::shared_ptr<PCHContainerOperations> PCHContainerOps)
+    : OnlyLocalDecls(false), DisplayDiagnostics(false),
+      Options(CXGlobalOpt_None), PCHContainerOps(std::move(PCHContainerOps)),
+      PreambleCache(std::make_shared<SharedPreambleCache>()) {}
+
+CIndexer::~CIndexer() = default;
+
 const std::string &CIndexer::getClangResourcesPath() {
   // Did we already compute the path?
   if (!ResourcesPath.empty())
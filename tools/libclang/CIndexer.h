@@ -28,6 +28,7 @@ namespace llvm {
 namespace clang {
 class ASTUnit;
 class MacroInfo;
+class SharedPreambleCache;
 class MacroDefinitionRecord;
 class SourceLocation;
 class Token;
@@ -45,12 +46,13 @@ class CIndexer {
 
   std::string InvocationEmissionPath;
 
+  /// Precompiled preambles shared by the translation units of this index.
+  std::shared_ptr<SharedPreambleCache> PreambleCache;
+
 public:
   CIndexer(std::shared_ptr<PCHContainerOperations> PCHContainerOps =
-               std::make_shared<PCHContainerOperations>())
-      : OnlyLocalDecls(false), DisplayDiagnostics(false),
-        Options(CXGlobalOpt_None), PCHContainerOps(std::move(PCHContainerOps)) {
-  }
+               std::make_shared<PCHContainerOperations>());
+  ~CIndexer();
 
   /// Whether we only want to see "local" declarations (that did not
   /// come from a previous precompiled header). If false, we want to see all
@@ -67,6 +69,10 @@ public:
     return PCHContainerOps;
   }
 
+  std::shared_ptr<SharedPreambleCache> getPreambleCache() const {
+    return PreambleCache;
+  }
+
   unsigned getCXGlobalOptFlags() const { return Options; }
   void setCXGlobalOptFlags(unsigned options) { Options = options; }
 
@@ -21,6 +21,7 @@
 #include "clang/Frontend/CompilerInvocation.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/Utils.h"
+#include "clang/Index/IndexedHeaderRegistry.h"
 #include "clang/Index/IndexingAction.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/PPCallbacks.h"
@@ -410,9 +411,11 @@ static IndexingOptions getIndexingOptionsFromCXOptions(unsigned index_options) {
 struct IndexSessionData {
   CXIndex CIdx;
   std::unique_ptr<SessionSkipBodyData> SkipBodyData;
+  std::shared_ptr<IndexedHeaderRegistry> HeaderRegistry;
 
   explicit IndexSessionData(CXIndex cIdx)
-    : CIdx(cIdx), SkipBodyData(new SessionSkipBodyData) {}
+    : CIdx(cIdx), SkipBodyData(new SessionSkipBodyData),
+      HeaderRegistry(std::make_shared<IndexedHeaderRegistry>()) {}
 };
 
 } // anonymous namespace
@@ -550,9 +553,11 @@ static CXErrorCode clang_indexSourceFile_Impl(
                                           CXTU->getTU());
   auto InterAction = llvm::make_unique<IndexingFrontendAction>(DataConsumer,
                          SkipBodies ? IdxSession->SkipBodyData.get() : nullptr);
+  IndexingOptions IdxOpts = getIndexingOptionsFromCXOptions(index_options);
+  if (index_options & CXIndexOpt_SkipIndexedHeadersInSession)
+    IdxOpts.HeaderRegistry = IdxSession->HeaderRegistry;
   std::unique_ptr<FrontendAction> IndexAction;
-  IndexAction = createIndexingAction(DataConsumer,
-                                getIndexingOptionsFromCXOptions(index_options),
+  IndexAction = createIndexingAction(DataConsumer, IdxOpts,
                                      std::move(InterAction));
 
   // Recover resources if we crash before exiting this method.
@@ -10,6 +10,7 @@
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/Analysis/CloneDetection.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 namespace clang {
@@ -107,6 +108,71 @@ TEST(CloneDetector, FilterFunctionsByName) {
   // We should have found the two functions bar1 and bar2.
   ASSERT_EQ(FoundFunctionsWithBarPrefix, 2);
 }
+
+TEST(CloneDetector, FindClonesInFingerprints) {
+  // Both translation units start with foo1, like code in a shared header,
+  // which must only be reported once. foo3 references its variables in a
+  // different pattern.
+  const char *Header = "void foo1(int &a, int &b) { a++; b--; a += b; }\n";
+  std::vector<CloneFingerprint> AllFingerprints;
+  const char *Codes[] = {"void foo2(int &c, int &d) { c++; d--; c += d; }\n",
+                         "void foo3(int &e, int &f) { e++; f--; f += e; }\n"};
+  for (const char *Code : Codes) {
+    auto ASTUnit = clang::tooling::buildASTFromCode(std::string(Header) + Code);
+    CloneDetector Detector;
+    CloneDetectionVisitor Visitor(Detector);
+    Visitor.TraverseTranslationUnitDecl(
+        ASTUnit->getASTContext().getTranslationUnitDecl());
+
+    std::vector<CloneFingerprint> Fingerprints;
+    Detector.collectFingerprints(Fingerprints, 8);
+    ASSERT_FALSE(Fingerprints.empty());
+
+    // The fingerprints must survive a round trip through the file format.
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+    writeCloneFingerprints(Fingerprints, OS);
+    ASSERT_FALSE(
+        llvm::errorToBool(readCloneFingerprints(OS.str(), AllFingerprints)));
+  }
+
+  std::vector<std::vector<CloneFingerprint>> CloneGroups =
+      findClonesInFingerprints(AllFingerprints);
+  ASSERT_EQ(CloneGroups.size(), 1u);
+  ASSERT_EQ(CloneGroups.front().size(), 2u);
+  EXPECT_EQ(CloneGroups.front()[0].BeginLine, 1u);
+  EXPECT_EQ(CloneGroups.front()[1].BeginLine, 2u);
+  for (const CloneFingerprint &F : CloneGroups.front())
+    EXPECT_EQ(F.BeginColumn, 27u);
+
+  std::vector<CloneFingerprint> Malformed;
+  EXPECT_TRUE(llvm::errorToBool(readCloneFingerprints(
+      "clone-fingerprints\nfile a.cpp\n0123 0 1:1 1:2\n", Malformed)));
+}
+
+TEST(CloneDetector, FingerprintsIgnoreLineDirectives) {
+  // The #line directive gives foo2 the presumed location of foo1 in the other
+  // translation unit, which must not make the two look like the same code.
+  const char *Codes[] = {"void foo1(int &a, int &b) { a++; b--; a += b; }\n",
+                         "\n#line 1\n"
+                         "void foo2(int &c, int &d) { c++; d--; c += d; }\n"};
+  std::vector<CloneFingerprint> AllFingerprints;
+  for (const char *Code : Codes) {
+    auto ASTUnit = clang::tooling::buildASTFromCode(Code);
+    CloneDetector Detector;
+    CloneDetectionVisitor Visitor(Detector);
+    Visitor.TraverseTranslationUnitDecl(
+        ASTUnit->getASTContext().getTranslationUnitDecl());
+    Detector.collectFingerprints(AllFingerprints, 8);
+  }
+
+  std::vector<std::vector<CloneFingerprint>> CloneGroups =
+      findClonesInFingerprints(AllFingerprints);
+  ASSERT_EQ(CloneGroups.size(), 1u);
+  ASSERT_EQ(CloneGroups.front().size(), 2u);
+  EXPECT_EQ(CloneGroups.front()[0].BeginLine, 1u);
+  EXPECT_EQ(CloneGroups.front()[1].BeginLine, 3u);
+}
 } // namespace
 } // namespace analysis
 } // namespace clang
@@ -51,6 +51,7 @@ protected:
           << Code << "\n\n";
     }
     ReplacementCount = Replaces.size();
+    ReusedLineSolutionCount = Status.NumReusedLineSolutions;
     auto Result = applyAllReplacements(Code, Replaces);
     EXPECT_TRUE(static_cast<bool>(Result));
     LLVM_DEBUG(llvm::errs() << "\n" << *Result << "\n\n");
@@ -111,6 +112,7 @@ protected:
   }
 
   int ReplacementCount;
+  unsigned ReusedLineSolutionCount;
 };
 
 TEST_F(FormatTest, MessUp) {
@@ -4401,6 +4403,60 @@ TEST_F(FormatTest, BreaksDesireably) {
       "                             NSTrackingActiveAlways;");
 }
 
+TEST_F(FormatTest, ReusesSolutionsOfIdenticalLines) {
+  FormatStyle Style = getLLVMStyleWithColumns(40);
+  // The second call is an exact repetition of the first one and reuses its
+  // line breaks. The third one starts at a different column and must be
+  // formatted on its own.
+  StringRef Code = "void f() {\n"
+                   "  someFunction(aaaaaaaaaaa, bbbbbbbbbbb,\n"
+                   "               ccccccccccc);\n"
+                   "  someFunction(aaaaaaaaaaa, bbbbbbbbbbb,\n"
+                   "               ccccccccccc);\n"
+                   "  if (x) {\n"
+                   "    someFunction(aaaaaaaaaaa,\n"
+                   "                 bbbbbbbbbbb,\n"
+                   "                 ccccccccccc);\n"
+                   "  }\n"
+                   "}";
+  verifyFormat(Code, Style);
+  EXPECT_EQ(Code.str(), format(Code, Style));
+  EXPECT_EQ(1u, ReusedLineSolutionCount);
+
+  // Lines that differ in a single token are searched separately.
+  StringRef Distinct = "void f() {\n"
+                       "  someFunction(aaaaaaaaaaa, bbbbbbbbbbb,\n"
+                       "               ccccccccccc);\n"
+                       "  someFunction(aaaaaaaaaaa, bbbbbbbbbbb,\n"
+                       "               ddddddddddd);\n"
+                       "}";
+  EXPECT_EQ(Distinct.str(), format(Distinct, Style));
+  EXPECT_EQ(0u, ReusedLineSolutionCount);
+}
+
+TEST_F(FormatTest, LimitsLineBreakSearchBeamWidth) {
+  FormatStyle Style = getLLVMStyleWithColumns(40);
+  Style.LineBreakSearchBeamWidth = 1;
+  verifyFormat("int a = b + c;", Style);
+  verifyFormat("aaaaaaaaaaaaaaaaa(bbbbbbbbbbbbbbbb,\n"
+               "                  cccccccccccccccc);",
+               Style);
+
+  // Even with a narrow beam, lines with many break opportunities are broken
+  // within the column limit.
+  Style.LineBreakSearchBeamWidth = 4;
+  std::string Code = "f(";
+  for (unsigned i = 0; i < 100; ++i)
+    Code += "g(aaaa, bbbb), ";
+  Code += "h());";
+  std::string Result = format(Code, Style);
+  SmallVector<StringRef, 64> Lines;
+  StringRef(Result).split(Lines, '\n');
+  EXPECT_LT(1u, Lines.size());
+  for (StringRef Line : Lines)
+    EXPECT_GE(40u, Line.size()) << Line;
+}
+
 TEST_F(FormatTest, FormatsDeclarationsOnePerLine) {
   FormatStyle NoBinPacking = getGoogleStyle();
   NoBinPacking.BinPackParameters = false;
@@ -10925,6 +10981,8 @@ TEST_F(FormatTest, ParsesConfiguration) {
   CHECK_PARSE("ObjCBlockIndentWidth: 1234", ObjCBlockIndentWidth, 1234u);
   CHECK_PARSE("ColumnLimit: 1234", ColumnLimit, 1234u);
   CHECK_PARSE("MaxEmptyLinesToKeep: 1234", MaxEmptyLinesToKeep, 1234u);
+  CHECK_PARSE("LineBreakSearchBeamWidth: 1234", LineBreakSearchBeamWidth,
+              1234u);
   CHECK_PARSE("PenaltyBreakAssignment: 1234",
               PenaltyBreakAssignment, 1234u);
   CHECK_PARSE("PenaltyBreakBeforeFirstCallParameter: 1234",
@@ -9,6 +9,9 @@
 
 #include "clang/Rewrite/Core/RewriteBuffer.h"
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <string>
+#include <vector>
 
 using namespace llvm;
 using namespace clang;
@@ -48,4 +51,56 @@ TEST(RewriteBuffer, TagRanges) {
   EXPECT_EQ(Output, Result);
 }
 
+TEST(RewriteBuffer, ApplyEditsMatchesReplaceText) {
+  std::string Input;
+  for (unsigned I = 0; I != 1000; ++I)
+    Input += "line" + std::to_string(I) + "\n";
+
+  // Replace, remove and insert text all over the buffer, including at the
+  // same offset and at the very end.
+  std::vector<std::string> Texts;
+  for (unsigned I = 0; I != 300; ++I)
+    Texts.push_back(I % 3 == 0 ? "" : "<" + std::to_string(I) + ">");
+  std::vector<RewriteBuffer::Edit> Edits;
+  for (unsigned I = 0; I != 300; ++I) {
+    unsigned Offset = I * (Input.size() / 300);
+    unsigned Length = I % 4 == 0 ? 0 : 3;
+    Edits.push_back(RewriteBuffer::Edit{Offset, Length, Texts[I]});
+    if (I % 10 == 0)
+      Edits.push_back(RewriteBuffer::Edit{Offset, 0, "+"});
+  }
+  Edits.push_back(RewriteBuffer::Edit{unsigned(Input.size()), 0, "end"});
+
+  RewriteBuffer Expected;
+  Expected.Initialize(Input);
+  for (auto I = Edits.rbegin(), E = Edits.rend(); I != E; ++I)
+    Expected.ReplaceText(I->OrigOffset, I->OrigLength, I->NewText);
+
+  RewriteBuffer Buf;
+  Buf.Initialize(Input);
+  // Apply the edits out of order; ApplyEdits sorts them.
+  std::reverse(Edits.begin(), Edits.end());
+  std::stable_sort(Edits.begin(), Edits.end(),
+                   [](const RewriteBuffer::Edit &LHS,
+                      const RewriteBuffer::Edit &RHS) {
+                     return LHS.OrigLength > RHS.OrigLength;
+                   });
+  Buf.ApplyEdits(Edits);
+
+  std::string ExpectedResult, Result;
+  raw_string_ostream ExpectedOS(ExpectedResult), OS(Result);
+  Expected.write(ExpectedOS);
+  Buf.write(OS);
+  EXPECT_EQ(ExpectedOS.str(), OS.str());
+
+  // Later edits are still mapped through the batch.
+  Expected.InsertTextAfter(Input.find("line500"), "!");
+  Buf.InsertTextAfter(Input.find("line500"), "!");
+  ExpectedResult.clear();
+  Result.clear();
+  Expected.write(ExpectedOS);
+  Buf.write(OS);
+  EXPECT_EQ(ExpectedOS.str(), OS.str());
+}
+
 } // anonymous namespace
@@ -13,7 +13,9 @@
 #include "clang/Tooling/FileMatchTrie.h"
 #include "clang/Tooling/JSONCompilationDatabase.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 namespace clang {
@@ -195,6 +197,111 @@ TEST(JSONCompilationDatabase, ArgumentsPreferredOverCommand) {
    EXPECT_EQ(Arguments, FoundCommand.CommandLine[0]) << ErrorMessage;
 }
 
+TEST(JSONCompilationDatabase, DecodesEscapedStringsAndSkipsComments) {
+  std::string ErrorMessage;
+  std::vector<CompileCommand> Commands = getAllCompileCommands(
+      JSONCommandLineSyntax::Gnu,
+      "[{\"directory\":\"//net/dir\",\n"
+      "  \"arguments\":[\"a\\\\b\", \"\\u00e9\\ud83d\\ude00\\/\"],\n"
+      "  \"file\":\"file\\tname\"}]\n"
+      "# A trailing comment.\n",
+      ErrorMessage);
+  ASSERT_EQ(1u, Commands.size()) << ErrorMessage;
+  EXPECT_EQ("file\tname", Commands[0].Filename);
+  ASSERT_EQ(2u, Commands[0].CommandLine.size());
+  EXPECT_EQ("a\\b", Commands[0].CommandLine[0]);
+  EXPECT_EQ("\xc3\xa9\xf0\x9f\x98\x80/", Commands[0].CommandLine[1]);
+}
+
+TEST(JSONCompilationDatabase, SingleArgumentIsCommandLine) {
+  std::string ErrorMessage;
+  std::vector<CompileCommand> Commands = getAllCompileCommands(
+      JSONCommandLineSyntax::Gnu,
+      "[{\"directory\":\"//net/dir\",\"arguments\":[\"cc -c file\"],"
+      "\"file\":\"file\"}]",
+      ErrorMessage);
+  ASSERT_EQ(1u, Commands.size()) << ErrorMessage;
+  std::vector<std::string> Expected = {"cc", "-c", "file"};
+  EXPECT_EQ(Expected, Commands[0].CommandLine);
+}
+
+TEST(JSONCompilationDatabase, AcceptsYAML) {
+  std::string ErrorMessage;
+  std::vector<CompileCommand> Commands = getAllCompileCommands(
+      JSONCommandLineSyntax::Gnu,
+      "- directory: //net/dir\n"
+      "  arguments: [cc, 'a\"b', \"c\\\\d\"]\n"
+      "  file: file\n",
+      ErrorMessage);
+  ASSERT_EQ(1u, Commands.size()) << ErrorMessage;
+  EXPECT_EQ("//net/dir", Commands[0].Directory);
+  EXPECT_EQ("file", Commands[0].Filename);
+  std::vector<std::string> Expected = {"cc", "a\"b", "c\\d"};
+  EXPECT_EQ(Expected, Commands[0].CommandLine);
+}
+
+TEST(JSONCompilationDatabase, LoadsFromIndex) {
+  SmallString<128> DatabasePath;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("compile_commands", "json",
+                                                  DatabasePath));
+  std::string IndexPath = (DatabasePath + ".index").str();
+  auto WriteDatabase = [&](StringRef Contents) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(DatabasePath, EC, llvm::sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    OS << Contents;
+  };
+  bool LoadedFromIndex = false;
+  auto GetCommandLines = [&]() {
+    std::string ErrorMessage;
+    std::vector<std::vector<std::string>> CommandLines;
+    std::unique_ptr<JSONCompilationDatabase> Database =
+        JSONCompilationDatabase::loadFromFile(DatabasePath, ErrorMessage,
+                                              JSONCommandLineSyntax::Gnu,
+                                              IndexPath);
+    EXPECT_TRUE(Database) << ErrorMessage;
+    LoadedFromIndex = Database && Database->isLoadedFromIndex();
+    if (Database)
+      for (const CompileCommand &Command :
+           Database->getCompileCommands("//net/dir/file"))
+        CommandLines.push_back(Command.CommandLine);
+    return CommandLines;
+  };
+
+  WriteDatabase("[{\"directory\":\"//net/dir\",\"command\":\"cc -c file\","
+                "\"file\":\"file\"},"
+                "{\"directory\":\"//net/dir\",\"arguments\":[\"cc\",\"x\"],"
+                "\"file\":\"//net/dir/other\"}]");
+  std::vector<std::vector<std::string>> Expected = {{"cc", "-c", "file"}};
+  EXPECT_EQ(Expected, GetCommandLines());
+  EXPECT_FALSE(LoadedFromIndex);
+  EXPECT_TRUE(llvm::sys::fs::exists(IndexPath));
+
+  // The second load reads the index.
+  EXPECT_EQ(Expected, GetCommandLines());
+  EXPECT_TRUE(LoadedFromIndex);
+
+  // The index is stale once the contents of the database change, even if its
+  // size stays the same.
+  WriteDatabase("[{\"directory\":\"//net/dir\",\"command\":\"cc -S file\","
+                "\"file\":\"file\"},"
+                "{\"directory\":\"//net/dir\",\"arguments\":[\"cc\",\"x\"],"
+                "\"file\":\"//net/dir/other\"}]");
+  Expected = {{"cc", "-S", "file"}};
+  EXPECT_EQ(Expected, GetCommandLines());
+  EXPECT_FALSE(LoadedFromIndex);
+
+  // Databases that are only valid as YAML are not indexed.
+  llvm::sys::fs::remove(IndexPath);
+  WriteDatabase("- {directory: //net/dir, command: cc file, file: file}\n");
+  Expected = {{"cc", "file"}};
+  EXPECT_EQ(Expected, GetCommandLines());
+  EXPECT_FALSE(llvm::sys::fs::exists(IndexPath));
+
+  llvm::sys::fs::remove(DatabasePath);
+  llvm::sys::fs::remove(IndexPath);
+}
+
 struct FakeComparator : public PathComparator {
   ~FakeComparator() override {}
   bool equivalent(StringRef FileA, StringRef FileB) const override {
@@ -30,6 +30,7 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include "gtest/gtest.h"
+#include <climits>
 
 namespace clang {
 namespace tooling {
@@ -465,6 +466,66 @@ TEST_F(ReplacementTest, AdjacentReplacements) {
   EXPECT_EQ("xy", Context.getRewrittenText(ID));
 }
 
+TEST_F(ReplacementTest, ApplyReplacementsToStream) {
+  std::string Code = "line1\nline2\nline3\nline4";
+  Replacements Replaces =
+      toReplacements({Replacement("input.cpp", 6, 5, "replaced"),
+                      Replacement("input.cpp", 12, 0, "inserted\n"),
+                      Replacement("input.cpp", 18, 5, "")});
+  std::string Result;
+  llvm::raw_string_ostream OS(Result);
+  EXPECT_FALSE(llvm::errorToBool(applyAllReplacements(Code, Replaces, OS)));
+  EXPECT_EQ("line1\nreplaced\ninserted\nline3\n", OS.str());
+
+  Replacements OutOfBounds =
+      toReplacements({Replacement("input.cpp", 30, 1, "x")});
+  EXPECT_TRUE(llvm::errorToBool(applyAllReplacements(Code, OutOfBounds, OS)));
+}
+
+TEST(ReplacementsTest, AddAllMatchesAdd) {
+  std::vector<Replacement> Rs;
+  for (unsigned I = 0; I != 100; ++I) {
+    unsigned Offset = ((I * 37) % 100) * 5;
+    Rs.emplace_back("x.h", Offset, I % 3, I % 2 ? "a" : "");
+    // Overlapping deletions and duplicate insertions are merged.
+    if (I % 10 == 0) {
+      Rs.emplace_back("x.h", Offset, I % 3 + 1, "");
+      Rs.emplace_back("x.h", Offset, 0, "b");
+      Rs.emplace_back("x.h", Offset, 0, "b");
+    }
+  }
+  Rs.emplace_back("x.h", UINT_MAX, 0, "#include \"y.h\"");
+  std::vector<Replacement> Sorted(Rs);
+  llvm::sort(Sorted);
+
+  Replacements Expected;
+  for (const Replacement &R : Sorted) {
+    auto Err = Expected.add(R);
+    EXPECT_TRUE(!Err);
+    llvm::consumeError(std::move(Err));
+  }
+  Replacements Replaces;
+  auto Err = Replaces.addAll(Rs);
+  EXPECT_TRUE(!Err);
+  llvm::consumeError(std::move(Err));
+  EXPECT_EQ(Expected, Replaces);
+}
+
+TEST(ReplacementsTest, AddAllFailsOnConflict) {
+  Replacements Replaces;
+  auto Err = Replaces.addAll({Replacement("x.h", 10, 0, "a"),
+                              Replacement("x.h", 0, 5, "b"),
+                              Replacement("x.h", 10, 0, "b")});
+  EXPECT_TRUE((bool)Err);
+  llvm::consumeError(std::move(Err));
+
+  Replaces.clear();
+  Err = Replaces.addAll({Replacement("x.h", 0, 5, "a"),
+                         Replacement("y.h", 10, 5, "b")});
+  EXPECT_TRUE((bool)Err);
+  llvm::consumeError(std::move(Err));
+}
+
 TEST_F(ReplacementTest, AddDuplicateReplacements) {
   FileID ID = Context.createInMemoryFile("input.cpp",
                                          "line1\nline2\nline3\nline4");
@@ -1717,5 +1778,36 @@ TEST_F(ApplyAtomicChangesTest, DoesNotDeleteInserts) {
             rewrite());
 }
 
+TEST_F(ApplyAtomicChangesTest, AppliesChangesInFiles) {
+  FileID ID1 = Context.createInMemoryFile("a.cc", "int a;");
+  FileID ID2 = Context.createInMemoryFile("b.cc", "int b;");
+  auto GetLoc = [&](FileID ID, unsigned Offset) {
+    return Context.Sources.getLocForStartOfFile(ID).getLocWithOffset(Offset);
+  };
+  Changes.emplace_back("a.cc", "key1");
+  ASSERT_TRUE(!Changes.back().replace(Context.Sources, GetLoc(ID1, 4), 1, "x"));
+  Changes.emplace_back("b.cc", "key2");
+  ASSERT_TRUE(
+      !Changes.back().replace(Context.Sources, GetLoc(ID2, 0), 3, "float"));
+  Changes.emplace_back("b.cc", "key3");
+  ASSERT_TRUE(!Changes.back().replace(Context.Sources, GetLoc(ID2, 4), 1, "y"));
+
+  llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> VFS(
+      new llvm::vfs::InMemoryFileSystem());
+  VFS->addFile("a.cc", 0, llvm::MemoryBuffer::getMemBuffer("int a;"));
+  VFS->addFile("b.cc", 0, llvm::MemoryBuffer::getMemBuffer("int b;"));
+  auto ChangedFiles = applyAtomicChangesInFiles(Changes, *VFS, Spec,
+                                                /*NumThreads=*/2);
+  ASSERT_TRUE((bool)ChangedFiles);
+  EXPECT_EQ(2u, ChangedFiles->size());
+  EXPECT_EQ("int x;", (*ChangedFiles)["a.cc"]);
+  EXPECT_EQ("float y;", (*ChangedFiles)["b.cc"]);
+
+  Changes.emplace_back("c.cc", "key4");
+  ChangedFiles = applyAtomicChangesInFiles(Changes, *VFS, Spec);
+  EXPECT_FALSE((bool)ChangedFiles);
+  llvm::consumeError(ChangedFiles.takeError());
+}
+
 } // end namespace tooling
 } // end namespace clang
@@ -702,6 +702,114 @@ TEST_F(LibclangReparseTest, PreprocessorSkippedRanges) {
   }
 }
 
+static unsigned long getResourceUsage(CXTranslationUnit TU,
+                                      CXTUResourceUsageKind Kind) {
+  unsigned long Amount = 0;
+  CXTUResourceUsage Usage = clang_getCXTUResourceUsage(TU);
+  for (unsigned I = 0; I != Usage.numEntries; ++I)
+    if (Usage.entries[I].kind == Kind)
+      Amount = Usage.entries[I].amount;
+  clang_disposeCXTUResourceUsage(Usage);
+  return Amount;
+}
+
+TEST_F(LibclangReparseTest, SharesPreamble) {
+  std::string Header = "header.h", Main = "main.cpp";
+  WriteFile(Header, "struct Foo { int bar; };\n");
+  WriteFile(Main, "#include \"header.h\"\n"
+                  "int main() { Foo foo; return foo.bar; }\n");
+  unsigned Flags = TUFlags | CXTranslationUnit_PrecompiledPreamble |
+                   CXTranslationUnit_CreatePreambleOnFirstParse;
+  clang_CXIndex_setGlobalOptions(Index, clang_CXIndex_getGlobalOptions(Index) |
+                                            CXGlobalOpt_SharePreambles);
+
+  ClangTU = clang_parseTranslationUnit(Index, Main.c_str(), nullptr, 0,
+                                       nullptr, 0, Flags);
+  ASSERT_TRUE(ClangTU);
+  EXPECT_EQ(1UL,
+            getResourceUsage(ClangTU, CXTUResourceUsage_PreambleShareCount));
+
+  // A second translation unit for the same file and options reuses the
+  // preamble of the first one.
+  CXTranslationUnit OtherTU = clang_parseTranslationUnit(
+      Index, Main.c_str(), nullptr, 0, nullptr, 0, Flags);
+  ASSERT_TRUE(OtherTU);
+  EXPECT_EQ(0U, clang_getNumDiagnostics(OtherTU));
+  EXPECT_EQ(2UL,
+            getResourceUsage(ClangTU, CXTUResourceUsage_PreambleShareCount));
+  EXPECT_EQ(2UL,
+            getResourceUsage(OtherTU, CXTUResourceUsage_PreambleShareCount));
+
+  clang_disposeTranslationUnit(OtherTU);
+  EXPECT_EQ(1UL,
+            getResourceUsage(ClangTU, CXTUResourceUsage_PreambleShareCount));
+
+  // Changing the header invalidates the shared preamble.
+  WriteFile(Header, "struct Foo { int bar; int baz; };\n");
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+  EXPECT_EQ(1UL,
+            getResourceUsage(ClangTU, CXTUResourceUsage_PreambleShareCount));
+}
+
+TEST_F(LibclangReparseTest, SharesPreambleOnlyWhenEnabled) {
+  std::string Header = "header.h", Main = "main.cpp";
+  WriteFile(Header, "struct Foo { int bar; };\n");
+  WriteFile(Main, "#include \"header.h\"\n"
+                  "int main() { Foo foo; return foo.bar; }\n");
+  unsigned Flags = TUFlags | CXTranslationUnit_PrecompiledPreamble |
+                   CXTranslationUnit_CreatePreambleOnFirstParse;
+
+  ClangTU = clang_parseTranslationUnit(Index, Main.c_str(), nullptr, 0,
+                                       nullptr, 0, Flags);
+  ASSERT_TRUE(ClangTU);
+  CXTranslationUnit OtherTU = clang_parseTranslationUnit(
+      Index, Main.c_str(), nullptr, 0, nullptr, 0, Flags);
+  ASSERT_TRUE(OtherTU);
+  EXPECT_EQ(1UL,
+            getResourceUsage(ClangTU, CXTUResourceUsage_PreambleShareCount));
+  EXPECT_EQ(1UL,
+            getResourceUsage(OtherTU, CXTUResourceUsage_PreambleShareCount));
+
+  clang_disposeTranslationUnit(OtherTU);
+}
+
+TEST_F(LibclangReparseTest, DoesNotSharePreambleBetweenMainFiles) {
+  std::string Header = "header.h", First = "first.cpp", Second = "second.cpp";
+  WriteFile(Header, "struct Foo { int bar; };\n");
+  WriteFile(First, "#include \"header.h\"\n"
+                   "int first() { Foo foo; return foo.bar; }\n");
+  WriteFile(Second, "#include \"header.h\"\n"
+                    "int second() { Foo foo; return foo.bar; }\n");
+  unsigned Flags = TUFlags | CXTranslationUnit_PrecompiledPreamble |
+                   CXTranslationUnit_CreatePreambleOnFirstParse |
+                   CXTranslationUnit_DetailedPreprocessingRecord;
+  clang_CXIndex_setGlobalOptions(Index, clang_CXIndex_getGlobalOptions(Index) |
+                                            CXGlobalOpt_SharePreambles);
+
+  ClangTU = clang_parseTranslationUnit(Index, First.c_str(), nullptr, 0,
+                                       nullptr, 0, Flags);
+  ASSERT_TRUE(ClangTU);
+
+  // The preprocessing record of a preamble points into its main file, so a
+  // main file with the same preamble still builds its own.
+  CXTranslationUnit SecondTU = clang_parseTranslationUnit(
+      Index, Second.c_str(), nullptr, 0, nullptr, 0, Flags);
+  ASSERT_TRUE(SecondTU);
+  EXPECT_EQ(1UL,
+            getResourceUsage(SecondTU, CXTUResourceUsage_PreambleShareCount));
+
+  CXFile SecondFile = clang_getFile(SecondTU, Second.c_str());
+  CXCursor Include = clang_getCursor(
+      SecondTU, clang_getLocation(SecondTU, SecondFile, 1, 2));
+  EXPECT_EQ(CXCursor_InclusionDirective, clang_getCursorKind(Include));
+  CXFile IncludeFile;
+  clang_getSpellingLocation(clang_getCursorLocation(Include), &IncludeFile,
+                            nullptr, nullptr, nullptr);
+  EXPECT_TRUE(clang_File_isEqual(SecondFile, IncludeFile));
+
+  clang_disposeTranslationUnit(SecondTU);
+}
+
 class LibclangSerializationTest : public LibclangParseTest {
 public:
   bool SaveAndLoadTU(const std::string &Filename) {